@@ -68,8 +68,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // hmm_cpp
-Rcpp::List hmm_cpp(std::vector<arma::mat> Xs, arma::vec weights, arma::rowvec delta_init, arma::mat mus_init, std::vector<arma::mat> Sigmas_init, arma::mat Gamma_init, std::vector<arma::mat> zetas_init, std::vector< arma::uvec > nonmissing, std::vector< arma::uvec > missingness_labels, std::vector< arma::uvec > nonmissing_features, double lambda, double tol, arma::uword maxiter, double uncollapse, bool verbose, bool supervised);
-RcppExport SEXP _communication_hmm_cpp(SEXP XsSEXP, SEXP weightsSEXP, SEXP delta_initSEXP, SEXP mus_initSEXP, SEXP Sigmas_initSEXP, SEXP Gamma_initSEXP, SEXP zetas_initSEXP, SEXP nonmissingSEXP, SEXP missingness_labelsSEXP, SEXP nonmissing_featuresSEXP, SEXP lambdaSEXP, SEXP tolSEXP, SEXP maxiterSEXP, SEXP uncollapseSEXP, SEXP verboseSEXP, SEXP supervisedSEXP) {
+Rcpp::List hmm_cpp(std::vector<arma::mat> Xs, arma::vec weights, arma::rowvec delta_init, arma::mat mus_init, std::vector<arma::mat> Sigmas_init, arma::mat Gamma_init, std::vector<arma::mat> zetas_init, std::vector< arma::uvec > nonmissing, std::vector< arma::uvec > missingness_labels, std::vector< arma::uvec > nonmissing_features, double lambda, double tol, arma::uword maxiter, double uncollapse, bool verbose, bool supervised, arma::uword nthreads, bool checkpoint, int return_posteriors, std::string covariance, Rcpp::Nullable<Rcpp::List> deltas_init);
+RcppExport SEXP _communication_hmm_cpp(SEXP XsSEXP, SEXP weightsSEXP, SEXP delta_initSEXP, SEXP mus_initSEXP, SEXP Sigmas_initSEXP, SEXP Gamma_initSEXP, SEXP zetas_initSEXP, SEXP nonmissingSEXP, SEXP missingness_labelsSEXP, SEXP nonmissing_featuresSEXP, SEXP lambdaSEXP, SEXP tolSEXP, SEXP maxiterSEXP, SEXP uncollapseSEXP, SEXP verboseSEXP, SEXP supervisedSEXP, SEXP nthreadsSEXP, SEXP checkpointSEXP, SEXP return_posteriorsSEXP, SEXP covarianceSEXP, SEXP deltas_initSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -89,13 +89,18 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type uncollapse(uncollapseSEXP);
     Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
     Rcpp::traits::input_parameter< bool >::type supervised(supervisedSEXP);
-    rcpp_result_gen = Rcpp::wrap(hmm_cpp(Xs, weights, delta_init, mus_init, Sigmas_init, Gamma_init, zetas_init, nonmissing, missingness_labels, nonmissing_features, lambda, tol, maxiter, uncollapse, verbose, supervised));
+    Rcpp::traits::input_parameter< arma::uword >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type checkpoint(checkpointSEXP);
+    Rcpp::traits::input_parameter< int >::type return_posteriors(return_posteriorsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type covariance(covarianceSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type deltas_init(deltas_initSEXP);
+    rcpp_result_gen = Rcpp::wrap(hmm_cpp(Xs, weights, delta_init, mus_init, Sigmas_init, Gamma_init, zetas_init, nonmissing, missingness_labels, nonmissing_features, lambda, tol, maxiter, uncollapse, verbose, supervised, nthreads, checkpoint, return_posteriors, covariance, deltas_init));
     return rcpp_result_gen;
 END_RCPP
 }
 // hmm_autocorr_cpp
-Rcpp::List hmm_autocorr_cpp(std::vector<arma::mat> Xs, arma::vec weights, arma::rowvec delta_init, arma::mat mus_init, std::vector<arma::mat> Sigmas_init, arma::mat Gamma_init, std::vector<arma::mat> zetas_init, arma::uvec labels_t, arma::uvec labels_y, double lambda, double tol, arma::uword maxiter, double uncollapse, bool verbose, bool supervised);
-RcppExport SEXP _communication_hmm_autocorr_cpp(SEXP XsSEXP, SEXP weightsSEXP, SEXP delta_initSEXP, SEXP mus_initSEXP, SEXP Sigmas_initSEXP, SEXP Gamma_initSEXP, SEXP zetas_initSEXP, SEXP labels_tSEXP, SEXP labels_ySEXP, SEXP lambdaSEXP, SEXP tolSEXP, SEXP maxiterSEXP, SEXP uncollapseSEXP, SEXP verboseSEXP, SEXP supervisedSEXP) {
+Rcpp::List hmm_autocorr_cpp(std::vector<arma::mat> Xs, arma::vec weights, arma::rowvec delta_init, arma::mat mus_init, std::vector<arma::mat> Sigmas_init, arma::mat Gamma_init, std::vector<arma::mat> zetas_init, arma::uvec labels_t, arma::uvec labels_y, double lambda, double tol, arma::uword maxiter, double uncollapse, bool verbose, bool supervised, arma::uword nthreads, std::string covariance);
+RcppExport SEXP _communication_hmm_autocorr_cpp(SEXP XsSEXP, SEXP weightsSEXP, SEXP delta_initSEXP, SEXP mus_initSEXP, SEXP Sigmas_initSEXP, SEXP Gamma_initSEXP, SEXP zetas_initSEXP, SEXP labels_tSEXP, SEXP labels_ySEXP, SEXP lambdaSEXP, SEXP tolSEXP, SEXP maxiterSEXP, SEXP uncollapseSEXP, SEXP verboseSEXP, SEXP supervisedSEXP, SEXP nthreadsSEXP, SEXP covarianceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -114,13 +119,78 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type uncollapse(uncollapseSEXP);
     Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
     Rcpp::traits::input_parameter< bool >::type supervised(supervisedSEXP);
-    rcpp_result_gen = Rcpp::wrap(hmm_autocorr_cpp(Xs, weights, delta_init, mus_init, Sigmas_init, Gamma_init, zetas_init, labels_t, labels_y, lambda, tol, maxiter, uncollapse, verbose, supervised));
+    Rcpp::traits::input_parameter< arma::uword >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type covariance(covarianceSEXP);
+    rcpp_result_gen = Rcpp::wrap(hmm_autocorr_cpp(Xs, weights, delta_init, mus_init, Sigmas_init, Gamma_init, zetas_init, labels_t, labels_y, lambda, tol, maxiter, uncollapse, verbose, supervised, nthreads, covariance));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hmm_restarts_cpp
+Rcpp::List hmm_restarts_cpp(std::vector<arma::mat> Xs, arma::vec weights, arma::uword K, std::vector< arma::uvec > nonmissing, std::vector< arma::uvec > missingness_labels, std::vector< arma::uvec > nonmissing_features, arma::uword restarts, int seed, double lambda, double tol, arma::uword maxiter, double margin, arma::uword min_iter, double uncollapse, bool verbose, arma::uword nthreads, std::string covariance);
+RcppExport SEXP _communication_hmm_restarts_cpp(SEXP XsSEXP, SEXP weightsSEXP, SEXP KSEXP, SEXP nonmissingSEXP, SEXP missingness_labelsSEXP, SEXP nonmissing_featuresSEXP, SEXP restartsSEXP, SEXP seedSEXP, SEXP lambdaSEXP, SEXP tolSEXP, SEXP maxiterSEXP, SEXP marginSEXP, SEXP min_iterSEXP, SEXP uncollapseSEXP, SEXP verboseSEXP, SEXP nthreadsSEXP, SEXP covarianceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::vector<arma::mat> >::type Xs(XsSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type K(KSEXP);
+    Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type nonmissing(nonmissingSEXP);
+    Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type missingness_labels(missingness_labelsSEXP);
+    Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type nonmissing_features(nonmissing_featuresSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type restarts(restartsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type maxiter(maxiterSEXP);
+    Rcpp::traits::input_parameter< double >::type margin(marginSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type min_iter(min_iterSEXP);
+    Rcpp::traits::input_parameter< double >::type uncollapse(uncollapseSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type nthreads(nthreadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type covariance(covarianceSEXP);
+    rcpp_result_gen = Rcpp::wrap(hmm_restarts_cpp(Xs, weights, K, nonmissing, missingness_labels, nonmissing_features, restarts, seed, lambda, tol, maxiter, margin, min_iter, uncollapse, verbose, nthreads, covariance));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_htk_cpp
+void write_htk_cpp(arma::mat X, std::string path, double period);
+RcppExport SEXP _communication_write_htk_cpp(SEXP XSEXP, SEXP pathSEXP, SEXP periodSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::mat >::type X(XSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< double >::type period(periodSEXP);
+    write_htk_cpp(X, path, period);
+    return R_NilValue;
+END_RCPP
+}
+// hmm_online_cpp
+Rcpp::List hmm_online_cpp(std::vector<std::string> files, arma::vec weights, arma::rowvec delta_init, arma::mat mus_init, std::vector<arma::mat> Sigmas_init, arma::mat Gamma_init, std::vector< arma::uvec > nonmissing_features, double lambda, arma::uword batch_size, arma::uword epochs, double kappa, bool shuffle, bool verbose, arma::uword nthreads);
+RcppExport SEXP _communication_hmm_online_cpp(SEXP filesSEXP, SEXP weightsSEXP, SEXP delta_initSEXP, SEXP mus_initSEXP, SEXP Sigmas_initSEXP, SEXP Gamma_initSEXP, SEXP nonmissing_featuresSEXP, SEXP lambdaSEXP, SEXP batch_sizeSEXP, SEXP epochsSEXP, SEXP kappaSEXP, SEXP shuffleSEXP, SEXP verboseSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type files(filesSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< arma::rowvec >::type delta_init(delta_initSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type mus_init(mus_initSEXP);
+    Rcpp::traits::input_parameter< std::vector<arma::mat> >::type Sigmas_init(Sigmas_initSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type Gamma_init(Gamma_initSEXP);
+    Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type nonmissing_features(nonmissing_featuresSEXP);
+    Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type batch_size(batch_sizeSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type epochs(epochsSEXP);
+    Rcpp::traits::input_parameter< double >::type kappa(kappaSEXP);
+    Rcpp::traits::input_parameter< bool >::type shuffle(shuffleSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(hmm_online_cpp(files, weights, delta_init, mus_init, Sigmas_init, Gamma_init, nonmissing_features, lambda, batch_size, epochs, kappa, shuffle, verbose, nthreads));
     return rcpp_result_gen;
 END_RCPP
 }
 // llh_cpp
-Rcpp::List llh_cpp(std::vector<arma::mat> Xs, arma::rowvec delta, arma::mat mus, std::vector<arma::mat> Sigmas_in, arma::mat Gamma, std::vector< arma::uvec > nonmissing, std::vector< arma::uvec > missingness_labels, std::vector< arma::uvec > nonmissing_features, double lambda, bool verbose);
-RcppExport SEXP _communication_llh_cpp(SEXP XsSEXP, SEXP deltaSEXP, SEXP musSEXP, SEXP Sigmas_inSEXP, SEXP GammaSEXP, SEXP nonmissingSEXP, SEXP missingness_labelsSEXP, SEXP nonmissing_featuresSEXP, SEXP lambdaSEXP, SEXP verboseSEXP) {
+Rcpp::List llh_cpp(std::vector<arma::mat> Xs, arma::rowvec delta, arma::mat mus, std::vector<arma::mat> Sigmas_in, arma::mat Gamma, std::vector< arma::uvec > nonmissing, std::vector< arma::uvec > missingness_labels, std::vector< arma::uvec > nonmissing_features, double lambda, bool verbose, std::string covariance);
+RcppExport SEXP _communication_llh_cpp(SEXP XsSEXP, SEXP deltaSEXP, SEXP musSEXP, SEXP Sigmas_inSEXP, SEXP GammaSEXP, SEXP nonmissingSEXP, SEXP missingness_labelsSEXP, SEXP nonmissing_featuresSEXP, SEXP lambdaSEXP, SEXP verboseSEXP, SEXP covarianceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -134,13 +204,14 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type nonmissing_features(nonmissing_featuresSEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
     Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
-    rcpp_result_gen = Rcpp::wrap(llh_cpp(Xs, delta, mus, Sigmas_in, Gamma, nonmissing, missingness_labels, nonmissing_features, lambda, verbose));
+    Rcpp::traits::input_parameter< std::string >::type covariance(covarianceSEXP);
+    rcpp_result_gen = Rcpp::wrap(llh_cpp(Xs, delta, mus, Sigmas_in, Gamma, nonmissing, missingness_labels, nonmissing_features, lambda, verbose, covariance));
     return rcpp_result_gen;
 END_RCPP
 }
 // lstateprobs_cpp
-Rcpp::List lstateprobs_cpp(std::vector<arma::mat> Xs, arma::mat mus, std::vector<arma::mat> Sigmas_in, std::vector< arma::uvec > nonmissing, std::vector< arma::uvec > missingness_labels, std::vector< arma::uvec > nonmissing_features, double lambda);
-RcppExport SEXP _communication_lstateprobs_cpp(SEXP XsSEXP, SEXP musSEXP, SEXP Sigmas_inSEXP, SEXP nonmissingSEXP, SEXP missingness_labelsSEXP, SEXP nonmissing_featuresSEXP, SEXP lambdaSEXP) {
+Rcpp::List lstateprobs_cpp(std::vector<arma::mat> Xs, arma::mat mus, std::vector<arma::mat> Sigmas_in, std::vector< arma::uvec > nonmissing, std::vector< arma::uvec > missingness_labels, std::vector< arma::uvec > nonmissing_features, double lambda, std::string covariance);
+RcppExport SEXP _communication_lstateprobs_cpp(SEXP XsSEXP, SEXP musSEXP, SEXP Sigmas_inSEXP, SEXP nonmissingSEXP, SEXP missingness_labelsSEXP, SEXP nonmissing_featuresSEXP, SEXP lambdaSEXP, SEXP covarianceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -151,7 +222,8 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type missingness_labels(missingness_labelsSEXP);
     Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type nonmissing_features(nonmissing_featuresSEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
-    rcpp_result_gen = Rcpp::wrap(lstateprobs_cpp(Xs, mus, Sigmas_in, nonmissing, missingness_labels, nonmissing_features, lambda));
+    Rcpp::traits::input_parameter< std::string >::type covariance(covarianceSEXP);
+    rcpp_result_gen = Rcpp::wrap(lstateprobs_cpp(Xs, mus, Sigmas_in, nonmissing, missingness_labels, nonmissing_features, lambda, covariance));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -168,6 +240,66 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// viterbi_stream_cpp
+SEXP viterbi_stream_cpp(arma::rowvec delta, arma::mat Gamma, arma::uword lag);
+RcppExport SEXP _communication_viterbi_stream_cpp(SEXP deltaSEXP, SEXP GammaSEXP, SEXP lagSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::rowvec >::type delta(deltaSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type Gamma(GammaSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type lag(lagSEXP);
+    rcpp_result_gen = Rcpp::wrap(viterbi_stream_cpp(delta, Gamma, lag));
+    return rcpp_result_gen;
+END_RCPP
+}
+// viterbi_stream_push_cpp
+std::vector<arma::uword> viterbi_stream_push_cpp(SEXP decoder, arma::mat lstateprobs);
+RcppExport SEXP _communication_viterbi_stream_push_cpp(SEXP decoderSEXP, SEXP lstateprobsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type decoder(decoderSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type lstateprobs(lstateprobsSEXP);
+    rcpp_result_gen = Rcpp::wrap(viterbi_stream_push_cpp(decoder, lstateprobs));
+    return rcpp_result_gen;
+END_RCPP
+}
+// viterbi_stream_flush_cpp
+std::vector<arma::uword> viterbi_stream_flush_cpp(SEXP decoder);
+RcppExport SEXP _communication_viterbi_stream_flush_cpp(SEXP decoderSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type decoder(decoderSEXP);
+    rcpp_result_gen = Rcpp::wrap(viterbi_stream_flush_cpp(decoder));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hmm_score_files_cpp
+Rcpp::List hmm_score_files_cpp(std::vector<std::string> audio_files_in, std::string config_string_in, arma::rowvec delta, arma::mat mus, std::vector<arma::mat> Sigmas_in, arma::mat Gamma, std::vector< arma::uvec > nonmissing_features, arma::rowvec center, arma::rowvec scale, double lambda, std::string covariance, bool decode, arma::uword lag, int nWorkers);
+RcppExport SEXP _communication_hmm_score_files_cpp(SEXP audio_files_inSEXP, SEXP config_string_inSEXP, SEXP deltaSEXP, SEXP musSEXP, SEXP Sigmas_inSEXP, SEXP GammaSEXP, SEXP nonmissing_featuresSEXP, SEXP centerSEXP, SEXP scaleSEXP, SEXP lambdaSEXP, SEXP covarianceSEXP, SEXP decodeSEXP, SEXP lagSEXP, SEXP nWorkersSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type audio_files_in(audio_files_inSEXP);
+    Rcpp::traits::input_parameter< std::string >::type config_string_in(config_string_inSEXP);
+    Rcpp::traits::input_parameter< arma::rowvec >::type delta(deltaSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type mus(musSEXP);
+    Rcpp::traits::input_parameter< std::vector<arma::mat> >::type Sigmas_in(Sigmas_inSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type Gamma(GammaSEXP);
+    Rcpp::traits::input_parameter< std::vector< arma::uvec > >::type nonmissing_features(nonmissing_featuresSEXP);
+    Rcpp::traits::input_parameter< arma::rowvec >::type center(centerSEXP);
+    Rcpp::traits::input_parameter< arma::rowvec >::type scale(scaleSEXP);
+    Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< std::string >::type covariance(covarianceSEXP);
+    Rcpp::traits::input_parameter< bool >::type decode(decodeSEXP);
+    Rcpp::traits::input_parameter< arma::uword >::type lag(lagSEXP);
+    Rcpp::traits::input_parameter< int >::type nWorkers(nWorkersSEXP);
+    rcpp_result_gen = Rcpp::wrap(hmm_score_files_cpp(audio_files_in, config_string_in, delta, mus, Sigmas_in, Gamma, nonmissing_features, center, scale, lambda, covariance, decode, lag, nWorkers));
+    return rcpp_result_gen;
+END_RCPP
+}
 // wavToMp3
 void wavToMp3(std::string wav_file_in, std::string mp3_file_out);
 RcppExport SEXP _communication_wavToMp3(SEXP wav_file_inSEXP, SEXP mp3_file_outSEXP) {
@@ -248,14 +380,29 @@ BEGIN_RCPP
 END_RCPP
 }
 // rcpp_openSmileGetFeatures
-SEXP rcpp_openSmileGetFeatures(std::vector<std::string> audio_files_in, std::string config_string_in);
-RcppExport SEXP _communication_rcpp_openSmileGetFeatures(SEXP audio_files_inSEXP, SEXP config_string_inSEXP) {
+SEXP rcpp_openSmileGetFeatures(std::vector<std::string> audio_files_in, std::string config_string_in, int nWorkers, int nChunks);
+RcppExport SEXP _communication_rcpp_openSmileGetFeatures(SEXP audio_files_inSEXP, SEXP config_string_inSEXP, SEXP nWorkersSEXP, SEXP nChunksSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< std::vector<std::string> >::type audio_files_in(audio_files_inSEXP);
     Rcpp::traits::input_parameter< std::string >::type config_string_in(config_string_inSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_openSmileGetFeatures(audio_files_in, config_string_in));
+    Rcpp::traits::input_parameter< int >::type nWorkers(nWorkersSEXP);
+    Rcpp::traits::input_parameter< int >::type nChunks(nChunksSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_openSmileGetFeatures(audio_files_in, config_string_in, nWorkers, nChunks));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_openSmileGetFeatures_RawData
+SEXP rcpp_openSmileGetFeatures_RawData(std::vector<std::string> audio_files_in, std::string config_string_in, int nWorkers);
+RcppExport SEXP _communication_rcpp_openSmileGetFeatures_RawData(SEXP audio_files_inSEXP, SEXP config_string_inSEXP, SEXP nWorkersSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::vector<std::string> >::type audio_files_in(audio_files_inSEXP);
+    Rcpp::traits::input_parameter< std::string >::type config_string_in(config_string_inSEXP);
+    Rcpp::traits::input_parameter< int >::type nWorkers(nWorkersSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_openSmileGetFeatures_RawData(audio_files_in, config_string_in, nWorkers));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -272,14 +419,15 @@ BEGIN_RCPP
 END_RCPP
 }
 // rcpp_openSmileGetBorderFrames
-SEXP rcpp_openSmileGetBorderFrames(std::vector<std::string> audio_files_in, std::string config_string_in);
-RcppExport SEXP _communication_rcpp_openSmileGetBorderFrames(SEXP audio_files_inSEXP, SEXP config_string_inSEXP) {
+SEXP rcpp_openSmileGetBorderFrames(std::vector<std::string> audio_files_in, std::string config_string_in, int nWorkers);
+RcppExport SEXP _communication_rcpp_openSmileGetBorderFrames(SEXP audio_files_inSEXP, SEXP config_string_inSEXP, SEXP nWorkersSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< std::vector<std::string> >::type audio_files_in(audio_files_inSEXP);
     Rcpp::traits::input_parameter< std::string >::type config_string_in(config_string_inSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_openSmileGetBorderFrames(audio_files_in, config_string_in));
+    Rcpp::traits::input_parameter< int >::type nWorkers(nWorkersSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_openSmileGetBorderFrames(audio_files_in, config_string_in, nWorkers));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -307,14 +455,15 @@ BEGIN_RCPP
 END_RCPP
 }
 // rcpp_openSmileGetFeatures_Turns
-SEXP rcpp_openSmileGetFeatures_Turns(std::vector<std::string> audio_files_in, std::string config_string_in);
-RcppExport SEXP _communication_rcpp_openSmileGetFeatures_Turns(SEXP audio_files_inSEXP, SEXP config_string_inSEXP) {
+SEXP rcpp_openSmileGetFeatures_Turns(std::vector<std::string> audio_files_in, std::string config_string_in, int nWorkers);
+RcppExport SEXP _communication_rcpp_openSmileGetFeatures_Turns(SEXP audio_files_inSEXP, SEXP config_string_inSEXP, SEXP nWorkersSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< std::vector<std::string> >::type audio_files_in(audio_files_inSEXP);
     Rcpp::traits::input_parameter< std::string >::type config_string_in(config_string_inSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_openSmileGetFeatures_Turns(audio_files_in, config_string_in));
+    Rcpp::traits::input_parameter< int >::type nWorkers(nWorkersSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_openSmileGetFeatures_Turns(audio_files_in, config_string_in, nWorkers));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -330,17 +479,80 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// test_rcpp_configManagerIndex
+SEXP test_rcpp_configManagerIndex();
+RcppExport SEXP _communication_test_rcpp_configManagerIndex() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(test_rcpp_configManagerIndex());
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_rcpp_loggerThreads
+void test_rcpp_loggerThreads(std::string logfile, int nThreads, int nMessages);
+RcppExport SEXP _communication_test_rcpp_loggerThreads(SEXP logfileSEXP, SEXP nThreadsSEXP, SEXP nMessagesSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type logfile(logfileSEXP);
+    Rcpp::traits::input_parameter< int >::type nThreads(nThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type nMessages(nMessagesSEXP);
+    test_rcpp_loggerThreads(logfile, nThreads, nMessages);
+    return R_NilValue;
+END_RCPP
+}
+// test_rcpp_pcmConvertSimd
+Rcpp::List test_rcpp_pcmConvertSimd();
+RcppExport SEXP _communication_test_rcpp_pcmConvertSimd() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(test_rcpp_pcmConvertSimd());
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_rcpp_fftBatch
+Rcpp::List test_rcpp_fftBatch();
+RcppExport SEXP _communication_test_rcpp_fftBatch() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(test_rcpp_fftBatch());
+    return rcpp_result_gen;
+END_RCPP
+}
+// test_rcpp_dataMemoryThreads
+Rcpp::List test_rcpp_dataMemoryThreads(int lockFree, int noHang, int nReaders, int nFrames);
+RcppExport SEXP _communication_test_rcpp_dataMemoryThreads(SEXP lockFreeSEXP, SEXP noHangSEXP, SEXP nReadersSEXP, SEXP nFramesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type lockFree(lockFreeSEXP);
+    Rcpp::traits::input_parameter< int >::type noHang(noHangSEXP);
+    Rcpp::traits::input_parameter< int >::type nReaders(nReadersSEXP);
+    Rcpp::traits::input_parameter< int >::type nFrames(nFramesSEXP);
+    rcpp_result_gen = Rcpp::wrap(test_rcpp_dataMemoryThreads(lockFree, noHang, nReaders, nFrames));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
     {"_communication_dmvnorm_cens", (DL_FUNC) &_communication_dmvnorm_cens, 7},
     {"_communication_dmvnorm_cond", (DL_FUNC) &_communication_dmvnorm_cond, 7},
     {"_communication_forward", (DL_FUNC) &_communication_forward, 4},
     {"_communication_backward", (DL_FUNC) &_communication_backward, 3},
-    {"_communication_hmm_cpp", (DL_FUNC) &_communication_hmm_cpp, 16},
-    {"_communication_hmm_autocorr_cpp", (DL_FUNC) &_communication_hmm_autocorr_cpp, 15},
-    {"_communication_llh_cpp", (DL_FUNC) &_communication_llh_cpp, 10},
-    {"_communication_lstateprobs_cpp", (DL_FUNC) &_communication_lstateprobs_cpp, 7},
+    {"_communication_hmm_cpp", (DL_FUNC) &_communication_hmm_cpp, 21},
+    {"_communication_hmm_autocorr_cpp", (DL_FUNC) &_communication_hmm_autocorr_cpp, 17},
+    {"_communication_hmm_restarts_cpp", (DL_FUNC) &_communication_hmm_restarts_cpp, 17},
+    {"_communication_write_htk_cpp", (DL_FUNC) &_communication_write_htk_cpp, 3},
+    {"_communication_hmm_online_cpp", (DL_FUNC) &_communication_hmm_online_cpp, 14},
+    {"_communication_llh_cpp", (DL_FUNC) &_communication_llh_cpp, 11},
+    {"_communication_lstateprobs_cpp", (DL_FUNC) &_communication_lstateprobs_cpp, 8},
     {"_communication_viterbi_cpp", (DL_FUNC) &_communication_viterbi_cpp, 3},
+    {"_communication_viterbi_stream_cpp", (DL_FUNC) &_communication_viterbi_stream_cpp, 3},
+    {"_communication_viterbi_stream_push_cpp", (DL_FUNC) &_communication_viterbi_stream_push_cpp, 2},
+    {"_communication_viterbi_stream_flush_cpp", (DL_FUNC) &_communication_viterbi_stream_flush_cpp, 1},
+    {"_communication_hmm_score_files_cpp", (DL_FUNC) &_communication_hmm_score_files_cpp, 14},
     {"_communication_wavToMp3", (DL_FUNC) &_communication_wavToMp3, 2},
     {"_communication_mp3ToWav", (DL_FUNC) &_communication_mp3ToWav, 2},
     {"_communication_rcpp_parseWavFile", (DL_FUNC) &_communication_rcpp_parseWavFile, 1},
@@ -348,13 +560,19 @@ static const R_CallMethodDef CallEntries[] = {
     {"_communication_test_rcpp_playWavFile", (DL_FUNC) &_communication_test_rcpp_playWavFile, 1},
     {"_communication_rcpp_writeWavFile", (DL_FUNC) &_communication_rcpp_writeWavFile, 3},
     {"_communication_test_rcpp_writeWavFile", (DL_FUNC) &_communication_test_rcpp_writeWavFile, 2},
-    {"_communication_rcpp_openSmileGetFeatures", (DL_FUNC) &_communication_rcpp_openSmileGetFeatures, 2},
+    {"_communication_rcpp_openSmileGetFeatures", (DL_FUNC) &_communication_rcpp_openSmileGetFeatures, 4},
+    {"_communication_rcpp_openSmileGetFeatures_RawData", (DL_FUNC) &_communication_rcpp_openSmileGetFeatures_RawData, 3},
     {"_communication_test_rcpp_openSmileGetFeatures", (DL_FUNC) &_communication_test_rcpp_openSmileGetFeatures, 2},
-    {"_communication_rcpp_openSmileGetBorderFrames", (DL_FUNC) &_communication_rcpp_openSmileGetBorderFrames, 2},
+    {"_communication_rcpp_openSmileGetBorderFrames", (DL_FUNC) &_communication_rcpp_openSmileGetBorderFrames, 3},
     {"_communication_test_rcpp_openSmileGetBorderFrames", (DL_FUNC) &_communication_test_rcpp_openSmileGetBorderFrames, 2},
     {"_communication_rcpp_openSmileMain", (DL_FUNC) &_communication_rcpp_openSmileMain, 1},
-    {"_communication_rcpp_openSmileGetFeatures_Turns", (DL_FUNC) &_communication_rcpp_openSmileGetFeatures_Turns, 2},
+    {"_communication_rcpp_openSmileGetFeatures_Turns", (DL_FUNC) &_communication_rcpp_openSmileGetFeatures_Turns, 3},
     {"_communication_test_rcpp_openSmileGetFeatures_Turns", (DL_FUNC) &_communication_test_rcpp_openSmileGetFeatures_Turns, 2},
+    {"_communication_test_rcpp_configManagerIndex", (DL_FUNC) &_communication_test_rcpp_configManagerIndex, 0},
+    {"_communication_test_rcpp_loggerThreads", (DL_FUNC) &_communication_test_rcpp_loggerThreads, 3},
+    {"_communication_test_rcpp_pcmConvertSimd", (DL_FUNC) &_communication_test_rcpp_pcmConvertSimd, 0},
+    {"_communication_test_rcpp_fftBatch", (DL_FUNC) &_communication_test_rcpp_fftBatch, 0},
+    {"_communication_test_rcpp_dataMemoryThreads", (DL_FUNC) &_communication_test_rcpp_dataMemoryThreads, 4},
     {NULL, NULL, 0}
 };
 
@@ -10,29 +10,48 @@ using namespace Rcpp;
 
 #define MODULE "CrcppDataBase"
 
+std::mutex CRcppDataBase::setupMtx;
 
 CRcppDataBase::CRcppDataBase():
   modeWork {cComponentManager::NoRccp}
 { 
 }
 
-void CRcppDataBase::getData1file()
+void CRcppDataBase::prepare1file(cComponentManager *cMan, int iFile)
 {
   
 }
 
-int CRcppDataBase::work1file(std::vector<std::string> arguments)
+void CRcppDataBase::getData1file(cComponentManager *cMan, int iFile)
 {
-  int argc = arguments.size() + 1;
-  char ** argv = new char*[argc];
+  
+}
+
+void CRcppDataBase::Pipeline::close()
+{
+  std::lock_guard<std::mutex> setupLock(setupMtx);
+  /* it is important that configManager is deleted BEFORE componentManger! 
+   (since component Manger unregisters plugin Dlls, which might have allocated configTypes, etc.) */
+  delete configManager;
+  configManager = nullptr;
+  delete cMan;
+  cMan = nullptr;
+  delete cmdline;
+  cmdline = nullptr;
+}
+
+int CRcppDataBase::openPipeline(Pipeline & pipeline, std::vector<std::string> arguments, const std::string & configString)
+{
+  pipeline.close();
+  pipeline.arguments = arguments;
+  pipeline.argv.clear();
   const char * c_argv_0 = "NoExe";
-  argv[0] = const_cast<char *>(c_argv_0);
-  for(int i = 0; i<arguments.size(); i++)
-  {
-    argv[i+1] = new char[arguments[i].length() + 1];
-    strcpy(argv[i+1], arguments[i].c_str());    
-  }
+  pipeline.argv.push_back(c_argv_0);
+  for(int i = 0; i<pipeline.arguments.size(); i++)
+    pipeline.argv.push_back(pipeline.arguments[i].c_str());
+  int argc = pipeline.argv.size();
   try {
+    std::unique_lock<std::mutex> setupLock(setupMtx);
     
     smileCommon_fixLocaleEnUs();
     
@@ -42,7 +61,8 @@ int CRcppDataBase::work1file(std::vector<std::string> arguments)
     
     
     // commandline parser:
-    cCommandlineParser cmdline(argc,const_cast<const char **>(argv));
+    pipeline.cmdline = new cCommandlineParser(argc, pipeline.argv.data());
+    cCommandlineParser & cmdline = *pipeline.cmdline;
     cmdline.addStr( "configfile", 'C', "Path to openSMILE config file", "smile.conf" );
     cmdline.addInt( "loglevel", 'l', "Verbosity level (0-9)", 2 );
 #ifdef DEBUG
@@ -56,7 +76,7 @@ int CRcppDataBase::work1file(std::vector<std::string> arguments)
     cmdline.addBoolean( "cfgFileTemplate", 0, "Print a complete template config file for a configuration containing the components specified in a comma separated string as argument to the 'configDflt' option", 0 );
     cmdline.addBoolean( "cfgFileDescriptions", 0, "Include description in config file templates.", 0 );
     cmdline.addBoolean( "ccmdHelp", 'c', "Show custom commandline option help (those specified in config file)", 0 );
-    cmdline.addStr( "logfile", 0, "set log file", "smile.log" );
+    cmdline.addStr( "logfile", 0, "set log file (messages are only written to a log file if this option is given)", "smile.log" );
     cmdline.addBoolean( "nologfile", 0, "don't write to a log file (e.g. on a read-only filesystem)", 0 );
     cmdline.addBoolean( "noconsoleoutput", 0, "don't output any messages to the console (log file is not affected by this option)", 0 );
     cmdline.addBoolean( "appendLogfile", 0, "append log messages to an existing logfile instead of overwriting the logfile at every start", 0 );
@@ -68,17 +88,28 @@ int CRcppDataBase::work1file(std::vector<std::string> arguments)
     }
     if (argc <= 1) {
       Rprintf("\nNo commandline options were given.\n Please run ' SMILExtract -h ' to see some usage information!\n\n");
+      setupLock.unlock();
+      pipeline.close();
       return EXIT_ERROR;
     }
     
-    if (help==1) { return EXIT_ERROR; }
+    if (help==1) { 
+      setupLock.unlock();
+      pipeline.close();
+      return EXIT_ERROR; 
+    }
     
-    if (cmdline.getBoolean("nologfile")) {
+    // logging is opt-in: a log file is only written with -logfile, and without -l only
+    // warnings, errors and the important (level 0) messages reach the console
+    if (cmdline.getBoolean("nologfile") || !cmdline.isSet("logfile")) {
       LOGGER.setLogFile((const char *)nullptr,0,!(cmdline.getBoolean("noconsoleoutput")));
     } else {
       LOGGER.setLogFile(cmdline.getStr("logfile"),cmdline.getBoolean("appendLogfile"),!(cmdline.getBoolean("noconsoleoutput")));
     }
     LOGGER.setLogLevel(cmdline.getInt("loglevel"));
+    if (!cmdline.isSet("loglevel")) {
+      LOGGER.setLogLevel(LOG_MESSAGE, 0);
+    }
     SMILE_MSG(2,"openSMILE starting!");
     
 #ifdef DEBUG  // ??
@@ -86,13 +117,16 @@ int CRcppDataBase::work1file(std::vector<std::string> arguments)
       LOGGER.setLogLevel(LOG_DEBUG, 0);
 #endif
     
-    SMILE_MSG(2,"config file is: %s",cmdline.getStr("configfile"));
+    if (configString.empty())
+      SMILE_MSG(2,"config file is: %s",cmdline.getStr("configfile"));
     
     
     // create configManager:
-    cConfigManager *configManager = new cConfigManager(&cmdline);
+    pipeline.configManager = new cConfigManager(&cmdline);
+    cConfigManager *configManager = pipeline.configManager;
     
-    cComponentManager *cMan = new cComponentManager(configManager, modeWork, componentlist);
+    pipeline.cMan = new cComponentManager(configManager, modeWork, componentlist);
+    cComponentManager *cMan = pipeline.cMan;
     
     
     const char *selStr=nullptr;
@@ -122,18 +156,21 @@ int CRcppDataBase::work1file(std::vector<std::string> arguments)
     }
     
     if (help==1) {
-      delete configManager;
-      delete cMan;
+      setupLock.unlock();
+      pipeline.close();
       return EXIT_ERROR; 
     }
     
     
     // TODO: read config here and print ccmdHelp...
-    // add the file config reader:
+    // add the file config reader (or parse the config string given by R, no temporary file needed):
     try{ 
-      configManager->addReader( new cFileConfigReader( cmdline.getStr("configfile"), -1, &cmdline) );
+      const char *configText = configString.empty() ? nullptr : configString.c_str();
+      configManager->addReader( new cFileConfigReader( cmdline.getStr("configfile"), -1, &cmdline, configText) );
       configManager->readConfig();
     } catch (cConfigException *cc) {
+      setupLock.unlock();
+      pipeline.close();
       return EXIT_ERROR;
     }
     
@@ -141,31 +178,76 @@ int CRcppDataBase::work1file(std::vector<std::string> arguments)
     cmdline.doParse(1,0); // warn if unknown options are detected on the commandline
     if (cmdline.getBoolean("ccmdHelp")) {
       cmdline.showUsage();
-      delete configManager;
-      delete cMan;
+      setupLock.unlock();
+      pipeline.close();
       return EXIT_ERROR;
     }
     
+  } catch(cSMILException *c) { 
+    // free exception ?? 
+    pipeline.close();
+    LOGGER.flush();
+    return EXIT_ERROR; 
+  } 
+  
+  LOGGER.flush();
+  return EXIT_SUCCESS;  
+}
+
+int CRcppDataBase::run1file(Pipeline & pipeline, const std::string & inputFile, int iFile)
+{
+  if (!pipeline.isOpen())
+    return EXIT_ERROR;
+  cComponentManager *cMan = pipeline.cMan;
+  try {
+    std::unique_lock<std::mutex> setupLock(setupMtx);
+    
+    /* point the config at the next input file: only the instance values are resolved again,
+     the config text and the component types stay as they are */
+    if (!inputFile.empty()) {
+      const char *currentFile = pipeline.cmdline->getStr("I");
+      if (nullptr == currentFile || inputFile != currentFile) {
+        if (!pipeline.cmdline->setStr("I", inputFile.c_str())) {
+          SMILE_ERR(1,"the config has no input file option (-I), cannot set input file '%s'",inputFile.c_str());
+          return EXIT_ERROR;
+        }
+        pipeline.configManager->readConfig();
+      }
+    }
+    
     /* create all instances specified in the config file */
+    prepare1file(cMan, iFile);
     cMan->createInstances(0); // 0 = do not read config (we already did that above..)
+    setupLock.unlock();
     
     /*
      MAIN TICK LOOP :
      */
-    cmanGlob = cMan;
     
     /* run single or mutli-threaded, depending on componentManager config in config file */
-    long long nTicks = cMan->runMultiThreaded(cmdline.getInt("nticks"));
-    getData1file();
-    /* it is important that configManager is deleted BEFORE componentManger! 
-     (since component Manger unregisters plugin Dlls, which might have allocated configTypes, etc.) */
-    delete configManager;
-    delete cMan;
+    long long nTicks = cMan->runMultiThreaded(pipeline.cmdline->getInt("nticks"));
+    getData1file(cMan, iFile);
+    
+    /* drop the component instances, the component manager is ready for the next file */
+    setupLock.lock();
+    cMan->resetInstances();
     
   } catch(cSMILException *c) { 
     // free exception ?? 
+    // the component graph is in an unknown state, the next file needs a fresh pipeline
+    pipeline.close();
+    LOGGER.flush();
     return EXIT_ERROR; 
   } 
   
+  LOGGER.flush();
   return EXIT_SUCCESS;  
 }
+
+int CRcppDataBase::work1file(std::vector<std::string> arguments, int iFile)
+{
+  Pipeline pipeline;
+  if (EXIT_SUCCESS != openPipeline(pipeline, arguments))
+    return EXIT_ERROR;
+  return run1file(pipeline, std::string(), iFile);
+}
@@ -2,16 +2,51 @@
 #define CRCPPDATABASE_H
 
 #include <core/componentManager.hpp>
+#include <core/commandlineParser.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
 
 class CRcppDataBase
 { 
 public:
+  //openSMILE set up for one config: parsed commandline and config, component manager with
+  //registered component types; input files are run through it one after another (see run1file)
+  class Pipeline
+  {
+  public:
+    Pipeline() = default;
+    Pipeline(const Pipeline &) = delete;
+    Pipeline & operator=(const Pipeline &) = delete;
+    ~Pipeline() { close(); }
+    bool isOpen() const { return nullptr != cMan; }
+    cConfigManager * getConfigManager() const { return configManager; }
+    void close();
+  private:
+    friend class CRcppDataBase;
+    std::vector<std::string> arguments;
+    std::vector<const char *> argv;   //the commandline parser keeps pointers into arguments
+    cCommandlineParser * cmdline {nullptr};
+    cConfigManager * configManager {nullptr};
+    cComponentManager * cMan {nullptr};
+  };
+  
   CRcppDataBase();
   cComponentManager::RcppModeWork modeWork;
-  int work1file(std::vector<std::string> arguments);
+  //parses the commandline and the config, configString - config text, if empty the -C file is read
+  int openPipeline(Pipeline & pipeline, std::vector<std::string> arguments, const std::string & configString = std::string());
+  //runs one input file through an opened pipeline, inputFile (if not empty) replaces the -I option
+  //iFile - index of the output slot the results are stored in (see getData1file)
+  int run1file(Pipeline & pipeline, const std::string & inputFile, int iFile = 0);
+  int work1file(std::vector<std::string> arguments, int iFile = 0);
 protected:
-  virtual void getData1file();
-  cComponentManager *cmanGlob {nullptr};
+  //called before the component instances of a file are created
+  virtual void prepare1file(cComponentManager *cMan, int iFile);
+  virtual void getData1file(cComponentManager *cMan, int iFile);
+  //set up and tear down of openSMILE touches globals (logger, component type statics),
+  //only the tick loop may run concurrently
+  static std::mutex setupMtx;
 };
   
 #endif // CRCPPDATABASE_H
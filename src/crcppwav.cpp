@@ -2,9 +2,17 @@
 #include <cstdio>
 #include <cstdlib>
 #include <limits.h>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cmath>
 
 
 #include "crcppwav.h"
+#include "mapped_file.h"
 #include <smileutil/smileUtil.h>
 #include <smileutil/smileUtil_cpp.h>
 
@@ -15,11 +23,6 @@ using namespace Rcpp;
 
 #define MODULE "CRcppWave"
 
-union sample24bit {
-  char b[4];
-  int32_t result;
-};
-
 const float CRcppWave::int8_max = 127.;
 const float CRcppWave::int16_max = 32767.;
 const float CRcppWave::int24_max = 8388607.;
@@ -30,104 +33,180 @@ CRcppWave::CRcppWave() : CRcppDataBase()
   modeWork = cComponentManager::RccpWavFiles;
 }
 
-CRcppWave::~CRcppWave()
+namespace
 {
-  std::remove(config_file.c_str());  
+const uint16_t WAVE_FORMAT_PCM = 1;
+const uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+//frames converted per step, the mapped pages of a finished step are handed back
+const size_t WAV_CHUNK_FRAMES = 65536;
+
+inline uint16_t readLE16(const uint8_t * p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+inline uint32_t readLE32(const uint8_t * p) 
+{ 
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); 
 }
 
-CRcppWave::Errors CRcppWave::parseWavFile(const std::string & strWavfile, sWaveParameters & pcmParams, std::vector<int32_t> & rawData)
+//saturating conversion, the int scale factors map full scale slightly above INT32_MAX
+inline int32_t toInt32(float v)
+{
+  if(v >= 2147483648.f) return INT32_MAX;
+  if(v < -2147483648.f) return INT32_MIN;
+  return (int32_t)v;
+}
+inline int32_t floatToInt32(double v)
 {
-  FILE * filehandle = fopen_speech(strWavfile.c_str(), "rb");  
+  if(v > 1.) v = 1.;
+  else if(v < -1.) v = -1.;
+  return (int32_t)(v * 2147483647.);
+}
 
-  if (nullptr == filehandle)
-    return CRcppWave::FileNotOpenError;
-  //handle header
-  int resHeader = smilePcm_readWaveHeader(filehandle, &pcmParams, nullptr);
-  if(0 == resHeader)
+//the loaders read one sample of a little-endian interleaved frame
+struct CLoadInt8  { float scale; int32_t operator()(const uint8_t * p) const { return toInt32(p[0] * scale); } };
+struct CLoadInt16 
+{ 
+  float scale; 
+  int32_t operator()(const uint8_t * p) const { int16_t v; std::memcpy(&v, p, 2); return toInt32(v * scale); } 
+};
+struct CLoadInt24 
+{ 
+  float scale; 
+  int32_t operator()(const uint8_t * p) const 
+  { 
+    int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+    return toInt32(v * scale); 
+  } 
+};
+struct CLoadInt24in32 
+{ 
+  float scale; 
+  int32_t operator()(const uint8_t * p) const { int32_t v; std::memcpy(&v, p, 4); return toInt32((v >> 8) * scale); } 
+};
+struct CLoadInt32 { int32_t operator()(const uint8_t * p) const { int32_t v; std::memcpy(&v, p, 4); return v; } };
+struct CLoadFloat32 { int32_t operator()(const uint8_t * p) const { float v; std::memcpy(&v, p, 4); return floatToInt32(v); } };
+struct CLoadFloat64 { int32_t operator()(const uint8_t * p) const { double v; std::memcpy(&v, p, 8); return floatToInt32(v); } };
+
+//deinterleave one channel of nFrames frames, a branch free loop the compiler can vectorize
+template <typename Load>
+void convertChannel(const uint8_t * src, size_t stride, size_t nFrames, int32_t * dst, Load load)
+{
+  for(size_t i=0; i<nFrames; i++)
+    dst[i] = load(src + i*stride);
+}
+
+template <typename Load>
+void convertAll(const uint8_t * data, const sWaveParameters & pcmParams, size_t nFrames, 
+                int32_t * out, CMappedFile & file, size_t dataOffset, Load load)
+{
+  const size_t stride = pcmParams.blockSize;
+  for(size_t f0=0; f0<nFrames; f0+=WAV_CHUNK_FRAMES)
   {
-    fclose(filehandle);    
-    return CRcppWave::HeaderParseError;   
+    size_t n = std::min(WAV_CHUNK_FRAMES, nFrames - f0);
+    const uint8_t * src = data + f0*stride;
+    for(int c=0; c<pcmParams.nChan; c++)
+      convertChannel(src + c*pcmParams.nBPS, stride, n, out + c*nFrames + f0, load);
+    file.release(dataOffset + f0*stride, n*stride);
   }
-  if(1 != pcmParams.nChan)
+}
+
+//walk the RIFF chunks of a mapped wave file up to the data chunk
+bool parseWavHeader(const uint8_t * file, size_t size, sWaveParameters & pcmParams, size_t & dataOffset, size_t & dataBytes)
+{
+  if((size < 12) || (0 != std::memcmp(file, "RIFF", 4)) || (0 != std::memcmp(file + 8, "WAVE", 4)))
+    return false;
+  size_t pos = 12;
+  bool fmtHandled = false;
+  while(pos + 8 <= size)
   {
-    fclose(filehandle);    
-    return CRcppWave::StereoError;     
+    const uint8_t * chunk = file + pos;
+    uint32_t chunkSize = readLE32(chunk + 4);
+    pos += 8;
+    if(0 == std::memcmp(chunk, "fmt ", 4))
+    {
+      if((chunkSize < 16) || (pos + 16 > size))
+        return false;
+      const uint8_t * fmt = file + pos;
+      uint16_t format = readLE16(fmt);
+      //WAVE_FORMAT_EXTENSIBLE: the sub format GUID starts with the actual format tag
+      if((WAVE_FORMAT_EXTENSIBLE == format) && (chunkSize >= 40) && (pos + 40 <= size))
+        format = readLE16(fmt + 24);
+      pcmParams.audioFormat = format;
+      pcmParams.nChan = readLE16(fmt + 2);
+      pcmParams.sampleRate = readLE32(fmt + 4);
+      pcmParams.blockSize = readLE16(fmt + 12);
+      pcmParams.nBits = readLE16(fmt + 14);
+      if((0 == pcmParams.nChan) || (0 == pcmParams.blockSize))
+        return false;
+      pcmParams.nBPS = pcmParams.blockSize / pcmParams.nChan;
+      pcmParams.byteOrder = BYTEORDER_LE;
+      pcmParams.memOrga = MEMORGA_INTERLV;
+      fmtHandled = true;
+    }
+    else if(0 == std::memcmp(chunk, "data", 4))
+    {
+      if(!fmtHandled)
+        return false;
+      dataOffset = pos;
+      //streamed files may carry a zero or oversized length, then the data runs to the end of the file
+      dataBytes = size - pos;
+      if((0 != chunkSize) && (chunkSize < dataBytes))
+        dataBytes = chunkSize;
+      pcmParams.headerOffset = (int)pos;
+      return true;
+    }
+    pos += chunkSize + (chunkSize & 1); //chunks are word aligned
   }
-  if(1 != pcmParams.audioFormat)
-  {
-    fclose(filehandle);    
+  return false;
+}
+}
+
+CRcppWave::Errors CRcppWave::parseWavFile(const std::string & strWavfile, sWaveParameters & pcmParams, std::vector<int32_t> & rawData)
+{
+  CMappedFile file;
+  if(!file.open(strWavfile))
+    return CRcppWave::FileNotOpenError;
+  size_t dataOffset = 0, dataBytes = 0;
+  if(!parseWavHeader(file.data(), file.size(), pcmParams, dataOffset, dataBytes))
+    return CRcppWave::HeaderParseError;   
+
+  const int nBPS = pcmParams.nBPS;
+  bool isInt = (WAVE_FORMAT_PCM == pcmParams.audioFormat) && (nBPS >= 1) && (nBPS <= 4);
+  bool isFloat = (WAVE_FORMAT_IEEE_FLOAT == pcmParams.audioFormat) && ((4 == nBPS) || (8 == nBPS));
+  if(!isInt && !isFloat)
     return CRcppWave::PcmError;     
-  }
-  //handle samples
-  long startRaw = ftell(filehandle);
-  fseek(filehandle, 0, SEEK_END);   
-  long size = ftell(filehandle);
-  fseek(filehandle, startRaw, SEEK_SET); 
-  uint8_t *start_buf = new uint8_t[size - startRaw];
-  int nRead = (int)fread(start_buf, 1, size-startRaw, filehandle);
-  int nSamples = nRead/(pcmParams.nChan * pcmParams.nBPS);
-  uint8_t * buf = start_buf;
+
+  //the output is allocated once, channel after channel: rawData[c*nFrames + i]
+  size_t nFrames = dataBytes / pcmParams.blockSize;
+  pcmParams.nBlocks = (long)nFrames;
+  rawData.resize(nFrames * pcmParams.nChan);
+  const uint8_t * data = file.data() + dataOffset;
+  int32_t * out = rawData.data();
   
-  switch(pcmParams.nBPS)
+  if(isFloat)
+  {
+    if(4 == nBPS)
+      convertAll(data, pcmParams, nFrames, out, file, dataOffset, CLoadFloat32());
+    else
+      convertAll(data, pcmParams, nFrames, out, file, dataOffset, CLoadFloat64());
+  }
+  else switch(nBPS)
   {
   case 1: // 8-bit int
-    for(int iSample=0; iSample<nSamples; iSample++)
-    {
-      int32_t value_32;
-      value_32 = (*buf) * (int32_max/int8_max);
-      rawData.push_back(value_32);
-      buf += pcmParams.nChan * pcmParams.nBPS;  
-    }
+    convertAll(data, pcmParams, nFrames, out, file, dataOffset, CLoadInt8{int32_max/int8_max});
     break;
   case 2: // 16-bit int
-    for(int iSample=0; iSample<nSamples; iSample++)
-    {
-      int32_t value_32;
-      value_32 = (*reinterpret_cast<const int16_t*>(buf)) * (int32_max/int16_max);
-      rawData.push_back(value_32);
-      buf += pcmParams.nChan * pcmParams.nBPS;  
-    }    
+    convertAll(data, pcmParams, nFrames, out, file, dataOffset, CLoadInt16{int32_max/int16_max});
     break;
   case 3: // 24-bit int
-    for(int iSample=0; iSample<nSamples; iSample++)
-    {
-      int32_t value_32;
-      sample24bit union_ret;
-      union_ret.b[0] = buf[0];
-      union_ret.b[1] = buf[1];
-      union_ret.b[2] = buf[2];
-      union_ret.b[3] = (buf[2] & 0x80 ? 0xFF : 0);
-      value_32= union_ret.result * (int32_max/int24_max);
-      rawData.push_back(value_32);
-      buf += pcmParams.nChan * pcmParams.nBPS;    
-    }     
+    convertAll(data, pcmParams, nFrames, out, file, dataOffset, CLoadInt24{int32_max/int24_max});
     break;
   case 4: // 32-bit int or 24-bit packed int
     if (24 == pcmParams.nBits) 
-    {
-      for(int iSample=0; iSample<nSamples; iSample++) 
-      {
-        int32_t value_32;        
-        value_32 = (*(reinterpret_cast<int32_t*>(buf)))&0xFFFFFF;
-        rawData.push_back(value_32);
-        buf += pcmParams.nChan * pcmParams.nBPS; 
-      }
-    } 
-    else if (pcmParams.nBits == 32) 
-    {
-      for(int iSample=0; iSample<nSamples; iSample++)
-      {
-        int32_t value_32;
-        value_32 = *(reinterpret_cast<int32_t*>(buf));
-        rawData.push_back(value_32);
-        buf += pcmParams.nChan * pcmParams.nBPS;  
-      }
-    }    
+      convertAll(data, pcmParams, nFrames, out, file, dataOffset, CLoadInt24in32{int32_max/int24_max});
+    else 
+      convertAll(data, pcmParams, nFrames, out, file, dataOffset, CLoadInt32());
     break;    
   }
-  
-  delete[] start_buf;
-  fclose(filehandle);
   return CRcppWave::NoError;  
 }
 
@@ -135,9 +214,10 @@ CRcppWave::Errors CRcppWave::parseWavFile_sh_int(const std::string & strWavfile,
 {
   std::vector<int32_t> rawData;
   CRcppWave::Errors res = parseWavFile(strWavfile, pcmParams, rawData);
-  for(int i=0; i<rawData.size(); i++)
+  rawData_16.resize(rawData.size());
+  for(size_t i=0; i<rawData.size(); i++)
   {
-    rawData_16.push_back(rawData[i] * (SHRT_MAX/int32_max));  
+    rawData_16[i] = rawData[i] * (SHRT_MAX/int32_max);  
   }
   return res;
 }
@@ -169,11 +249,25 @@ int CRcppWave::paStreamCallback(
     const PaStreamCallbackTimeInfo* timeInfo,
     PaStreamCallbackFlags statusFlags)
 {
+  //rawDataPlayFile holds the channels one after another (see parseWavFile), the stream wants them interleaved
+  const int nChan = headerPlayFile.nChan > 0 ? headerPlayFile.nChan : 1;
+  const size_t nFrames = rawDataPlayFile.size() / nChan;
   int numRead = frameCount;
-  if(frameCount > rawDataPlayFile.size() - indent_Audio_Raw_PlayFile)
-    numRead = rawDataPlayFile.size() - indent_Audio_Raw_PlayFile;
-  std::memcpy(output, rawDataPlayFile.data() + indent_Audio_Raw_PlayFile, numRead*sizeof(int32_t));
-  output = reinterpret_cast<uint8_t *>(output) + numRead *sizeof(int32_t);
+  if(frameCount > nFrames - indent_Audio_Raw_PlayFile)
+    numRead = nFrames - indent_Audio_Raw_PlayFile;
+  if(1 == nChan)
+    std::memcpy(output, rawDataPlayFile.data() + indent_Audio_Raw_PlayFile, numRead*sizeof(int32_t));
+  else
+  {
+    int32_t * out = reinterpret_cast<int32_t *>(output);
+    for(int c=0; c<nChan; c++)
+    {
+      const int32_t * src = rawDataPlayFile.data() + c*nFrames + indent_Audio_Raw_PlayFile;
+      for(int i=0; i<numRead; i++)
+        out[i*nChan + c] = src[i];
+    }
+  }
+  output = reinterpret_cast<uint8_t *>(output) + numRead * nChan * sizeof(int32_t);
   frameCount -= numRead;
   indent_Audio_Raw_PlayFile += numRead;
   if(frameCount > 0) 
@@ -226,20 +320,20 @@ bool CRcppWave::portAudioOpen()
 bool CRcppWave::setInputData (std::vector<std::string> audio_files_in, 
                                      std::string config_string_in)
 {
-  std::remove(config_file.c_str());
-  config_file = std::tmpnam(nullptr);
-  std::ofstream stream;
-  stream.open(config_file, std::ofstream::out | std::ofstream::trunc);
-  if(!stream.is_open())
+  //the config is parsed from memory (see CRcppDataBase::openPipeline)
+  if(config_string_in.empty())
     return false;
-  stream << config_string_in << std::endl;
-  stream.close();
+  config_string = config_string_in;
   audio_files = audio_files_in;
   
   //clear output data
   rcpp_audio_features.clear();
   rcpp_audio_timestamps.clear();
   rcpp_wave_header.clear();  
+  rcpp_border_frame_starts.clear();
+  rcpp_border_frame_ends.clear();
+  rcpp_raw_samples.clear();
+  rcpp_raw_nChan.clear();
   
   return true;
 }
@@ -248,50 +342,390 @@ void CRcppWave::getOutputData (std::vector <arma::mat> & rcpp_audio_features_out
                     std::vector <arma::rowvec> & rcpp_audio_timestamps_out,
                     std::vector <sWaveParameters> & rcpp_wave_header_out)
 {
-  rcpp_audio_features_out = rcpp_audio_features;
-  rcpp_audio_timestamps_out = rcpp_audio_timestamps;
+  //the feature matrices are moved, not copied: they are only converted to R objects once
+  rcpp_audio_features_out = std::move(rcpp_audio_features);
+  rcpp_audio_timestamps_out = std::move(rcpp_audio_timestamps);
   rcpp_wave_header_out = rcpp_wave_header;
 }
 
 void CRcppWave::getBorderFrames(std::vector <arma::rowvec> & rcpp_border_frame_starts_out,
                      std::vector <arma::rowvec> & rcpp_border_frame_ends_out)
 {
-  rcpp_border_frame_starts_out = rcpp_border_frame_starts;
-  rcpp_border_frame_ends_out = rcpp_border_frame_ends;
+  rcpp_border_frame_starts_out = std::move(rcpp_border_frame_starts);
+  rcpp_border_frame_ends_out = std::move(rcpp_border_frame_ends);
 }
 
-void CRcppWave::work()
+void CRcppWave::getRawSamples(std::vector <std::vector<int32_t>> & rcpp_raw_samples_out,
+                              std::vector <long> & rcpp_raw_nChan_out)
+{
+  rcpp_raw_samples_out = std::move(rcpp_raw_samples);
+  rcpp_raw_nChan_out = rcpp_raw_nChan;
+}
+
+std::vector<std::string> CRcppWave::fileArguments(int iFile) const
+{
+  std::vector<std::string> arguments;
+  arguments.push_back(std::string("-I"));
+  arguments.push_back(audio_files[iFile]);
+  return arguments;
+}
+
+int CRcppWave::process1file(Pipeline & pipeline, int iFile)
+{
+  //the config is parsed once per pipeline, after a failed file the pipeline is set up again
+  if(!pipeline.isOpen() &&
+     EXIT_SUCCESS != openPipeline(pipeline, fileArguments(iFile), config_string))
+    return EXIT_ERROR;
+  return run1file(pipeline, audio_files[iFile], iFile);
+}
+
+namespace
+{
+//a chunk keeps at least this many times its context of own frames, shorter files are split into fewer chunks
+const long CHUNK_MIN_CONTEXT_RATIO = 4;
+//component types that compute every output frame from the same input frame only (vector processors
+//without state), the source, the framers and the sink; a graph with any other type is not split
+const char * const chunkSafeTypes[] = {"cDataMemory", "cWaveSource", "cFramer", "cRcppDataSink",
+                                       "cVectorPreemphasis", "cWindower", "cTransformFFT", "cFFTmagphase",
+                                       "cMelspec", "cMfcc", "cEnergy", "cIntensity", "cMZcr", "cLpc",
+                                       "cFormantLpc", "cAcf", "cAmdf", "cSpectral", "cPlp",
+                                       //these need a known number of frames on both sides, see contextFrames
+                                       "cDeltaRegression", "cContourSmoother", nullptr};
+}
+
+bool CRcppWave::analyseChunkGraph(sChunkGraph & graph)
+{
+  if(audio_files.empty())
+    return false;
+  Pipeline pipeline;
+  if(EXIT_SUCCESS != openPipeline(pipeline, fileArguments(0), config_string))
+    return false;
+  cConfigManager *confman = pipeline.getConfigManager();
+  int nInst = 0;
+  char **insts = confman->getArrayKeys("componentInstances.instance", &nInst);
+  int nSources = 0, nFramers = 0;
+  graph = sChunkGraph();
+  for(int i=0; i<nInst; i++)
+  {
+    if(nullptr == insts[i])
+      continue;
+    std::string key = std::string("componentInstances.instance[") + insts[i] + "]";
+    const char *tp = confman->getStr((key + ".type").c_str());
+    const char *ci = confman->getStr((key + ".configInstance").c_str());
+    if(nullptr == tp)
+      return false;
+    std::string inst = nullptr != ci ? ci : insts[i];
+    int t = 0;
+    while((nullptr != chunkSafeTypes[t]) && (0 != strcmp(tp, chunkSafeTypes[t])))
+      t++;
+    if(nullptr == chunkSafeTypes[t])
+      return false;
+    if(0 == strcmp(tp, "cWaveSource"))
+    {
+      //the chunks set the read range, a range given by the config is kept as it is (no chunks)
+      if((0.0 != confman->getDouble((inst + ".start").c_str())) || (confman->getDouble((inst + ".end").c_str()) >= 0.0) ||
+         (0.0 != confman->getDouble((inst + ".endrel").c_str())) || confman->isSet((inst + ".startSamples").c_str()) ||
+         confman->isSet((inst + ".endSamples").c_str()) || confman->isSet((inst + ".endrelSamples").c_str()))
+        return false;
+      graph.waveSource = inst;
+      nSources++;
+    }
+    else if(0 == strcmp(tp, "cFramer"))
+    {
+      const char *mode = confman->getStr((inst + ".frameMode").c_str());
+      if((nullptr != mode) && (0 != strncmp(mode, "fix", 3)))
+        return false;
+      double step = confman->getDouble((inst + ".frameStep").c_str());
+      double size = confman->getDouble((inst + ".frameSize").c_str());
+      long stepFrames = confman->getInt((inst + ".frameStepFrames").c_str());
+      long sizeFrames = confman->getInt((inst + ".frameSizeFrames").c_str());
+      if((0.0 == step) && (0 == stepFrames))
+        step = size;
+      //all frames must be on one grid, the frame index of a chunk is then the frame index of the file
+      if((nFramers > 0) && ((step != graph.frameStep) || (stepFrames != graph.frameStepFrames)))
+        return false;
+      graph.frameStep = step;
+      graph.frameStepFrames = stepFrames;
+      if(sizeFrames > 0)
+        graph.frameSizeFrames = std::max(graph.frameSizeFrames, sizeFrames);
+      else
+        graph.frameSize = std::max(graph.frameSize, size);
+      const char *center = confman->getStr((inst + ".frameCenterSpecial").c_str());
+      if((nullptr != center) && ((0 == strncmp(center, "mi", 2)) || (0 == strncmp(center, "ce", 2))))
+        graph.frameCenter = std::max(graph.frameCenter, size / 2.0);
+      else if((nullptr != center) && (0 == strncmp(center, "ri", 2)))
+        graph.frameCenter = std::max(graph.frameCenter, size);
+      else
+        graph.frameCenter = std::max(graph.frameCenter, confman->getDouble((inst + ".frameCenter").c_str()));
+      nFramers++;
+    }
+    else if(0 == strcmp(tp, "cDeltaRegression"))
+    {
+      //deltawin = 0 is the simple difference to the previous frame
+      graph.contextFrames += std::max(1, confman->getInt((inst + ".deltawin").c_str()));
+    }
+    else if(0 == strcmp(tp, "cContourSmoother"))
+    {
+      graph.contextFrames += confman->getInt((inst + ".smaWin").c_str()) / 2;
+    }
+  }
+  return (1 == nSources) && (nFramers > 0) && ((graph.frameStep > 0.0) || (graph.frameStepFrames > 0));
+}
+
+void CRcppWave::planChunks(const sChunkGraph & graph, int iFile, std::vector<sChunk> & chunks_out) const
+{
+  CMappedFile file;
+  if(!file.open(audio_files[iFile]))
+    return;
+  sWaveParameters pcmParams;
+  size_t dataOffset = 0, dataBytes = 0;
+  if(!parseWavHeader(file.data(), file.size(), pcmParams, dataOffset, dataBytes) || (pcmParams.sampleRate <= 0))
+    return;
+  const double sampleRate = pcmParams.sampleRate;
+  const long nSamples = (long)(dataBytes / pcmParams.blockSize);
+  //frame step and size in samples and the frame period as computed by cWinToVecProcessor::configureWriter
+  long step = graph.frameStepFrames > 0 ? graph.frameStepFrames : (long)round(graph.frameStep * sampleRate);
+  long size = graph.frameSizeFrames > 0 ? graph.frameSizeFrames : (long)round(graph.frameSize * sampleRate);
+  double period = graph.frameStepFrames > 0 ? (double)graph.frameStepFrames * (1.0 / sampleRate) : graph.frameStep;
+  if(step <= 0)
+    return;
+  long nFrames = nSamples / step;
+  long center = (long)ceil(graph.frameCenter * sampleRate / step);
+  long context = graph.contextFrames;
+  long left = context + center;
+  long n = std::min((long)nChunks, nFrames / (CHUNK_MIN_CONTEXT_RATIO * std::max(1L, left + context)));
+  if(n < 2)
+    return;
+  for(long c=0; c<n; c++)
+  {
+    sChunk chunk;
+    chunk.iFile = iFile;
+    chunk.firstFrame = c * nFrames / n;
+    chunk.inputFrame = std::max(0L, chunk.firstFrame - left);
+    chunk.startSample = chunk.inputFrame * step;
+    chunk.sampleRate = sampleRate;
+    chunk.period = period;
+    if(c < n - 1)
+    {
+      chunk.endFrame = (c + 1) * nFrames / n;
+      chunk.endSample = std::min(nSamples, (chunk.endFrame + context) * step + size);
+    }
+    chunks_out.push_back(std::move(chunk));
+  }
+}
+
+void CRcppWave::staticAddChunkFrame(void *obj, const FLOAT_DMEM *features, long nFeatures, double)
 {
-  for(int iFile = 0; iFile < audio_files.size(); iFile++)
+  sChunk & chunk = *reinterpret_cast<sChunk *>(obj);
+  long k = chunk.inputFrame + chunk.nReceived++;
+  if((k < chunk.firstFrame) || ((chunk.endFrame >= 0) && (k >= chunk.endFrame)))
+    return;
+  if(0 == chunk.nFeatures)
+    chunk.nFeatures = nFeatures;
+  else if(nFeatures != chunk.nFeatures)
+    return;
+  chunk.features.insert(chunk.features.end(), features, features + nFeatures);
+}
+
+int CRcppWave::process1chunk(Pipeline & pipeline, int iChunk)
+{
+  int iFile = chunks[iChunk].iFile;
+  if(!pipeline.isOpen() &&
+     EXIT_SUCCESS != openPipeline(pipeline, fileArguments(iFile), config_string))
+    return EXIT_ERROR;
+  return run1file(pipeline, audio_files[iFile], (int)audio_files.size() + iChunk);
+}
+
+void CRcppWave::stitchChunks(int iFile)
+{
+  long nRows = 0, nFeatures = 0;
+  sWaveParameters & header = rcpp_wave_header[iFile];
+  double period = 0;
+  for(const sChunk & chunk : chunks)
+  {
+    if(chunk.iFile != iFile)
+      continue;
+    //a failed chunk fails the file, as a failed serial run would
+    if(!chunk.done || ((chunk.nFeatures > 0) && (nFeatures > 0) && (chunk.nFeatures != nFeatures)))
+      return;
+    if(chunk.nFeatures > 0)
+      nFeatures = chunk.nFeatures;
+    period = chunk.period;
+  }
+  if(0 == nFeatures)
+    return;
+  for(const sChunk & chunk : chunks)
+  {
+    if(chunk.iFile == iFile)
+      nRows += chunk.features.size() / nFeatures;
+  }
+  //the serial run zero pads to the number of frames estimated from the header (see cComponentManager::getFeatures)
+  long nRowsAlloc = nRows;
+  if((period > 0.0) && (header.sampleRate > 0))
+    nRowsAlloc = std::max(nRows, (long)(header.nBlocks / (header.sampleRate * period)));
+  arma::mat & features = rcpp_audio_features[iFile];
+  arma::rowvec & timestamps = rcpp_audio_timestamps[iFile];
+  features.zeros(nRowsAlloc, nFeatures);
+  timestamps.zeros(nRowsAlloc);
+  long row = 0;
+  for(sChunk & chunk : chunks)
   {
-    std::vector<std::string> arguments;
-    arguments.push_back(std::string("-I"));
-    arguments.push_back(audio_files[iFile]);
-    arguments.push_back(std::string("-C")); 
-    arguments.push_back(config_file);
-    work1file(arguments);
+    if(chunk.iFile != iFile)
+      continue;
+    long n = chunk.features.size() / nFeatures;
+    for(long r=0; r<n; r++, row++)
+    {
+      const double *src = chunk.features.data() + r*nFeatures;
+      for(long f=0; f<nFeatures; f++)
+        features(row, f) = src[f];
+      timestamps[row] = (double)(chunk.firstFrame + r) * period;
+    }
+    std::vector<double>().swap(chunk.features);
   }
 }
+
+void CRcppWave::work()
+{
+  int nFiles = audio_files.size();
+  rcpp_audio_features.resize(nFiles);
+  rcpp_audio_timestamps.resize(nFiles);
+  rcpp_wave_header.resize(nFiles);
+  rcpp_border_frame_starts.resize(nFiles);
+  rcpp_border_frame_ends.resize(nFiles);
+  rcpp_raw_samples.resize(nFiles);
+  rcpp_raw_nChan.assign(nFiles, 1);
   
-void CRcppWave::getData1file()
-{
-  arma::rowvec rcpp_audio_start_frames_1;
-  arma::rowvec rcpp_audio_end_frames_1;  
-  cmanGlob->getWaveFrameBorders(rcpp_audio_start_frames_1,
-                                rcpp_audio_end_frames_1);
-  rcpp_border_frame_starts.push_back(rcpp_audio_start_frames_1);
-  rcpp_border_frame_ends.push_back(rcpp_audio_end_frames_1);
-
-  arma::mat rcpp_audio_features_1;
-  arma::rowvec rcpp_audio_timestamps_1;
-  sWaveParameters rcpp_wave_header_1;
-    
-  cmanGlob->getFeatures(rcpp_audio_features_1,
-                        rcpp_audio_timestamps_1, rcpp_wave_header_1);
+  //long files are split into time ranges, every range is a task of its own; files that are
+  //too short (or not wave files) are processed as a whole
+  chunks.clear();
+  if((nChunks > 1) && !keepSamples && analyseChunkGraph(chunkGraph))
+  {
+    for(int iFile = 0; iFile < nFiles; iFile++)
+      planChunks(chunkGraph, iFile, chunks);
+  }
+  std::vector<int> wholeFiles;
+  for(int iFile = 0, iChunk = 0; iFile < nFiles; iFile++)
+  {
+    if((iChunk < (int)chunks.size()) && (chunks[iChunk].iFile == iFile))
+    {
+      while((iChunk < (int)chunks.size()) && (chunks[iChunk].iFile == iFile))
+        iChunk++;
+    }
+    else
+      wholeFiles.push_back(iFile);
+  }
+  int nChunkTasks = chunks.size();
+  int nTasks = nChunkTasks + wholeFiles.size();
+  auto process1task = [this, &wholeFiles, nChunkTasks](Pipeline & pipeline, int iTask)
+  {
+    if(iTask < nChunkTasks)
+      process1chunk(pipeline, iTask);
+    else
+      process1file(pipeline, wholeFiles[iTask - nChunkTasks]);
+  };
+  
+  int nThreads = std::min(nWorkers, nTasks);
+  if(nThreads <= 1)
+  {
+    Pipeline pipeline;
+    for(int iTask = 0; iTask < nTasks; iTask++)
+      process1task(pipeline, iTask);
+  }
+  else
+  {
+    //worker pool: every worker takes the next unprocessed file (or chunk) and runs it through its own
+    //pipeline (component graph), results go to the preallocated slot of that file (or chunk)
+    std::atomic<int> nextTask(0);
+    std::vector<std::exception_ptr> errors(nThreads);
+    std::vector<std::thread> workers;
+    LOGGER.setDeferConsoleOutput(1);
+    for(int iThread = 0; iThread < nThreads; iThread++)
+    {
+      workers.emplace_back([&process1task, &nextTask, &errors, nTasks, iThread]()
+      {
+        try
+        {
+          Pipeline pipeline;
+          for(int iTask = nextTask++; iTask < nTasks; iTask = nextTask++)
+            process1task(pipeline, iTask);
+        }
+        catch(...)
+        {
+          errors[iThread] = std::current_exception();
+        }
+      });
+    }
+    for(int iThread = 0; iThread < nThreads; iThread++)
+      workers[iThread].join();
+    LOGGER.setDeferConsoleOutput(0);
     
-  rcpp_audio_features.push_back(rcpp_audio_features_1);
-  rcpp_audio_timestamps.push_back(rcpp_audio_timestamps_1);
-  rcpp_wave_header.push_back(rcpp_wave_header_1);    
+    for(int iThread = 0; iThread < nThreads; iThread++)
+    {
+      if(errors[iThread])
+      {
+        chunks.clear();
+        std::rethrow_exception(errors[iThread]);
+      }
+    }
+  }
+  
+  for(int iChunk = 0; iChunk < nChunkTasks; iChunk++)
+  {
+    if((0 == iChunk) || (chunks[iChunk].iFile != chunks[iChunk-1].iFile))
+      stitchChunks(chunks[iChunk].iFile);
+  }
+  chunks.clear();
+}
+  
+void CRcppWave::prepare1file(cComponentManager *cMan, int iFile)
+{
+  cMan->setKeepWaveSamples(keepSamples);
+  if(chunks.empty())
+    return;
+  //chunked processing: the wave source reads the range of the chunk, a whole file is read from start to end
+  //(the config gives no range, see analyseChunkGraph), the frames of a chunk go to the chunk
+  ConfigInstance *source = cMan->getConfigManager()->getInstance(chunkGraph.waveSource.c_str());
+  int iChunk = iFile - (int)audio_files.size();
+  if(iChunk >= 0)
+  {
+    sChunk & chunk = chunks[iChunk];
+    chunk.nReceived = 0;
+    chunk.nFeatures = 0;
+    chunk.features.clear();
+    //the range goes in seconds (the *Samples fields are int), half a sample inside the range so that
+    //cWaveSource's floor(start * rate) and ceil(end * rate) give back the sample numbers
+    if(nullptr != source)
+    {
+      source->setDouble("start", ((double)chunk.startSample + 0.5) / chunk.sampleRate);
+      source->setDouble("end", chunk.endSample >= 0 ? ((double)chunk.endSample - 0.5) / chunk.sampleRate : -1.0);
+    }
+    cMan->setFeatureFrameListener(staticAddChunkFrame, &chunk);
+  }
+  else if(nullptr != source)
+  {
+    source->setDouble("start", 0.0);
+    source->setDouble("end", -1.0);
+  }
+}
+
+void CRcppWave::getData1file(cComponentManager *cMan, int iFile)
+{
+  int iChunk = iFile - (int)audio_files.size();
+  if(iChunk >= 0)
+  {
+    sChunk & chunk = chunks[iChunk];
+    cMan->setFeatureFrameListener(nullptr, nullptr);
+    if(0 == chunk.firstFrame)
+      cMan->getWaveHeader(rcpp_wave_header[chunk.iFile]);
+    chunk.done = true;
+    return;
+  }
+  cMan->getWaveFrameBorders(rcpp_border_frame_starts[iFile],
+                            rcpp_border_frame_ends[iFile]);
+  cMan->getFeatures(rcpp_audio_features[iFile],
+                    rcpp_audio_timestamps[iFile], rcpp_wave_header[iFile]);
+  if(keepSamples)
+    cMan->getWaveSamples(rcpp_raw_samples[iFile], rcpp_raw_nChan[iFile]);
 }
 
 
@@ -314,8 +748,13 @@ void CRcppWave::saveToWaveFile (const std::string & filePath,
 {
   std::vector<uint8_t> fileData;
   
-  int32_t dataChunkSize = header.nBlocks * header.blockSize;
-  int32_t samplesInChannel =  header.nBlocks/ header.nChan;
+  //rawData holds the channels one after another (see parseWavFile), the file stores them interleaved
+  const int nChan = header.nChan > 0 ? header.nChan : 1;
+  const size_t stride = rawData.size() / nChan;
+  if((header.nBlocks < 0) || ((size_t)header.nBlocks > stride))
+    Rcpp::stop("ERROR: header.nBlocks does not match the number of samples, couldn't save file to " + filePath);
+  const size_t nFrames = (size_t)header.nBlocks;
+  int32_t dataChunkSize = (int32_t)(nFrames * nChan * (header.nBits / 8));
   
   // -----------------------------------------------------------
   // HEADER CHUNK
@@ -349,26 +788,26 @@ void CRcppWave::saveToWaveFile (const std::string & filePath,
   addStringToFileData (fileData, "data");
   addInt32ToFileData (fileData, dataChunkSize);
   
-  //now allways 1 channel
-  for (int i = 0; i < samplesInChannel; i++)
+  for (size_t k = 0; k < nFrames * nChan; k++)
   {
+    const int32_t sample = rawData[(k % nChan) * stride + k / nChan];
     switch(header.nBits)
     {
       case 8:
       {
-        uint8_t value = (rawData[i] * int8_max) / int32_max;
+        uint8_t value = (sample * int8_max) / int32_max;
         fileData.push_back (value);
       }
       break;
       case 16:
       {
-        uint16_t value = (rawData[i] * int16_max) / int32_max;
+        uint16_t value = (sample * int16_max) / int32_max;
         addInt16ToFileData (fileData,value ); 
       }
       break;
       case 32:
       {
-        addInt32ToFileData (fileData, rawData[i]);           
+        addInt32ToFileData (fileData, sample);           
       }
       break;
       default:
@@ -377,7 +816,7 @@ void CRcppWave::saveToWaveFile (const std::string & filePath,
   }
 
   // check that the various sizes we put in the metadata are correct
-  if (fileSizeInBytes != (fileData.size() - 8) || dataChunkSize != (header.nBlocks * (header.nBits / 8)))
+  if (fileSizeInBytes != (fileData.size() - 8))
     Rcpp::stop("ERROR: couldn't save file to "  + filePath);
   
   // try to write the file
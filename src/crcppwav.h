@@ -12,19 +12,30 @@
 class CRcppWave: public CRcppDataBase
 {
 public:
-  enum Errors {NoError, StereoError, PcmError, FileNotOpenError, HeaderParseError};
+  enum Errors {NoError, PcmError, FileNotOpenError, HeaderParseError};
   CRcppWave();
-  ~CRcppWave();
   bool setInputData (std::vector<std::string> audio_files_in, 
                      std::string config_string_in);
+  //getOutputData and getBorderFrames hand the results over (moved), call them once after work()
   void getOutputData (std::vector <arma::mat> & rcpp_audio_features_out,
                       std::vector <arma::rowvec> & rcpp_audio_timestamps_out,
                       std::vector <sWaveParameters> & rcpp_wave_header_out);
   void getBorderFrames(std::vector <arma::rowvec> & rcpp_border_frame_starts_out,
                        std::vector <arma::rowvec> & rcpp_border_frame_ends_out);
+  //samples decoded by cWaveSource during work() (only if setKeepSamples(true)), layout as in parseWavFile
+  void getRawSamples(std::vector <std::vector<int32_t>> & rcpp_raw_samples_out,
+                     std::vector <long> & rcpp_raw_nChan_out);
   
+  //number of files processed concurrently by work(), each file in its own component graph
+  void setNumWorkers(int nWorkers_in) { nWorkers = nWorkers_in; }
+  void setKeepSamples(bool keepSamples_in) { keepSamples = keepSamples_in; }
+  //number of time ranges a wave file is split into, the ranges run concurrently (each in its own component graph)
+  //and their frames are stitched in order; 1 = off. Only used for graphs with a known, finite context (see analyseChunkGraph)
+  void setNumChunks(int nChunks_in) { nChunks = nChunks_in; }
   void work();
-  static CRcppWave::Errors parseWavFile(const std::string & strWavfile, sWaveParameters & header, std::vector<int32_t> & error);
+  //parseWavFile maps the file and converts it in chunks to int32 full scale (PCM 8/16/24/32 bit, IEEE float 32/64 bit),
+  //multichannel data is deinterleaved: rawData[c*header.nBlocks + i] is sample i of channel c
+  static CRcppWave::Errors parseWavFile(const std::string & strWavfile, sWaveParameters & header, std::vector<int32_t> & rawData);
   static CRcppWave::Errors parseWavFile_sh_int(const std::string & strWavfile, sWaveParameters & pcmParams, std::vector<short int> & rawData_16);
   static const float int8_max;
   static const float int16_max;
@@ -61,13 +72,54 @@ protected:
     BigEndian
   };
   
-  virtual void getData1file();
+  virtual void prepare1file(cComponentManager *cMan, int iFile);
+  virtual void getData1file(cComponentManager *cMan, int iFile);
+  std::vector<std::string> fileArguments(int iFile) const;
+  int process1file(Pipeline & pipeline, int iFile);
+  
+  //chunked processing of a single file: the component graph of every chunk reads the samples
+  //[startSample, endSample) through the wave source, the frames [firstFrame, endFrame) of the file are kept
+  struct sChunkGraph
+  {
+    std::string waveSource;     //config instance of the (only) cWaveSource
+    double frameStep {0};       //step and size of the framers, in seconds or in samples (*Frames, if > 0)
+    double frameSize {0};
+    long frameStepFrames {0};
+    long frameSizeFrames {0};
+    double frameCenter {0};     //largest frame center in seconds, frames reach back by this much
+    long contextFrames {0};     //frames needed on both sides of a frame (delta regression, smoothing)
+  };
+  struct sChunk
+  {
+    int iFile {0};
+    long startSample {0};
+    long endSample {-1};        //-1 = end of file
+    long inputFrame {0};        //file frame index of the first frame of the chunk
+    long firstFrame {0};
+    long endFrame {-1};         //-1 = all frames to the end of file
+    double sampleRate {0};
+    double period {0};          //frame period, the timestamp of file frame k is k*period
+    long nReceived {0};
+    long nFeatures {0};
+    std::vector<double> features; //kept frames, row after row
+    bool done {false};
+  };
+  bool analyseChunkGraph(sChunkGraph & graph);
+  void planChunks(const sChunkGraph & graph, int iFile, std::vector<sChunk> & chunks_out) const;
+  int process1chunk(Pipeline & pipeline, int iChunk);
+  void stitchChunks(int iFile);
+  static void staticAddChunkFrame(void *obj, const FLOAT_DMEM *features, long nFeatures, double time);
   
   //input data
   std::vector<std::string> audio_files; 
-  std::string config_file;
+  std::string config_string;
+  int nWorkers {1};
+  int nChunks {1};
+  bool keepSamples {false};
+  sChunkGraph chunkGraph;
+  std::vector<sChunk> chunks;   //chunks of all files (chunked processing only), chunk i runs in output slot nFiles + i
   
-  //output data
+  //output data, one slot per input file
   std::vector <arma::mat> rcpp_audio_features;
   std::vector <arma::rowvec> rcpp_audio_timestamps;
   std::vector <sWaveParameters> rcpp_wave_header; 
@@ -75,6 +127,10 @@ protected:
   //output - turn testing
   std::vector <arma::rowvec> rcpp_border_frame_starts;
   std::vector <arma::rowvec> rcpp_border_frame_ends;  
+  
+  //output - raw samples
+  std::vector <std::vector<int32_t>> rcpp_raw_samples;
+  std::vector <long> rcpp_raw_nChan;
     
   //wav playing
   bool portAudioOpen();
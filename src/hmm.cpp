@@ -20,13 +20,17 @@
 // k \in \{1, ..., K\}	 		indexes states
 // m \in \{1, ..., M\} 			indexes features
 
-// alpha_i	matrix, [K x T]		scaled forward probs, \propto Pr(X_1=x_1, ..., X_t=x_t, Z_t=k) - not actually used
-// lalpha_i	matrix, [K x T]		log alpha_i
-// lalphas	list, length N		collects lalpha_i
+// alpha_i	matrix, [K x T]		scaled forward probs, \propto Pr(X_1=x_1, ..., X_t=x_t, Z_t=k), columns sum to 1
+// alphas	list, length N		collects alpha_i
+// lalpha_i	matrix, [K x T]		log forward probs, log alpha_i + lalpha_scale_i
+// lalpha_scales	list, length N		collects lalpha_scale_i, vector length T
 
-// beta_i	matrix, [K x T]		scaled backward probs, \propto Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k) - not actually used
-// lbeta_i	matrix, [K x T]		log beta_i
-// lbetas	list, length N		collects lbeta_i
+// beta_i	matrix, [K x T]		scaled backward probs, \propto Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k)
+// betas	list, length N		collects beta_i
+// lbeta_i	matrix, [K x T]		log backward probs, log beta_i + lbeta_scale_i
+// lbeta_scales	list, length N		collects lbeta_scale_i, vector length T
+
+// xi_sums	list, length N		expected transition counts of obs seq i, [K x K], before multiplying by Gamma
 
 // Gamma	matrix, [K x K]		row-stochastic transition probs
 
@@ -37,6 +41,7 @@
 
 // Sigma_i	matrix, [M x M]		cov mat of state distr - not actually used
 // Sigmas	tensor, [K x M x M]	collects state cov mats
+// covariance	string			structure of Sigmas: "full", "diagonal" or "tied" (one full cov mat shared by all states)
 
 // Ts		vector, length N	collects T_i
 
@@ -53,6 +58,24 @@
 #include <RcppArmadillo.h>
 // [[Rcpp::depends("RcppArmadillo")]]
 
+#include <algorithm>
+#include <cstring>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <core/smileCommon.hpp>
+#include <smileutil/smileUtil.h>
+#include "crcppwav.h"
+#include "mapped_file.h"
+#include "utils_global.h"
+
 
 
 ////////////////////////////////////////
@@ -62,107 +85,275 @@
 
 const double log2pi = std::log(2.0 * M_PI);
 
-// workhorse multivariate normal density for basic hmm
-// allows for partial censoring of features
-// [[Rcpp::export]]
-arma::vec dmvnorm_cens(
-    arma::mat X,  			  // data, [T x M]
-    arma::rowvec mu,  	// mean vector, [1 x M]
-    arma::mat Sigma, 			// covariance matrix, [M x M]
-    arma::uvec missingness_labels_i,  // pattern of missingness features
-    std::vector< arma::uvec > nonmissing_features,
-    bool logd = false,		// return logarithm?
-    double lambda = 0  		// ridge-like regularization, added to Sigma.diag()
+// structure of the state cov mats
+enum cov_structure {
+  cov_full,       // one full cov mat per state
+  cov_diagonal,   // one diagonal cov mat per state: independent features, no cholesky
+  cov_tied        // one full cov mat shared by all states
+};
+
+cov_structure parse_covariance(const std::string &covariance){
+  if (covariance == "full"){
+    return cov_full;
+  } else if (covariance == "diagonal"){
+    return cov_diagonal;
+  } else if (covariance == "tied"){
+    return cov_tied;
+  }
+  Rcpp::stop("covariance must be one of \"full\", \"diagonal\", \"tied\"");
+}
+
+// project the state cov mats onto the covariance structure
+// tied: average of the state cov mats, weighted by state_weights (e.g. the summed responsibilities)
+void constrain_covs(arma::cube &Sigmas, const arma::vec &state_weights, cov_structure covariance){
+  if (covariance == cov_diagonal){
+    for (arma::uword k=0; k<Sigmas.n_slices; k++){
+      Sigmas.slice(k) = arma::diagmat(Sigmas.slice(k));
+    }
+  } else if (covariance == cov_tied){
+    arma::mat pooled(Sigmas.n_rows, Sigmas.n_cols, arma::fill::zeros);
+    for (arma::uword k=0; k<Sigmas.n_slices; k++){
+      pooled += state_weights(k) * Sigmas.slice(k);
+    }
+    pooled /= arma::accu(state_weights);
+    for (arma::uword k=0; k<Sigmas.n_slices; k++){
+      Sigmas.slice(k) = pooled;
+    }
+  }
+}
+
+// reset the cov mat of collapsed state k to the unit sphere
+// tied: the cov mat is shared by all states (make_emission_model reads slice 0), so every slice is reset
+void reset_cov(arma::cube &Sigmas, arma::uword k, cov_structure covariance){
+  for (arma::uword l=0; l<Sigmas.n_slices; l++){
+    if (l == k || covariance == cov_tied){
+      Sigmas.slice(l) = arma::eye<arma::mat>(Sigmas.n_rows, Sigmas.n_cols);
+    }
+  }
+}
+
+// factors of the normal density of one state, one entry per missingness pattern
+// (computed once per set of parameters and shared by all obs seqs)
+struct emission_state {
+  arma::rowvec mu;                  // mean vector, [1 x M]
+  bool diagonal = false;            // diagonal Sigma: rooti_diag is used instead of rooti
+  std::vector<arma::mat> rooti;     // pattern m: inverse cholesky factor of Sigma over the observed features, lower triangular
+  std::vector<arma::rowvec> rooti_diag;  // pattern m: inverse standard deviations of the observed features
+  std::vector<double> rootisum;     // pattern m: log det of rooti
+  std::vector<double> constants;    // pattern m: -M_m/2 * log(2 pi)
+};
+
+emission_state make_emission_state(
+    const arma::rowvec &mu,  	// mean vector, [1 x M]
+    arma::mat Sigma, 			    // covariance matrix, [M x M]
+    const std::vector< arma::uvec > &nonmissing_features,
+    double lambda = 0,  		  // ridge-like regularization, added to Sigma.diag()
+    bool diagonal = false     // use only Sigma.diag()
 ){
   // modified from fast dmvnorm() implementation by Nino Hardt and Dicko Ahmadou
   // http://gallery.rcpp.org/articles/dmvnorm_arma/
   // in turn based on bayesm::dMvn() by Peter Rossi
   
-  arma::uword n = X.n_rows;
-  arma::uword M = X.n_cols;
   arma::uword nlabels = nonmissing_features.size();
   
-  arma::vec out(n);
+  emission_state state;
+  state.mu = mu;
+  state.diagonal = diagonal;
   Sigma.diag() += lambda;  // ridge-like regularization
   
-  std::vector< arma::mat > rooti;
-  std::vector<double> rootisum;
-  std::vector<double> constants;
+  if (diagonal){
+    // independent features: missing features simply drop out of the sum over features
+    arma::rowvec sds = sqrt(Sigma.diag().t());
+    for (arma::uword m=0; m<nlabels; m++){
+      arma::rowvec sds_censor = sds.cols(nonmissing_features[m]);
+      if (!sds_censor.is_finite() || arma::any(sds_censor <= 0)){
+        std::ostringstream msg;
+        msg << "error in missingness mode " << (m+1) << std::endl;
+        msg << "diagonal covariance matrix has non-positive variances" << std::endl;
+        throw std::runtime_error(msg.str());
+      }
+      state.rooti_diag.push_back(1.0 / sds_censor);
+      state.rootisum.push_back(-arma::accu(log(sds_censor)));
+      state.constants.push_back(-(static_cast<double>(nonmissing_features[m].n_rows)/2.0) * log2pi);
+    }
+    return state;
+  }
+  
   for (arma::uword m=0; m<nlabels; m++){
     if (nonmissing_features[m].n_rows > 0){
       arma::mat Sigma_censor = 
         Sigma.submat(nonmissing_features[m], nonmissing_features[m]);
       try {
-        rooti.push_back(arma::trans(arma::inv(trimatu(arma::chol(Sigma_censor)))));
+        state.rooti.push_back(arma::trans(arma::inv(trimatu(arma::chol(Sigma_censor)))));
       } catch(std::exception &ex) {
-        Rcpp::Rcout << "error in missingness mode " << (m+1) << std::endl;
-        // // Rcpp::Rcout << "following features observed in this mode: " << nonmissing_features[m] << std::endl;
-        Rcpp::Rcout << "failed to invert covariance matrix" << std::endl;
+        // no printing here: this also runs on the E-step worker threads, the message is reported by the caller
+        std::ostringstream msg;
+        msg << "error in missingness mode " << (m+1) << std::endl;
+        msg << "failed to invert covariance matrix" << std::endl;
         if (Sigma.n_rows > 5){
-          Rcpp::Rcout << "showing Sigma[1:5, 1:5] (after dropping censored features):" << std::endl;
-          Rcpp::Rcout << Sigma_censor.submat(1,1,5,5) << std::endl;
+          msg << "showing Sigma[1:5, 1:5] (after dropping censored features):" << std::endl;
+          msg << Sigma_censor.submat(1,1,5,5) << std::endl;
         } else {
-          Rcpp::Rcout << Sigma_censor << std::endl;
+          msg << Sigma_censor << std::endl;
         }
-        forward_exception_to_r(ex);
+        msg << ex.what();
+        throw std::runtime_error(msg.str());
       }
-      rootisum.push_back(arma::sum(log(rooti[m].diag())));
-      constants.push_back(-(static_cast<double>(nonmissing_features[m].n_rows)/2.0) * log2pi);
+      state.rootisum.push_back(arma::sum(log(state.rooti[m].diag())));
+      state.constants.push_back(-(static_cast<double>(nonmissing_features[m].n_rows)/2.0) * log2pi);
     } else {
-      rooti.push_back(arma::zeros<arma::vec>(1));
-      rootisum.push_back(0);
-      constants.push_back(0);
+      state.rooti.push_back(arma::zeros<arma::vec>(1));
+      state.rootisum.push_back(0);
+      state.constants.push_back(0);
     }
   }
   
-  for (arma::uword t=0; t<n; t++) {
+  return state;
+}
+
+// emission model: one emission_state per state k
+// tied: Sigmas.slice(0) is factorized once and shared by all states
+std::vector<emission_state> make_emission_model(
+    const arma::mat &mus,			               // state-specific means: rows=covariates, cols=state
+    const arma::cube &Sigmas,			           // state-specific vcov matrices: rows/cols=covariates, slices=state
+    const std::vector< arma::uvec > &nonmissing_features,
+    double lambda,
+    cov_structure covariance = cov_full
+){
+  std::vector<emission_state> model;
+  for (arma::uword k=0; k<Sigmas.n_slices; k++){
+    if (covariance == cov_tied && k > 0){
+      model.push_back(model[0]);
+      model[k].mu = mus.col(k).t();
+    } else {
+      model.push_back(make_emission_state(mus.col(k).t(), Sigmas.slice(k), nonmissing_features, lambda,
+                                          covariance == cov_diagonal));
+    }
+  }
+  return model;
+}
+
+// obs of one seq grouped by missingness pattern: element m holds the rows with pattern m
+std::vector< arma::uvec > rows_by_pattern(
+    const arma::uvec &missingness_labels_i,  // pattern of missingness features
+    arma::uword nlabels
+){
+  std::vector<arma::uword> counts(nlabels, 0);
+  for (arma::uword t=0; t<missingness_labels_i.n_elem; t++){
+    counts[missingness_labels_i(t)]++;
+  }
+  std::vector< arma::uvec > rows(nlabels);
+  for (arma::uword m=0; m<nlabels; m++){
+    rows[m].set_size(counts[m]);
+    counts[m] = 0;
+  }
+  for (arma::uword t=0; t<missingness_labels_i.n_elem; t++){
     arma::uword m = missingness_labels_i(t);
-    arma::rowvec X_row = X.row(t);
-    if (nonmissing_features[m].n_rows > 0){
-      arma::vec z = rooti[m] * 
-        (X_row(nonmissing_features[m]) - mu(nonmissing_features[m]));
-      out(t) = constants[m] - 0.5 * arma::sum(z % z) + rootisum[m];
+    rows[m](counts[m]++) = t;
+  }
+  return rows;
+}
+
+// log density of all obs of one seq in one state, written to lstateprobs.col(k)
+// the obs of a missingness pattern are demeaned and multiplied by rooti as one block
+void emission_ldens(
+    const emission_state &state,
+    const arma::mat &X,  			                       // data, [T x M]
+    const std::vector< arma::uvec > &rows,           // obs grouped by missingness pattern
+    const std::vector< arma::uvec > &nonmissing_features,
+    arma::mat &lstateprobs,                          // [T x K]
+    arma::uword k
+){
+  for (arma::uword m=0; m<rows.size(); m++){
+    if (rows[m].n_elem == 0){
+      continue;
+    }
+    if (nonmissing_features[m].n_rows == 0){
+      for (arma::uword r=0; r<rows[m].n_elem; r++){
+        lstateprobs(rows[m](r), k) = 0;
+      }
+      continue;
+    }
+    arma::mat dev = X.submat(rows[m], nonmissing_features[m]);
+    dev.each_row() -= state.mu.cols(nonmissing_features[m]);
+    arma::mat z;
+    if (state.diagonal){
+      z = dev.each_row() % state.rooti_diag[m];  // O(M) per obs
     } else {
-      out(t) = 0;
+      z = dev * state.rooti[m].t();
+    }
+    arma::vec ld = state.constants[m] - 0.5 * arma::sum(z % z, 1) + state.rootisum[m];
+    for (arma::uword r=0; r<rows[m].n_elem; r++){
+      lstateprobs(rows[m](r), k) = ld(r);
     }
   }
-  
-  if (logd == false) {
-    out = exp(out);
+}
+
+// log density of all obs of one seq in every state: lstateprobs [T x K]
+void emission_lstateprobs(
+    const std::vector<emission_state> &model,
+    const arma::mat &X,  			                       // data, [T x M]
+    const std::vector< arma::uvec > &rows,           // obs grouped by missingness pattern
+    const std::vector< arma::uvec > &nonmissing_features,
+    arma::mat &lstateprobs
+){
+  for (arma::uword k=0; k<model.size(); k++){
+    emission_ldens(model[k], X, rows, nonmissing_features, lstateprobs, k);
   }
-  return(out);
-  
 }
 
 
 
-// modified multivariate normal density
-// accounts for autocorrelation
-// X must include lagged features
+// workhorse multivariate normal density for basic hmm
+// allows for partial censoring of features
 // [[Rcpp::export]]
-arma::vec dmvnorm_cond(
+arma::vec dmvnorm_cens(
     arma::mat X,  			  // data, [T x M]
     arma::rowvec mu,  	// mean vector, [1 x M]
     arma::mat Sigma, 			// covariance matrix, [M x M]
-    arma::uvec labels_t,  // current features to analyze
-    arma::uvec labels_y,  // past features to condition on
+    arma::uvec missingness_labels_i,  // pattern of missingness features
+    std::vector< arma::uvec > nonmissing_features,
     bool logd = false,		// return logarithm?
     double lambda = 0  		// ridge-like regularization, added to Sigma.diag()
 ){
+  
+  emission_state state = make_emission_state(mu, Sigma, nonmissing_features, lambda);
+  
+  arma::mat out(X.n_rows, 1);
+  emission_ldens(state, X,
+                 rows_by_pattern(missingness_labels_i, nonmissing_features.size()),
+                 nonmissing_features, out, 0);
+  
+  if (logd == false) {
+    out = exp(out);
+  }
+  return(out.col(0));
+  
+}
+
+
+
+// conditional normal density of the current features given the past ones, the part that depends on Sigma only
+struct cond_emission_state {
+  arma::mat coef;                   // Sigma_ty * Sigma_yy^-1: the conditional mean is mu_t + coef * (x_y - mu_y)
+  arma::mat rooti;                  // inverse cholesky factor of the Schur complement of Sigma_yy, lower triangular
+  double rootisum;                  // log det of rooti
+  double constant;                  // -M_t/2 * log(2 pi)
+};
+
+cond_emission_state make_cond_emission_state(
+    arma::mat Sigma, 			    // covariance matrix, [M x M]
+    const arma::uvec &labels_t,   // current features to analyze
+    const arma::uvec &labels_y,   // past features to condition on
+    double lambda = 0  		    // ridge-like regularization, added to Sigma.diag()
+){
   // modified from fast dmvnorm() implementation by Nino Hardt and Dicko Ahmadou
   // http://gallery.rcpp.org/articles/dmvnorm_arma/
   // in turn based on bayesm::dMvn() by Peter Rossi
-
-  arma::uword n = X.n_rows;
-  arma::uword M = X.n_cols;
-
-  arma::vec out(n);
+  
+  cond_emission_state state;
   Sigma.diag() += lambda;  // ridge-like regularization
   
-  arma::mat rooti;
-  double rootisum;
-  double constant;
-
   // t: current frame (today)
   // y: previous frame (yesterday)
   arma::mat Sigma_tt = 
@@ -173,45 +364,85 @@ arma::vec dmvnorm_cond(
     Sigma.submat(labels_y, labels_t);
   arma::mat Sigma_yy = 
     Sigma.submat(labels_y, labels_y);
-  arma::mat Sigma_yy_inv = Sigma_yy.i();
-
+  state.coef = Sigma_ty * Sigma_yy.i();
+  
   // Schur complement of Sigma_yy
   arma::mat Sigma_tt_cond = 
-    Sigma_tt - Sigma_ty * Sigma_yy_inv * Sigma_yt;
-
-  arma::mat mu_cond(labels_t.n_rows, n);
-  for (arma::uword t=0; t<n; t++){
-    arma::rowvec X_row = X.row(t);
-    arma::rowvec X_row_y = X_row.cols(labels_y);
-    arma::vec dev_y = 
-      arma::trans( X_row_y - mu.cols(labels_y) );
-    mu_cond.col(t) = 
-      mu(labels_t) + Sigma_ty * Sigma_yy_inv * dev_y;
-  }  
-
+    Sigma_tt - state.coef * Sigma_yt;
+  
   try {
-    rooti = arma::trans(arma::inv(trimatu(arma::chol(Sigma_tt_cond))));
+    state.rooti = arma::trans(arma::inv(trimatu(arma::chol(Sigma_tt_cond))));
   } catch(std::exception &ex) {
-    Rcpp::Rcout << "failed to invert covariance matrix" << std::endl;
+    // no printing here, the message is reported by the caller
+    std::ostringstream msg;
+    msg << "failed to invert covariance matrix" << std::endl;
     if (Sigma.n_rows > 5){
-      Rcpp::Rcout << "showing Sigma[1:5, 1:5] (after dropping censored features):" << std::endl;
-      Rcpp::Rcout << Sigma_tt_cond.submat(1,1,5,5) << std::endl;
+      msg << "showing Sigma[1:5, 1:5] (after dropping censored features):" << std::endl;
+      msg << Sigma_tt_cond.submat(1,1,5,5) << std::endl;
     } else {
-      Rcpp::Rcout << Sigma_tt_cond << std::endl;
+      msg << Sigma_tt_cond << std::endl;
     }
-    forward_exception_to_r(ex);
+    msg << ex.what();
+    throw std::runtime_error(msg.str());
   }
-  rootisum = arma::sum(log(rooti.diag()));
-  constant = -(static_cast<double>(labels_t.n_rows/2.0)) * log2pi;
+  state.rootisum = arma::sum(log(state.rooti.diag()));
+  state.constant = -(static_cast<double>(labels_t.n_rows/2.0)) * log2pi;
+  return state;
+}
+
+// conditional log densities of all rows of X in the state with mean mu
+arma::vec cond_emission_ldens(
+    const cond_emission_state &state,
+    const arma::mat &X,  			  // data, [T x M]
+    const arma::rowvec &mu,  	  // mean vector, [1 x M]
+    const arma::uvec &labels_t,
+    const arma::uvec &labels_y
+){
+  arma::mat dev_t = X.cols(labels_t);
+  dev_t.each_row() -= mu.cols(labels_t);
+  arma::mat dev_y = X.cols(labels_y);
+  dev_y.each_row() -= mu.cols(labels_y);
   
-  for (arma::uword t=0; t<n; t++) {
-    arma::rowvec X_row = X.row(t);
-    arma::rowvec X_row_t = X_row.cols(labels_t);
-    arma::vec z = rooti * 
-      (X_row_t.t() - mu_cond.col(t));
-    out(t) = constant - 0.5 * arma::sum(z % z) + rootisum;
+  // row t: rooti * (x_t - conditional mean), as a row
+  arma::mat z = (dev_t - dev_y * state.coef.t()) * state.rooti.t();
+  return state.constant - 0.5 * arma::sum(z % z, 1) + state.rootisum;
+}
+
+// conditional densities of all states, factorized once per set of estimates
+// tied: the states share one factorization
+std::vector<cond_emission_state> make_cond_emission_model(
+    const arma::cube &Sigmas,			           // state-specific vcov matrices: rows/cols=covariates, slices=state
+    const arma::uvec &labels_t,
+    const arma::uvec &labels_y,
+    double lambda,
+    cov_structure covariance = cov_full
+){
+  std::vector<cond_emission_state> model;
+  for (arma::uword k=0; k<Sigmas.n_slices; k++){
+    if (covariance == cov_tied && k > 0){
+      model.push_back(model[0]);
+    } else {
+      model.push_back(make_cond_emission_state(Sigmas.slice(k), labels_t, labels_y, lambda));
+    }
   }
+  return model;
+}
 
+// modified multivariate normal density
+// accounts for autocorrelation
+// X must include lagged features
+// [[Rcpp::export]]
+arma::vec dmvnorm_cond(
+    arma::mat X,  			  // data, [T x M]
+    arma::rowvec mu,  	// mean vector, [1 x M]
+    arma::mat Sigma, 			// covariance matrix, [M x M]
+    arma::uvec labels_t,  // current features to analyze
+    arma::uvec labels_y,  // past features to condition on
+    bool logd = false,		// return logarithm?
+    double lambda = 0  		// ridge-like regularization, added to Sigma.diag()
+){
+  arma::vec out = cond_emission_ldens(make_cond_emission_state(Sigma, labels_t, labels_y, lambda),
+                                      X, mu, labels_t, labels_y);
   if (logd == false) {
     out = exp(out);
   }
@@ -225,58 +456,58 @@ arma::vec dmvnorm_cond(
 // helper HMM functions //
 //////////////////////////
 
-// forward probs: alpha_t * C = Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
-// [[Rcpp::export]]
-arma::mat forward(arma::rowvec delta,		  // initial distribution, [1 x K]
-                  arma::mat Gamma,			  // transition matrix, [K x K]
-                  arma::mat tstateprobs,	// scaled prob that state k generated obs t: Pr(X_t=x_t | Z_t=k) ] / C_t, [T x K]
-                  arma::vec scale         // scaling factor C_t for all t
+// scaled forward probs: alpha.col(t) sums to 1, log Pr(X_1=x_1, ..., X_t=x_t, Z_t=k) = log alpha(k, t) + lscale(t)
+void forward_scaled(const arma::rowvec &delta,		  // initial distribution, [1 x K]
+                    const arma::mat &Gamma,			  // transition matrix, [K x K]
+                    const arma::mat &tstateprobs,	// scaled prob that state k generated obs t: Pr(X_t=x_t | Z_t=k) ] / C_t, [K x T]
+                    const arma::vec &scale,       // scaling factor C_t for all t
+                    arma::mat &alpha,             // scaled forward probs, [K x T]
+                    arma::vec &lscale             // log scale of alpha.col(t)
 ) {
 	
 	arma::uword T = tstateprobs.n_cols;		// number of observations
 	arma::uword K = Gamma.n_rows;			// number of states
 	
-	arma::rowvec alpha_t(K);							// forward probs at t (running product)
-	arma::mat lalpha(K, T);								// log forward probs for each t
+	alpha.set_size(K, T);
+	lscale.set_size(T);
 	
 	arma::vec cumscale = arma::cumsum(scale);
 	
-	alpha_t = delta % tstateprobs.col(0).t();			// calculate forward probs at t=1
-	lalpha.col(0) = log(alpha_t).t() + cumscale(0);					// store log forward probs for t=1
-	
-	double C_t = arma::accu(alpha_t);					// scaling factor to prevent underflow
-	double log_C = log(C_t);							// running sum of log scaling factors
-	alpha_t = alpha_t / C_t;							// scaled forward probs at t=1
+	arma::rowvec alpha_t = delta % tstateprobs.col(0).t();	// calculate forward probs at t=1
+	double log_C = 0;							// running sum of log scaling factors
 	
-	for (arma::uword t=1; t<T; t++){
-		alpha_t = alpha_t * Gamma % tstateprobs.col(t).t();
-		C_t = arma::accu(alpha_t);
+	for (arma::uword t=0; t<T; t++){
+		if (t > 0){
+			alpha_t = alpha_t * Gamma % tstateprobs.col(t).t();
+		}
+		double C_t = arma::accu(alpha_t);		// scaling factor to prevent underflow
 		alpha_t = alpha_t / C_t;
 		log_C += log(C_t);
-		lalpha.col(t) = log(alpha_t).t() + log_C + cumscale(t);
+		alpha.col(t) = alpha_t.t();
+		lscale(t) = log_C + cumscale(t);
 	}
 	
-	return lalpha;
-	
 }
 
 
 
-// backward probs: beta_t * C = Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k)
-// [[Rcpp::export]]
-arma::mat backward(arma::mat Gamma,		     // transition matrix, [K x K]
-                   arma::mat tstateprobs,	 // scaled prob that state k generated obs t: Pr(X_t=x_t | Z_t=k) / C_t, [K x T]
-                   arma::vec scale         // scaling factor C_t for all t
+// scaled backward probs: log Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k) = log beta(k, t) + lscale(t)
+void backward_scaled(const arma::mat &Gamma,		     // transition matrix, [K x K]
+                     const arma::mat &tstateprobs,	 // scaled prob that state k generated obs t: Pr(X_t=x_t | Z_t=k) / C_t, [K x T]
+                     const arma::vec &scale,         // scaling factor C_t for all t
+                     arma::mat &beta,                // scaled backward probs, [K x T]
+                     arma::vec &lscale               // log scale of beta.col(t)
 ) {
 	
 	arma::uword T = tstateprobs.n_cols;		// number of observations
 	arma::uword K = Gamma.n_rows;			// number of states
 	
-	arma::vec beta_t(K);								// backward probs at t (running product)
-	arma::mat lbeta(K, T);								// log backward probs for each t
+	beta.set_size(K, T);
+	lscale.set_size(T);
 	
-	beta_t = arma::vec(K, arma::fill::ones);			// set backward probs at t=T
-	lbeta.col(T-1) = log(beta_t);						// store log backward probs for t=T
+	arma::vec beta_t = arma::vec(K, arma::fill::ones);	// set backward probs at t=T
+	beta.col(T-1) = beta_t;
+	lscale(T-1) = 0;
 	
 	arma::vec revscale = arma::flipud(scale);
 	arma::vec revcumscale = arma::flipud(arma::cumsum(revscale));
@@ -290,15 +521,469 @@ arma::mat backward(arma::mat Gamma,		     // transition matrix, [K x K]
 		C_t = arma::accu(beta_t);
 		beta_t = beta_t / C_t;
 		log_C += log(C_t);
-		lbeta.col(t-1) = log(beta_t) + log_C + revcumscale(t);
+		beta.col(t-1) = beta_t;
+		lscale(t-1) = log_C + revcumscale(t);
 	}
 	
+}
+
+
+
+// forward probs: alpha_t * C = Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
+// [[Rcpp::export]]
+arma::mat forward(arma::rowvec delta,		  // initial distribution, [1 x K]
+                  arma::mat Gamma,			  // transition matrix, [K x K]
+                  arma::mat tstateprobs,	// scaled prob that state k generated obs t: Pr(X_t=x_t | Z_t=k) ] / C_t, [T x K]
+                  arma::vec scale         // scaling factor C_t for all t
+) {
+	
+	arma::mat alpha;
+	arma::vec lscale;
+	forward_scaled(delta, Gamma, tstateprobs, scale, alpha, lscale);
+	
+	arma::mat lalpha = log(alpha);						// log forward probs for each t
+	lalpha.each_row() += lscale.t();
+	return lalpha;
+	
+}
+
+
+
+// backward probs: beta_t * C = Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k)
+// [[Rcpp::export]]
+arma::mat backward(arma::mat Gamma,		     // transition matrix, [K x K]
+                   arma::mat tstateprobs,	 // scaled prob that state k generated obs t: Pr(X_t=x_t | Z_t=k) / C_t, [K x T]
+                   arma::vec scale         // scaling factor C_t for all t
+) {
+	
+	arma::mat beta;
+	arma::vec lscale;
+	backward_scaled(Gamma, tstateprobs, scale, beta, lscale);
+	
+	arma::mat lbeta = log(beta);							// log backward probs for each t
+	lbeta.each_row() += lscale.t();
 	return lbeta;
 	
 }
 
 
 
+// expected transition counts of one obs seq, sum_t Pr(Z_t=k1, Z_{t+1}=k2 | data) / Gamma(k1, k2), [K x K]
+// on the scaled probs the summand is alpha(k1, t) * tstateprobs(k2, t+1) * beta(k2, t+1) * w_t,
+// with one weight w_t = exp(lalpha_scale(t) + scale(t+1) + lbeta_scale(t+1) - llh) per obs,
+// so the sum over t is a single [K x T] * [T x K] matrix product
+arma::mat transition_counts(const arma::mat &alpha,           // scaled forward probs, [K x T]
+                            const arma::vec &lalpha_scale,
+                            const arma::mat &beta,            // scaled backward probs, [K x T]
+                            const arma::vec &lbeta_scale,
+                            const arma::mat &tstateprobs,     // scaled state probs, [K x T]
+                            const arma::vec &scale,
+                            double llh
+) {
+	
+	arma::uword T = alpha.n_cols;
+	
+	arma::rowvec w = exp(lalpha_scale.head(T-1) + scale.tail(T-1) + lbeta_scale.tail(T-1) - llh).t();
+	arma::mat alpha_w = alpha.cols(0, T-2);
+	alpha_w.each_row() %= w;
+	
+	return alpha_w * (tstateprobs.cols(1, T-1) % beta.cols(1, T-1)).t();
+	
+}
+
+
+
+//////////////////////////////////////
+// sufficient statistics of M-step  //
+//////////////////////////////////////
+
+// weighted first and second moments of the obs in every state
+// moments are taken around a fixed shift per state (the current means) to limit cancellation,
+// statistics over disjoint sets of obs seqs are combined with merge()
+struct moment_stats {
+  arma::mat shift;         // [M x K]
+  arma::vec zeta_sums;     // [K] sum of weight * zeta
+  arma::mat s1;            // [M x K] sum of weight * zeta * (x - shift)
+  arma::cube s2;           // [M x M x K] sum of weight * zeta * (x - shift)(x - shift)^T
+  bool diagonal = false;   // accumulate only the diagonal of s2
+  
+  void reset(const arma::mat &shift_, bool diagonal_ = false){
+    shift = shift_;
+    diagonal = diagonal_;
+    zeta_sums.zeros(shift.n_cols);
+    s1.zeros(shift.n_rows, shift.n_cols);
+    s2.zeros(shift.n_rows, shift.n_rows, shift.n_cols);
+  }
+  
+  // X: obs of one seq [T x M], zeta: responsibilities [K x T], weight >= 0
+  void add(const arma::mat &X, const arma::mat &zeta, double weight){
+    for (arma::uword k=0; k<shift.n_cols; k++){
+      arma::vec w = weight * zeta.row(k).t();
+      arma::mat Y = X.each_row() - shift.col(k).t();
+      zeta_sums(k) += arma::accu(w);
+      s1.col(k) += Y.t() * w;
+      if (diagonal){
+        s2.slice(k).diag() += (Y % Y).t() * w;
+        continue;
+      }
+      Y.each_col() %= sqrt(w);    // rows scaled by sqrt(weight) so that Y^T Y is a symmetric rank-k update
+      s2.slice(k) += Y.t() * Y;
+    }
+  }
+  
+  // other must use the same shift
+  void merge(const moment_stats &other){
+    zeta_sums += other.zeta_sums;
+    s1 += other.s1;
+    s2 += other.s2;
+  }
+  
+  // multiply all statistics by a (e.g. to blend statistics in stepwise EM)
+  void scale(double a){
+    zeta_sums *= a;
+    s1 *= a;
+    s2 *= a;
+  }
+  
+  // re-express the moments around another shift, d = old shift - new shift:
+  // s1' = s1 + z d,  s2' = s2 + s1 d^T + d s1^T + z d d^T
+  void set_shift(const arma::mat &shift_){
+    for (arma::uword k=0; k<shift.n_cols; k++){
+      arma::vec d = shift.col(k) - shift_.col(k);
+      s2.slice(k) += s1.col(k) * d.t() + d * s1.col(k).t() + zeta_sums(k) * d * d.t();
+      s1.col(k) += zeta_sums(k) * d;
+    }
+    shift = shift_;
+  }
+  
+  arma::mat means() const {
+    arma::mat mus = s1;
+    for (arma::uword k=0; k<shift.n_cols; k++){
+      mus.col(k) = shift.col(k) + s1.col(k) / zeta_sums(k);
+    }
+    return mus;
+  }
+  
+  arma::cube covs() const {
+    arma::cube Sigmas(s2.n_rows, s2.n_cols, s2.n_slices);
+    for (arma::uword k=0; k<shift.n_cols; k++){
+      arma::vec dev = s1.col(k) / zeta_sums(k);   // mean - shift
+      Sigmas.slice(k) = s2.slice(k) / zeta_sums(k) - dev * dev.t();
+      if (diagonal){
+        Sigmas.slice(k) = arma::diagmat(Sigmas.slice(k));
+      }
+    }
+    return Sigmas;
+  }
+};
+
+
+
+////////////////////////////////////////
+// checkpointed forward-backward       //
+////////////////////////////////////////
+
+// state probs of obs [t0, t1) of one seq: lstateprobs [L x K], scale and tstateprobs [K x L] as in hmm_cpp
+void segment_stateprobs(
+    const std::vector<emission_state> &emission,
+    const arma::mat &X,  			                       // data, [T x M]
+    const arma::uvec &missingness_labels_i,
+    const std::vector< arma::uvec > &nonmissing_features,
+    arma::uword t0,
+    arma::uword t1,
+    arma::mat &lstateprobs,
+    arma::vec &scale,
+    arma::mat &tstateprobs
+){
+  lstateprobs.set_size(t1 - t0, emission.size());
+  emission_lstateprobs(emission, X.rows(t0, t1-1),
+                       rows_by_pattern(missingness_labels_i.subvec(t0, t1-1), nonmissing_features.size()),
+                       nonmissing_features, lstateprobs);
+  scale = arma::max(lstateprobs, 1);
+  tstateprobs = exp(lstateprobs.each_col() - scale).t();
+}
+
+// scaled forward probs of obs [t0, t1), continuing from alpha_t/lscale_t at t0-1 (or from delta if t0 = 0)
+void segment_forward(
+    const arma::rowvec &delta,
+    const arma::mat &Gamma,
+    const arma::mat &tstateprobs,       // [K x L]
+    const arma::vec &scale,
+    arma::uword t0,
+    arma::rowvec &alpha_t,              // in: alpha at t0-1, out: alpha at t1-1
+    double &lscale_t,
+    arma::mat *alpha,                   // if not nullptr: alpha of every obs in the segment, [K x L]
+    arma::vec *lscale
+){
+  arma::uword L = tstateprobs.n_cols;
+  for (arma::uword l=0; l<L; l++){
+    if (t0 + l == 0){
+      alpha_t = delta % tstateprobs.col(0).t();
+    } else {
+      alpha_t = alpha_t * Gamma % tstateprobs.col(l).t();
+    }
+    double C_t = arma::accu(alpha_t);
+    alpha_t = alpha_t / C_t;
+    lscale_t += log(C_t) + scale(l);
+    if (alpha != nullptr){
+      alpha->col(l) = alpha_t.t();
+      (*lscale)(l) = lscale_t;
+    }
+  }
+}
+
+// E-step of one obs seq with memory O(K sqrt(T)) besides the data:
+// the forward pass keeps alpha only at the end of every segment of about sqrt(T) obs,
+// the backward pass recomputes the state probs and alpha one segment at a time and streams
+// the responsibilities of the segment into the transition counts and moments right away
+// returns the log-likelihood of the seq
+double estep_checkpointed(
+    const std::vector<emission_state> &emission,
+    const arma::mat &X,  			                       // data, [T x M]
+    const arma::uvec &missingness_labels_i,          // pattern of missingness features
+    const std::vector< arma::uvec > &nonmissing_features,
+    const arma::uvec &nonmissing_i,                  // indices of obs with no missingness, sorted
+    const arma::rowvec &delta,                       // initial distribution
+    const arma::mat &Gamma,
+    const arma::mat *zeta_fixed,                     // responsibilities if supervised, else nullptr
+    double weight,
+    arma::mat &xi_sum,                               // += weight * expected transition counts (before multiplying by Gamma)
+    moment_stats &stats,                             // += weighted moments of the nonmissing obs
+    arma::vec &zeta_first,                           // responsibilities of the first obs
+    arma::mat *zeta_out,                             // if not nullptr: all responsibilities, [K x T]
+    arma::mat *lstateprobs_out                       // if not nullptr: all state probs, [T x K]
+){
+  arma::uword T = X.n_rows;
+  arma::uword K = Gamma.n_rows;
+  arma::uword step = std::max<arma::uword>(1, static_cast<arma::uword>(std::ceil(std::sqrt(static_cast<double>(T)))));
+  arma::uword nseg = (T + step - 1) / step;
+  
+  arma::mat lstateprobs;
+  arma::vec scale;
+  arma::mat tstateprobs;
+  
+  // forward pass, alpha kept at the last obs of each segment
+  arma::mat ckpt_alpha(K, nseg);
+  arma::vec ckpt_lscale(nseg);
+  arma::rowvec alpha_t = delta;
+  double lscale_t = 0;
+  for (arma::uword sg=0; sg<nseg; sg++){
+    arma::uword t0 = sg * step;
+    arma::uword t1 = std::min(T, t0 + step);
+    segment_stateprobs(emission, X, missingness_labels_i, nonmissing_features, t0, t1, lstateprobs, scale, tstateprobs);
+    segment_forward(delta, Gamma, tstateprobs, scale, t0, alpha_t, lscale_t, nullptr, nullptr);
+    ckpt_alpha.col(sg) = alpha_t.t();
+    ckpt_lscale(sg) = lscale_t;
+  }
+  double llh = lscale_t;  // alpha.col(T-1) sums to 1
+  
+  // backward pass, segment by segment from the end
+  // carried from the segment after the current one: tstateprobs % beta of its first obs and the log scale of that product
+  arma::vec beta_next;
+  double lbeta_next = 0;
+  for (arma::uword sg=nseg; sg-- > 0; ){
+    arma::uword t0 = sg * step;
+    arma::uword t1 = std::min(T, t0 + step);
+    arma::uword L = t1 - t0;
+    segment_stateprobs(emission, X, missingness_labels_i, nonmissing_features, t0, t1, lstateprobs, scale, tstateprobs);
+    
+    arma::mat alpha(K, L);
+    arma::vec lalpha_scale(L);
+    if (sg > 0){
+      alpha_t = ckpt_alpha.col(sg-1).t();
+      lscale_t = ckpt_lscale(sg-1);
+    }
+    segment_forward(delta, Gamma, tstateprobs, scale, t0, alpha_t, lscale_t, &alpha, &lalpha_scale);
+    
+    arma::mat beta(K, L);
+    arma::mat beta_w(K, L, arma::fill::zeros);   // transition t -> t+1: tstateprobs % beta of obs t+1
+    arma::vec w(L, arma::fill::zeros);           // transition t -> t+1: weight, as in transition_counts
+    for (arma::uword l=L; l-- > 0; ){
+      arma::uword t = t0 + l;
+      arma::vec beta_t;
+      double lbeta_t;
+      if (t == T-1){
+        beta_t = arma::vec(K, arma::fill::ones);
+        lbeta_t = 0;
+      } else {
+        beta_w.col(l) = beta_next;
+        w(l) = exp(lalpha_scale(l) + lbeta_next - llh);
+        beta_t = Gamma * beta_next;
+        double C_t = arma::accu(beta_t);
+        beta_t = beta_t / C_t;
+        lbeta_t = lbeta_next + log(C_t);
+      }
+      beta.col(l) = beta_t;
+      beta_next = tstateprobs.col(l) % beta_t;
+      lbeta_next = lbeta_t + scale(l);
+    }
+    
+    // E-step (transitions)
+    arma::mat alpha_w = alpha;
+    alpha_w.each_row() %= w.t();
+    xi_sum += weight * (alpha_w * beta_w.t());
+    
+    // E-step (states)
+    arma::mat zeta;
+    if (zeta_fixed != nullptr){
+      zeta = zeta_fixed->cols(t0, t1-1);
+    } else {
+      zeta = alpha % beta;
+      zeta.each_row() /= arma::sum(zeta, 0);
+    }
+    if (sg == 0){
+      zeta_first = zeta.col(0);
+    }
+    
+    // weighted moments of the nonmissing obs in the segment
+    const arma::uword *lo = std::lower_bound(nonmissing_i.begin(), nonmissing_i.end(), t0);
+    const arma::uword *hi = std::lower_bound(lo, nonmissing_i.end(), t1);
+    if (hi > lo){
+      arma::uvec rows = nonmissing_i.subvec(lo - nonmissing_i.begin(), hi - nonmissing_i.begin() - 1);
+      stats.add(X.rows(rows), zeta.cols(rows - t0), weight);
+    }
+    
+    if (zeta_out != nullptr){
+      zeta_out->cols(t0, t1-1) = zeta;
+    }
+    if (lstateprobs_out != nullptr){
+      lstateprobs_out->rows(t0, t1-1) = lstateprobs;
+    }
+  }
+  
+  return llh;
+}
+
+
+
+////////////////////////////////////
+// parallel loop over obs seqs    //
+////////////////////////////////////
+
+// number of threads used for N obs seqs (nthreads = 0: one per core)
+arma::uword n_seq_threads(arma::uword N, arma::uword nthreads){
+  if (nthreads == 0){
+    nthreads = std::thread::hardware_concurrency();
+  }
+  return std::max<arma::uword>(1, std::min(nthreads, N));
+}
+
+// worker threads kept for the whole fit, so the loops of every EM iteration reuse them
+// run(n, task) calls task(j) for j < n, task(0) on the calling thread and task(j) on worker j,
+// and returns when all are done; the first error is rethrown on the calling thread
+class seq_pool {
+public:
+  explicit seq_pool(arma::uword nthreads) : n_threads(std::max<arma::uword>(1, nthreads)), errors(n_threads){
+    for (arma::uword j=1; j<n_threads; j++){
+      workers.emplace_back([this, j](){ work(j); });
+    }
+  }
+  ~seq_pool(){
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stop = true;
+    }
+    start.notify_all();
+    for (std::thread &w : workers){
+      w.join();
+    }
+  }
+  seq_pool(const seq_pool &) = delete;
+  seq_pool & operator=(const seq_pool &) = delete;
+
+  arma::uword size() const { return n_threads; }
+
+  void run(arma::uword n, const std::function<void(arma::uword)> &task){
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      current = &task;
+      n_tasks = n;
+      pending = n_threads - 1;
+      std::fill(errors.begin(), errors.end(), nullptr);
+      generation++;
+    }
+    start.notify_all();
+    try {
+      task(0);
+    } catch(...) {
+      errors[0] = std::current_exception();
+    }
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      done.wait(lock, [this](){ return pending == 0; });
+      current = nullptr;
+    }
+    for (std::exception_ptr &e : errors){
+      if (e){
+        std::rethrow_exception(e);
+      }
+    }
+  }
+
+private:
+  void work(arma::uword j){
+    unsigned long seen = 0;
+    while (true){
+      const std::function<void(arma::uword)> *task;
+      arma::uword n;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        start.wait(lock, [this, seen](){ return stop || generation != seen; });
+        if (stop){
+          return;
+        }
+        seen = generation;
+        task = current;
+        n = n_tasks;
+      }
+      if (j < n){
+        try {
+          (*task)(j);
+        } catch(...) {
+          errors[j] = std::current_exception();
+        }
+      }
+      std::lock_guard<std::mutex> lock(mtx);
+      if (--pending == 0){
+        done.notify_one();
+      }
+    }
+  }
+
+  arma::uword n_threads;
+  std::vector<std::exception_ptr> errors;
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::condition_variable start, done;
+  const std::function<void(arma::uword)> *current = nullptr;
+  arma::uword n_tasks = 0;
+  arma::uword pending = 0;
+  unsigned long generation = 0;
+  bool stop = false;
+};
+
+// calls body(i, j) for every obs seq i, j is the thread running it
+// thread j always gets the same contiguous block of obs seqs, so per-thread partial sums
+// reduced in thread order give the same result in every run (and the serial result for 1 thread)
+// body must not touch the R API; the first error is rethrown on the calling thread
+template <typename Body>
+void for_each_seq(seq_pool &pool, arma::uword N, Body body){
+  arma::uword nthreads = std::min(pool.size(), N);
+  if (nthreads <= 1){
+    for (arma::uword i=0; i<N; i++){
+      body(i, 0);
+    }
+    return;
+  }
+  pool.run(nthreads, [&body, N, nthreads](arma::uword j){
+    for (arma::uword i=j*N/nthreads; i<(j+1)*N/nthreads; i++){
+      body(i, j);
+    }
+  });
+}
+
+
+
 //////////////////////////////////////////////
 // train HMM on multiple observation chains //
 //////////////////////////////////////////////
@@ -320,8 +1005,18 @@ Rcpp::List hmm_cpp(
   arma::uword maxiter = 100,		       // ... or after maxiter iterations
   double uncollapse = 0,			         // randomly reset collapsing (small-volume) components, i.e. det(Sigma) < uncollapse
   bool verbose = true,				         // status updates
-  bool supervised = false
+  bool supervised = false,
+  arma::uword nthreads = 1,            // threads for the E-step and M-step sums over obs seqs (0 = one per core)
+  bool checkpoint = false,             // checkpointed forward-backward: memory O(K sqrt(T)) per obs seq instead of O(K T)
+  int return_posteriors = -1,          // return lstateprobs and zetas: 1 = yes, 0 = no, -1 = only without checkpoint
+  std::string covariance = "full",     // structure of the state cov mats: "full", "diagonal" or "tied"
+  Rcpp::Nullable<Rcpp::List> deltas_init = R_NilValue  // initial distribution of each obs seq (default: delta_init for all)
 ){
+  
+  // posteriors of a checkpointed fit cost an extra E-step and O(K T) memory per obs seq, so they are opt-in there
+  if (return_posteriors < 0){
+    return_posteriors = !checkpoint;
+  }
 	
   arma::uword N = Xs.size();				// number of observation sequences
   std::vector<arma::uword> Ts;			// number of observations in each obs sequence
@@ -332,28 +1027,59 @@ Rcpp::List hmm_cpp(
   arma::uword K = Gamma_init.n_rows;		// number of states
 	
   // for obs seq i: rows=states, cols=time
-  std::vector<arma::mat> lalphas;
-  std::vector<arma::mat> lbetas;
+  std::vector<arma::mat> alphas;
+  std::vector<arma::mat> betas;
   std::vector<arma::mat> zetas;
+  std::vector<arma::vec> lalpha_scales;
+  std::vector<arma::vec> lbeta_scales;
+  std::vector<arma::mat> xi_sums;
+	
+  std::vector<arma::rowvec> deltas(N, delta_init);
+  if (deltas_init.isNotNull()){
+    deltas = Rcpp::as< std::vector<arma::rowvec> >(deltas_init.get());
+    if (deltas.size() != N){
+      Rcpp::stop("deltas_init must hold one initial distribution per obs seq");
+    }
+  }
 	
   if (supervised){
     zetas = zetas_init;
-  } else {
+  } else if (!checkpoint){
     for (arma::uword i=0; i<N; i++){
       zetas.push_back(arma::mat(K, Ts[i]));		// responsibilities: E[Z_t=k | data]
-      zetas[i].col(0) = delta_init.t();		  	// initial state distribution
+      zetas[i].col(0) = deltas[i].t();		  	// initial state distribution
     }
   }
 	
   // for obs seq i: rows=time, cols=states
   std::vector<arma::mat> lstateprobs;
 	
-  for (arma::uword i=0; i<N; i++){
-    lalphas.push_back(arma::mat(K, Ts[i]));		// forward probs: Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
-    lbetas.push_back(arma::mat(K, Ts[i]));		// backward probs: Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k)
+  // checkpointed forward-backward: only the responsibilities of the first obs (initial distribution) are kept
+  std::vector<arma::vec> zeta_firsts;
+  std::vector<arma::vec> zeta_firsts_new(checkpoint ? N : 0);
+  std::vector<arma::uvec> nonmissing_sorted;
+  if (checkpoint){
+    for (arma::uword i=0; i<N; i++){
+      zeta_firsts.push_back(supervised ? arma::vec(zetas[i].col(0)) : arma::vec(deltas[i].t()));
+      nonmissing_sorted.push_back(arma::sort(nonmissing[i]));
+    }
+  }
+	
+  for (arma::uword i=0; i<N && !checkpoint; i++){
+    alphas.push_back(arma::mat(K, Ts[i]));		// scaled forward probs: Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
+    betas.push_back(arma::mat(K, Ts[i]));		// scaled backward probs: Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k)
+    lalpha_scales.push_back(arma::vec(Ts[i]));
+    lbeta_scales.push_back(arma::vec(Ts[i]));
+    xi_sums.push_back(arma::mat(K, K));		// expected transition counts
     lstateprobs.push_back(arma::mat(Ts[i], K));	// prob that state k generated obs t: Pr(X_t=x_t | Z_t=k)
   }
 	
+  // obs grouped by missingness pattern, fixed over all iterations
+  std::vector< std::vector< arma::uvec > > pattern_rows;
+  for (arma::uword i=0; i<N && !checkpoint; i++){
+    pattern_rows.push_back(rows_by_pattern(missingness_labels[i], nonmissing_features.size()));
+  }
+	
   // track log-likelihood
   std::vector<double> llh_seq;
   llh_seq.push_back(-std::numeric_limits<double>::infinity());
@@ -371,11 +1097,19 @@ Rcpp::List hmm_cpp(
   for (arma::uword k=0; k<K; k++){
     Sigmas.slice(k) = Sigmas_init[k];
   }
+  cov_structure cov = parse_covariance(covariance);
+  constrain_covs(Sigmas, arma::ones<arma::vec>(K), cov);
 	
   // resetting collapsed states
   double log_uncollapse = log(uncollapse);
   int resets = 0;
 	
+  // per-thread partial sums of the M-step, reduced in thread order
+  nthreads = n_seq_threads(N, nthreads);
+  seq_pool pool(nthreads);
+  std::vector<arma::mat> Gamma_parts(nthreads);
+  std::vector<moment_stats> stats_parts(nthreads);
+	
   // EM algorithm
   for (arma::uword iter=0; iter<maxiter; iter++){
 	  
@@ -392,7 +1126,7 @@ Rcpp::List hmm_cpp(
               Rcpp::Rcout << "collapsed state detected; resetting" << std::endl;
             }
             mus.col(k) = arma::randn(M);					        // redraw state mean from std diag multivariate normal
-            Sigmas.slice(k) = arma::eye<arma::mat>(M, M);	// reset state cov mat to unit sphere
+            reset_cov(Sigmas, k, cov);					          // reset state cov mat to unit sphere
           }
         }
       }
@@ -402,36 +1136,46 @@ Rcpp::List hmm_cpp(
       Rcpp::Rcout << "iter " << iter + 1 << ": ";
     }
 	
-    for (arma::uword i=0; i<N; i++){
+    // factorize the state cov mats once for all obs seqs
+    std::vector<emission_state> emission = 
+      make_emission_model(mus, Sigmas, nonmissing_features, lambda, cov);
+	
+    for (arma::uword j=0; j<nthreads; j++){
+      Gamma_parts[j].zeros(K, K);
+      stats_parts[j].reset(mus, cov == cov_diagonal);
+    }
+    
+    if (checkpoint){
+      // single pass: E-step statistics are streamed into the M-step sums, which are dropped if EM stops here
+      for_each_seq(pool, N, [&](arma::uword i, arma::uword j){
+        llhs(i) = estep_checkpointed(emission, Xs[i], missingness_labels[i], nonmissing_features, nonmissing_sorted[i],
+                                     zeta_firsts[i].t(), Gamma, supervised ? &zetas[i] : nullptr, weights(i),
+                                     Gamma_parts[j], stats_parts[j], zeta_firsts_new[i], nullptr, nullptr);
+      });
+    } else {
+      for_each_seq(pool, N, [&](arma::uword i, arma::uword j){
 		
-      // state probs Pr[X_t=x | Z_t=k, mus, Sigmas]: loop over clusters, plug X into dmvnorm for each
-      for (arma::uword k=0; k<K; k++){
-        // if (verbose){
-        //   Rcpp::Rcout << "calculating log probs of obs seq " << (i+1) << " in state " << (k+1) << std::endl;
-        // }// debug
-        lstateprobs[i].col(k) = 
-          dmvnorm_cens(Xs[i],
-                       mus.col(k).t(), Sigmas.slice(k),
-                       missingness_labels[i],
-                       nonmissing_features,
-                       true, lambda);
-        // Rcpp::Rcout << lstateprobs[i].col(k) << std::endl; // debug
-      }
+        // state probs Pr[X_t=x | Z_t=k, mus, Sigmas]
+        emission_lstateprobs(emission, Xs[i], pattern_rows[i], nonmissing_features, lstateprobs[i]);
 			
-      arma::vec scale = arma::max(lstateprobs[i], 1); // pseudocode: get max{ log Pr( X_t=x_t | Z_t=k ) : all k }
-      arma::mat lstateprobs_scaled = lstateprobs[i];
-      for (arma::uword k=0; k<K; k++){
-        lstateprobs_scaled.col(k) -= scale;
-      }
-      arma::mat tstateprobs = exp(lstateprobs_scaled).t();	// t() for faster column access in forward/backward probs
+        arma::vec scale = arma::max(lstateprobs[i], 1); // pseudocode: get max{ log Pr( X_t=x_t | Z_t=k ) : all k }
+        arma::mat lstateprobs_scaled = lstateprobs[i];
+        for (arma::uword k=0; k<K; k++){
+          lstateprobs_scaled.col(k) -= scale;
+        }
+        arma::mat tstateprobs = exp(lstateprobs_scaled).t();	// t() for faster column access in forward/backward probs
 		  
-      // convert to working parameters: forward, backward probs
-      lalphas[i] = forward(zetas[i].col(0).t(), Gamma, tstateprobs, scale);
-      lbetas[i] = backward(Gamma, tstateprobs, scale);
+        // convert to working parameters: forward, backward probs
+        forward_scaled(zetas[i].col(0).t(), Gamma, tstateprobs, scale, alphas[i], lalpha_scales[i]);
+        backward_scaled(Gamma, tstateprobs, scale, betas[i], lbeta_scales[i]);
 			
-      double log_C_i = max(lalphas[i].col(Ts[i]-1));
-      llhs(i) = log(arma::accu(exp(lalphas[i].col(Ts[i]-1) - log_C_i))) + log_C_i;
+        llhs(i) = lalpha_scales[i](Ts[i]-1);  // alphas[i].col(T-1) sums to 1
+      
+        // E-step (transitions), kept until the convergence check is passed
+        xi_sums[i] = transition_counts(alphas[i], lalpha_scales[i], betas[i], lbeta_scales[i],
+                                       tstateprobs, scale, llhs(i));
 			
+      });
     }
 	
     double llh = arma::accu(llhs);
@@ -449,39 +1193,34 @@ Rcpp::List hmm_cpp(
       Rprintf("log-likelihood of %f\n", llh);
     }
 		
-    arma::mat Gamma_old = Gamma;	// store old transition matrix
-    Gamma.zeros();					// reset all elements to zero
-    for (arma::uword i=0; i<N; i++){
+    if (checkpoint){
+      zeta_firsts.swap(zeta_firsts_new);
+    } else {
+      for_each_seq(pool, N, [&](arma::uword i, arma::uword j){
 		
-      // E-step (states)
+        // E-step (states)
 			
-      if (!supervised){
-        zetas[i] = exp(lalphas[i] + lbetas[i] - llhs(i)); // zeta[k, t]: E[Z_t=k | data]
-        for (arma::uword t=0; t<Ts[i]; t++){ 
-          double zetas_normalize = arma::accu(zetas[i].col(t));
-          zetas[i].col(t) /= zetas_normalize; // normalize state memberships of each obs
+        if (!supervised){
+          zetas[i] = alphas[i] % betas[i]; // zeta[k, t]: E[Z_t=k | data], up to the scale of obs t
+          zetas[i].each_row() /= arma::sum(zetas[i], 0); // normalize state memberships of each obs
         }
-      }
 			
-      // E-step (transitions)
-
-      arma::mat lstateprobs_dropfirst = lstateprobs[i].submat(arma::span(1, Ts[i]-1), arma::span::all);
-      arma::mat lalpha_droplast = lalphas[i].submat(arma::span::all, arma::span(0, Ts[i]-2));
-      lalpha_droplast = lalpha_droplast.t();
-      arma::mat lbeta_dropfirst = lbetas[i].submat(arma::span::all, arma::span(1, Ts[i]-1));
-      lbeta_dropfirst = lbeta_dropfirst.t();
-		
-      for (arma::uword k1=0; k1<K; k1++){
-        for (arma::uword k2=0; k2<K; k2++){
-          Gamma(k1, k2) += weights(i) *
-            arma::accu(exp(lalpha_droplast.col(k1) 
-                           + lstateprobs_dropfirst.col(k2) 
-                           + lbeta_dropfirst.col(k2) 
-                           - llhs(i)
-                           ));
-        }
-      }
+        // E-step (transitions)
+        Gamma_parts[j] += weights(i) * xi_sums[i];
+      
+        // weighted moments by responsibility for the M-step (ignore partially censored obs)
+        stats_parts[j].add(Xs[i].rows(nonmissing[i]), zetas[i].cols(nonmissing[i]), weights(i));
 
+      });
+    }
+    
+    arma::mat Gamma_old = Gamma;	// store old transition matrix
+    Gamma.zeros();					// reset all elements to zero
+    for (arma::uword j=0; j<nthreads; j++){
+      Gamma += Gamma_parts[j];
+    }
+    for (arma::uword j=1; j<nthreads; j++){
+      stats_parts[0].merge(stats_parts[j]);
     }
     Gamma = Gamma % Gamma_old;
 		
@@ -490,36 +1229,10 @@ Rcpp::List hmm_cpp(
       Gamma.row(k) /= arma::accu(Gamma.row(k));
     }
 		
-    // M-step (mu_k)
-    mus.zeros();		// reset all elements to zero
-    arma::vec zeta_sums(K, arma::fill::zeros);
-		
-    // weighted sum by responsibility (ignore partially censored obs)
-    for (arma::uword i=0; i<N; i++){
-      mus += weights(i) * (zetas[i].cols(nonmissing[i]) * Xs[i].rows(nonmissing[i])).t();
-      zeta_sums += weights(i) * arma::sum(zetas[i].cols(nonmissing[i]), 1);
-    }
-		
-    // divide by effective number of obs (ignore partially censored obs)
-    for (arma::uword k=0; k<K; k++){
-      mus.col(k) /= zeta_sums(k);
-    }
-		
-    // M-step (Sigma_k)
-    Sigmas.zeros();		// reset all elements to zero
-		
-    // weighted variance by responsibility (ignore partially censored obs)
-    for (arma::uword k=0; k<K; k++){
-      for (arma::uword i=0; i<N; i++){
-        arma::mat X_demean = Xs[i].rows(nonmissing[i]);
-        for (arma::uword m=0; m<M; m++){
-          X_demean.col(m) -= mus(m, k);
-        }
-        arma::rowvec zetas_ik = zetas[i].row(k) ;
-        Sigmas.slice(k) += weights(i) * X_demean.t() * arma::diagmat(zetas_ik(nonmissing[i])) * X_demean;
-      }
-      Sigmas.slice(k) /= zeta_sums(k);
-    }
+    // M-step (mu_k, Sigma_k): weighted mean and variance by responsibility (ignore partially censored obs)
+    mus = stats_parts[0].means();
+    Sigmas = stats_parts[0].covs();
+    constrain_covs(Sigmas, stats_parts[0].zeta_sums, cov);
 		
     if (verbose){
       if (iter == maxiter - 1){
@@ -529,8 +1242,32 @@ Rcpp::List hmm_cpp(
 		
   }
 	
+  // checkpointed forward-backward: one more E-step pass under the final estimates for the returned posteriors
+  // (unlike the plain path, whose lstateprobs and zetas are left from the last E-step(s) of the loop, i.e. from
+  // the estimates before the last M-step; the returned parameters and llh_seq are the same in both modes)
+  if (checkpoint && return_posteriors){
+    std::vector<emission_state> emission = 
+      make_emission_model(mus, Sigmas, nonmissing_features, lambda, cov);
+    for (arma::uword i=0; i<N; i++){
+      lstateprobs.push_back(arma::mat(Ts[i], K));
+      if (!supervised){
+        zetas.push_back(arma::mat(K, Ts[i]));
+      }
+    }
+    for (arma::uword j=0; j<nthreads; j++){
+      Gamma_parts[j].zeros(K, K);
+      stats_parts[j].reset(mus, cov == cov_diagonal);
+    }
+    for_each_seq(pool, N, [&](arma::uword i, arma::uword j){
+      estep_checkpointed(emission, Xs[i], missingness_labels[i], nonmissing_features, nonmissing_sorted[i],
+                         zeta_firsts[i].t(), Gamma, supervised ? &zetas[i] : nullptr, weights(i),
+                         Gamma_parts[j], stats_parts[j], zeta_firsts_new[i],
+                         supervised ? nullptr : &zetas[i], &lstateprobs[i]);
+    });
+  }
+	
   Rcpp::List lstateprobs_out;
-  for (arma::uword i=0; i<N; i++){
+  for (arma::uword i=0; i<N && return_posteriors; i++){
     lstateprobs_out.push_back(lstateprobs[i]);
   }
 	
@@ -543,7 +1280,7 @@ Rcpp::List hmm_cpp(
   }
 	
   Rcpp::List zetas_out;
-  for (arma::uword i=0; i<N; i++){
+  for (arma::uword i=0; i<N && return_posteriors; i++){
     zetas_out.push_back(zetas[i]);
   }
 
@@ -578,7 +1315,9 @@ Rcpp::List hmm_autocorr_cpp(
   arma::uword maxiter = 100,		       // ... or after maxiter iterations
   double uncollapse = 0,			         // randomly reset collapsing (small-volume) components, i.e. det(Sigma) < uncollapse
   bool verbose = true,				         // status updates
-  bool supervised = false
+  bool supervised = false,
+  arma::uword nthreads = 1,            // threads for the E-step and M-step sums over obs seqs (0 = one per core)
+  std::string covariance = "full"      // structure of the state cov mats: "full", "diagonal" or "tied"
 ){
 	
   arma::uword N = Xs.size();				// number of observation sequences
@@ -590,9 +1329,12 @@ Rcpp::List hmm_autocorr_cpp(
   arma::uword K = Gamma_init.n_rows;		// number of states
 	
   // for obs seq i: rows=states, cols=time
-  std::vector<arma::mat> lalphas;
-  std::vector<arma::mat> lbetas;
+  std::vector<arma::mat> alphas;
+  std::vector<arma::mat> betas;
   std::vector<arma::mat> zetas;
+  std::vector<arma::vec> lalpha_scales;
+  std::vector<arma::vec> lbeta_scales;
+  std::vector<arma::mat> xi_sums;
 	
   if (supervised){
     zetas = zetas_init;
@@ -607,8 +1349,11 @@ Rcpp::List hmm_autocorr_cpp(
   std::vector<arma::mat> lstateprobs;
 	
   for (arma::uword i=0; i<N; i++){
-    lalphas.push_back(arma::mat(K, Ts[i]));		// forward probs: Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
-    lbetas.push_back(arma::mat(K, Ts[i]));		// backward probs: Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k)
+    alphas.push_back(arma::mat(K, Ts[i]));		// scaled forward probs: Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
+    betas.push_back(arma::mat(K, Ts[i]));		// scaled backward probs: Pr(X_{t+1}=x_{t+1}, ..., X_T=x_T | Z_t=k)
+    lalpha_scales.push_back(arma::vec(Ts[i]));
+    lbeta_scales.push_back(arma::vec(Ts[i]));
+    xi_sums.push_back(arma::mat(K, K));		// expected transition counts
     lstateprobs.push_back(arma::mat(Ts[i], K));	// prob that state k generated obs t: Pr(X_t=x_t | Z_t=k)
   }
 	
@@ -629,11 +1374,19 @@ Rcpp::List hmm_autocorr_cpp(
   for (arma::uword k=0; k<K; k++){
     Sigmas.slice(k) = Sigmas_init[k];
   }
+  cov_structure cov = parse_covariance(covariance);
+  constrain_covs(Sigmas, arma::ones<arma::vec>(K), cov);
 	
   // resetting collapsed states
   double log_uncollapse = log(uncollapse);
   int resets = 0;
 	
+  // per-thread partial sums of the M-step, reduced in thread order
+  nthreads = n_seq_threads(N, nthreads);
+  seq_pool pool(nthreads);
+  std::vector<arma::mat> Gamma_parts(nthreads);
+  std::vector<moment_stats> stats_parts(nthreads);
+	
   // EM algorithm
   for (arma::uword iter=0; iter<maxiter; iter++){
 	  
@@ -650,7 +1403,7 @@ Rcpp::List hmm_autocorr_cpp(
               Rcpp::Rcout << "collapsed state detected; resetting" << std::endl;
             }
             mus.col(k) = arma::randn(M);					        // redraw state mean from std diag multivariate normal
-            Sigmas.slice(k) = arma::eye<arma::mat>(M, M);	// reset state cov mat to unit sphere
+            reset_cov(Sigmas, k, cov);					          // reset state cov mat to unit sphere
           }
         }
       }
@@ -660,18 +1413,27 @@ Rcpp::List hmm_autocorr_cpp(
       Rcpp::Rcout << "iter " << iter + 1 << ": ";
     }
 	
-    for (arma::uword i=0; i<N; i++){
+    // diagonal: the current features are independent of the past ones, so the conditional density
+    // is the diagonal normal density of the current features
+    // full and tied: the conditional densities are factorized once for all obs seqs (once for all states if tied)
+    std::vector<emission_state> emission;
+    std::vector<cond_emission_state> cond_emission;
+    if (cov == cov_diagonal){
+      emission = make_emission_model(mus, Sigmas, std::vector< arma::uvec >(1, labels_t), lambda, cov);
+    } else {
+      cond_emission = make_cond_emission_model(Sigmas, labels_t, labels_y, lambda, cov);
+    }
+	
+    for_each_seq(pool, N, [&](arma::uword i, arma::uword j){
 		
       // state probs Pr[X_t=x | Z_t=k, mus, Sigmas]: loop over clusters, plug X into dmvnorm for each
-      for (arma::uword k=0; k<K; k++){
-        lstateprobs[i].col(k) = 
-          dmvnorm_cond(Xs[i],
-                       mus.col(k).t(), 
-                       Sigmas.slice(k),
-                       labels_t,
-                       labels_y,
-                       true,
-                       lambda);
+      if (cov == cov_diagonal){
+        emission_lstateprobs(emission, Xs[i], std::vector< arma::uvec >(1, arma::regspace<arma::uvec>(0, Ts[i]-1)),
+                             std::vector< arma::uvec >(1, labels_t), lstateprobs[i]);
+      } else {
+        for (arma::uword k=0; k<K; k++){
+          lstateprobs[i].col(k) = cond_emission_ldens(cond_emission[k], Xs[i], mus.col(k).t(), labels_t, labels_y);
+        }
       }
 			
       arma::vec scale = arma::max(lstateprobs[i], 1); // pseudocode: get max{ log Pr( X_t=x_t | Z_t=k ) : all k }
@@ -682,13 +1444,16 @@ Rcpp::List hmm_autocorr_cpp(
       arma::mat tstateprobs = exp(lstateprobs_scaled).t();	// t() for faster column access in forward/backward probs
 		  
       // convert to working parameters: forward, backward probs
-      lalphas[i] = forward(zetas[i].col(0).t(), Gamma, tstateprobs, scale);
-      lbetas[i] = backward(Gamma, tstateprobs, scale);
+      forward_scaled(zetas[i].col(0).t(), Gamma, tstateprobs, scale, alphas[i], lalpha_scales[i]);
+      backward_scaled(Gamma, tstateprobs, scale, betas[i], lbeta_scales[i]);
 			
-      double log_C_i = max(lalphas[i].col(Ts[i]-1));
-      llhs(i) = log(arma::accu(exp(lalphas[i].col(Ts[i]-1) - log_C_i))) + log_C_i;
+      llhs(i) = lalpha_scales[i](Ts[i]-1);  // alphas[i].col(T-1) sums to 1
+      
+      // E-step (transitions), kept until the convergence check is passed
+      xi_sums[i] = transition_counts(alphas[i], lalpha_scales[i], betas[i], lbeta_scales[i],
+                                     tstateprobs, scale, llhs(i));
 			
-    }
+    });
 	
     double llh = arma::accu(llhs);
     double llh_diff = llh - llh_seq.back();
@@ -705,91 +1470,680 @@ Rcpp::List hmm_autocorr_cpp(
       Rprintf("log-likelihood of %f\n", llh);
     }
 		
-    arma::mat Gamma_old = Gamma;	// store old transition matrix
-    Gamma.zeros();					// reset all elements to zero
-    for (arma::uword i=0; i<N; i++){
+    for (arma::uword j=0; j<nthreads; j++){
+      Gamma_parts[j].zeros(K, K);
+      stats_parts[j].reset(mus, cov == cov_diagonal);
+    }
+    for_each_seq(pool, N, [&](arma::uword i, arma::uword j){
 		
       // E-step (states)
 			
       if (!supervised){
-        zetas[i] = exp(lalphas[i] + lbetas[i] - llhs(i)); // zeta[k, t]: E[Z_t=k | data]
-        for (arma::uword t=0; t<Ts[i]; t++){ 
-          double zetas_normalize = arma::accu(zetas[i].col(t));
-          zetas[i].col(t) /= zetas_normalize; // normalize state memberships of each obs
-        }
+        zetas[i] = alphas[i] % betas[i]; // zeta[k, t]: E[Z_t=k | data], up to the scale of obs t
+        zetas[i].each_row() /= arma::sum(zetas[i], 0); // normalize state memberships of each obs
       }
 			
       // E-step (transitions)
+      Gamma_parts[j] += weights(i) * xi_sums[i];
+      
+      // weighted moments by responsibility for the M-step
+      stats_parts[j].add(Xs[i], zetas[i], weights(i));
+
+    });
+    
+    arma::mat Gamma_old = Gamma;	// store old transition matrix
+    Gamma.zeros();					// reset all elements to zero
+    for (arma::uword j=0; j<nthreads; j++){
+      Gamma += Gamma_parts[j];
+    }
+    for (arma::uword j=1; j<nthreads; j++){
+      stats_parts[0].merge(stats_parts[j]);
+    }
+    Gamma = Gamma % Gamma_old;
+		
+    // normalize transition probs out of each state
+    for (arma::uword k=0; k<K; k++){
+      Gamma.row(k) /= arma::accu(Gamma.row(k));
+    }
+		
+    // M-step (mu_k, Sigma_k): weighted mean and variance by responsibility (ignore partially censored obs)
+    mus = stats_parts[0].means();
+    Sigmas = stats_parts[0].covs();
+    constrain_covs(Sigmas, stats_parts[0].zeta_sums, cov);
+		
+    if (verbose){
+      if (iter == maxiter - 1){
+        Rcpp::Rcout << "maxiter reached; stopping" << std::endl;
+      }
+    }
+		
+  }
+	
+  Rcpp::List lstateprobs_out;
+  for (arma::uword i=0; i<N; i++){
+    lstateprobs_out.push_back(lstateprobs[i]);
+  }
+	
+  Rcpp::List mus_out;
+  Rcpp::List Sigmas_out;
+  for (arma::uword k=0; k<K; k++){
+    mus_out.push_back(arma::conv_to< std::vector<double> >::from(mus.col(k)));
+    Sigmas.slice(k).diag() += lambda;
+    Sigmas_out.push_back(Sigmas.slice(k));
+  }
+	
+  Rcpp::List zetas_out;
+  for (arma::uword i=0; i<N; i++){
+    zetas_out.push_back(zetas[i]);
+  }
+
+  return Rcpp::List::create(
+    Rcpp::Named("lstateprobs") = lstateprobs_out,
+  	Rcpp::Named("llh_seq") = llh_seq,
+  	Rcpp::Named("llhs") = llhs,
+  	Rcpp::Named("Gamma") = Gamma,
+  	Rcpp::Named("mus") = mus_out,
+  	Rcpp::Named("Sigmas") = Sigmas_out,
+  	Rcpp::Named("zetas") = zetas_out,
+  	Rcpp::Named("resets") = resets
+  );
+}
+
+
+
+//////////////////////////////////////////////////////
+// train HMM from multiple random initializations   //
+//////////////////////////////////////////////////////
+
+// one EM run of hmm_restarts_cpp, with its own random number stream
+struct em_restart {
+  std::mt19937_64 rng;
+  arma::mat Gamma;                    // transition matrix
+  arma::mat mus;                      // state-specific means: rows=covariates, cols=state
+  arma::cube Sigmas;                  // state-specific vcov matrices: rows/cols=covariates, slices=state
+  std::vector<arma::rowvec> deltas;   // initial distribution of each obs seq
+  std::vector<arma::rowvec> deltas_new;
+  arma::vec llhs;                     // log-likelihood of each obs seq in the last E-step
+  std::vector<double> llh_seq;
+  arma::mat xi_sum;                   // weighted expected transition counts of the last E-step
+  moment_stats stats;                 // weighted moments of the last E-step
+  int resets = 0;
+  bool active = true;                 // false once converged, stopped early or failed
+  bool stopped = false;               // stopped early, trailing the best run
+  std::string error;                  // reason of failure, reported by the main thread
+};
+
+// random initialization of restart r: means at distinct randomly drawn complete obs,
+// pooled cov mat of the complete obs in every state, transition rows ~ Dirichlet(1), uniform initial distributions
+void init_restart(
+    em_restart &run,
+    int seed,
+    arma::uword r,
+    const std::vector<arma::mat> &Xs,
+    const std::vector< arma::uvec > &nonmissing,
+    const arma::mat &Sigma_pooled,
+    arma::uword K
+){
+  std::seed_seq seq{static_cast<unsigned int>(seed), static_cast<unsigned int>(r)};
+  run.rng.seed(seq);
+  arma::uword N = Xs.size();
+  arma::uword M = Sigma_pooled.n_rows;
+  
+  // complete obs, as (obs seq, row) pairs
+  std::vector< std::pair<arma::uword, arma::uword> > complete;
+  for (arma::uword i=0; i<N; i++){
+    for (arma::uword t=0; t<nonmissing[i].n_elem; t++){
+      complete.push_back(std::make_pair(i, nonmissing[i](t)));
+    }
+  }
+  if (complete.size() < K){
+    throw std::runtime_error("fewer complete obs than states");
+  }
+  std::shuffle(complete.begin(), complete.end(), run.rng);
+  
+  run.mus.set_size(M, K);
+  run.Sigmas.set_size(M, M, K);
+  for (arma::uword k=0; k<K; k++){
+    run.mus.col(k) = Xs[complete[k].first].row(complete[k].second).t();
+    run.Sigmas.slice(k) = Sigma_pooled;
+  }
+  
+  std::gamma_distribution<double> dirichlet(1.0);
+  run.Gamma.set_size(K, K);
+  for (arma::uword k=0; k<K; k++){
+    for (arma::uword l=0; l<K; l++){
+      run.Gamma(k, l) = dirichlet(run.rng);
+    }
+    run.Gamma.row(k) /= arma::accu(run.Gamma.row(k));
+  }
+  
+  run.deltas.assign(N, arma::ones<arma::rowvec>(K) / K);
+  run.deltas_new = run.deltas;
+  run.llhs.set_size(N);
+}
+
+// E-step of one restart over all obs seqs, on the calling thread: returns the log-likelihood under the
+// current estimates and keeps the transition counts and moments for the M-step
+double restart_estep(
+    em_restart &run,
+    const std::vector<arma::mat> &Xs,
+    const arma::vec &weights,
+    const std::vector< arma::uvec > &nonmissing,
+    const std::vector< std::vector< arma::uvec > > &pattern_rows,
+    const std::vector< arma::uvec > &nonmissing_features,
+    double lambda,
+    double uncollapse,
+    cov_structure cov
+){
+  arma::uword K = run.Gamma.n_rows;
+  arma::uword M = run.mus.n_rows;
+  
+  // detect collapsed components and reset from this run's stream (assumes standardized features)
+  if (uncollapse > 0){
+    std::normal_distribution<double> randn;
+    for (arma::uword k=0; k<K; k++){
+      double volume;
+      double sign;
+      arma::log_det(volume, sign, run.Sigmas.slice(k));
+      if (volume < log(uncollapse)){
+        run.resets += 1;
+        for (arma::uword m=0; m<M; m++){
+          run.mus(m, k) = randn(run.rng);
+        }
+        reset_cov(run.Sigmas, k, cov);
+      }
+    }
+  }
+  
+  std::vector<emission_state> emission = 
+    make_emission_model(run.mus, run.Sigmas, nonmissing_features, lambda, cov);
+  run.xi_sum.zeros(K, K);
+  run.stats.reset(run.mus, cov == cov_diagonal);
+  
+  arma::mat lstateprobs;
+  arma::mat alpha;
+  arma::mat beta;
+  arma::vec lalpha_scale;
+  arma::vec lbeta_scale;
+  for (arma::uword i=0; i<Xs.size(); i++){
+    lstateprobs.set_size(Xs[i].n_rows, K);
+    emission_lstateprobs(emission, Xs[i], pattern_rows[i], nonmissing_features, lstateprobs);
+    arma::vec scale = arma::max(lstateprobs, 1);
+    lstateprobs.each_col() -= scale;
+    arma::mat tstateprobs = exp(lstateprobs).t();
+    
+    forward_scaled(run.deltas[i], run.Gamma, tstateprobs, scale, alpha, lalpha_scale);
+    backward_scaled(run.Gamma, tstateprobs, scale, beta, lbeta_scale);
+    run.llhs(i) = lalpha_scale(Xs[i].n_rows-1);
+    
+    run.xi_sum += weights(i) * transition_counts(alpha, lalpha_scale, beta, lbeta_scale,
+                                                 tstateprobs, scale, run.llhs(i));
+    
+    arma::mat zeta = alpha % beta;
+    zeta.each_row() /= arma::sum(zeta, 0);
+    run.deltas_new[i] = zeta.col(0).t();
+    run.stats.add(Xs[i].rows(nonmissing[i]), zeta.cols(nonmissing[i]), weights(i));
+  }
+  
+  return arma::accu(run.llhs);
+}
+
+// M-step of one restart from the statistics of its last E-step
+void restart_mstep(em_restart &run, cov_structure cov){
+  run.Gamma = run.xi_sum % run.Gamma;
+  for (arma::uword k=0; k<run.Gamma.n_rows; k++){
+    run.Gamma.row(k) /= arma::accu(run.Gamma.row(k));
+  }
+  run.deltas.swap(run.deltas_new);
+  run.mus = run.stats.means();
+  run.Sigmas = run.stats.covs();
+  constrain_covs(run.Sigmas, run.stats.zeta_sums, cov);
+}
+
+
+
+// EM from several random initializations, run concurrently (one restart per thread at a time)
+// restart r draws from its own stream seeded by (seed, r), so results do not depend on nthreads
+// all active restarts advance one iteration per round; after min_iter iterations a restart whose
+// log-likelihood trails the best one by more than margin is stopped
+// returns the estimates of the restart with the highest log-likelihood (with the initial distribution of
+// each obs seq, see deltas_init of hmm_cpp) and the llh_seq of every restart
+// [[Rcpp::export]]
+Rcpp::List hmm_restarts_cpp(
+  std::vector<arma::mat> Xs,		       // list of data, list length N, element i [Ts[i] x M]
+  arma::vec weights,
+  arma::uword K,                       // number of states
+  std::vector< arma::uvec > nonmissing,           // indices of obs with no missingness
+  std::vector< arma::uvec > missingness_labels,   // pattern of missingness features
+  std::vector< arma::uvec > nonmissing_features,  // details on each missingness type
+  arma::uword restarts = 10,           // number of random initializations
+  int seed = 1,
+  double lambda = 0,				           // regularization parameter
+  double tol = 1e-6,				           // terminate a restart when log-likelihood increase < tol...
+  arma::uword maxiter = 100,		       // ... or after maxiter iterations
+  double margin = 10,                  // stop restarts trailing the best log-likelihood by more than margin...
+  arma::uword min_iter = 10,           // ... once they have run min_iter iterations
+  double uncollapse = 0,			         // randomly reset collapsing (small-volume) components, i.e. det(Sigma) < uncollapse
+  bool verbose = true,				         // status updates
+  arma::uword nthreads = 1,            // threads running restarts concurrently (0 = one per core)
+  std::string covariance = "full"      // structure of the state cov mats: "full", "diagonal" or "tied"
+){
+  
+  arma::uword N = Xs.size();				// number of observation sequences
+  arma::uword M = Xs[0].n_cols;			// number of measured covariates
+  cov_structure cov = parse_covariance(covariance);
+  if (restarts < 1){
+    Rcpp::stop("restarts must be positive");
+  }
+  
+  // obs grouped by missingness pattern, shared by all restarts
+  std::vector< std::vector< arma::uvec > > pattern_rows;
+  for (arma::uword i=0; i<N; i++){
+    pattern_rows.push_back(rows_by_pattern(missingness_labels[i], nonmissing_features.size()));
+  }
+  
+  // pooled cov mat of the complete obs, the initial cov mat of every state
+  moment_stats pooled;
+  pooled.reset(arma::zeros<arma::mat>(M, 1));
+  for (arma::uword i=0; i<N; i++){
+    pooled.add(Xs[i].rows(nonmissing[i]), arma::ones<arma::mat>(1, nonmissing[i].n_elem), weights(i));
+  }
+  arma::cube Sigma_pooled = pooled.covs();
+  constrain_covs(Sigma_pooled, arma::ones<arma::vec>(1), cov);
+  
+  std::vector<em_restart> runs(restarts);
+  for (arma::uword r=0; r<restarts; r++){
+    init_restart(runs[r], seed, r, Xs, nonmissing, Sigma_pooled.slice(0), K);
+    constrain_covs(runs[r].Sigmas, arma::ones<arma::vec>(K), cov);
+  }
+  
+  nthreads = n_seq_threads(restarts, nthreads);
+  seq_pool pool(nthreads);
+  std::vector<arma::uword> active;
+  for (arma::uword iter=0; iter<maxiter; iter++){
+    
+    active.clear();
+    for (arma::uword r=0; r<restarts; r++){
+      if (runs[r].active){
+        active.push_back(r);
+      }
+    }
+    if (active.empty()){
+      break;
+    }
+    
+    for_each_seq(pool, active.size(), [&](arma::uword a, arma::uword j){
+      em_restart &run = runs[active[a]];
+      try {
+        run.llh_seq.push_back(restart_estep(run, Xs, weights, nonmissing, pattern_rows, nonmissing_features,
+                                            lambda, uncollapse, cov));
+      } catch(std::exception &ex) {
+        run.error = ex.what();
+        run.active = false;
+      }
+    });
+    
+    // best log-likelihood so far, over all restarts that did not fail
+    double best = -std::numeric_limits<double>::infinity();
+    for (arma::uword r=0; r<restarts; r++){
+      if (runs[r].error.empty() && !runs[r].llh_seq.empty()){
+        best = std::max(best, runs[r].llh_seq.back());
+      }
+    }
+    
+    for (arma::uword a=0; a<active.size(); a++){
+      em_restart &run = runs[active[a]];
+      if (!run.error.empty()){
+        if (verbose){
+          Rcpp::Rcout << "restart " << active[a] + 1 << " failed:" << std::endl << run.error << std::endl;
+        }
+        continue;
+      }
+      double llh = run.llh_seq.back();
+      double llh_diff = run.llh_seq.size() > 1 ? llh - run.llh_seq[run.llh_seq.size()-2] : std::numeric_limits<double>::infinity();
+      if (llh_diff < tol && llh_diff >= 0){
+        run.active = false;
+      } else if (iter + 1 >= min_iter && llh < best - margin){
+        run.active = false;
+        run.stopped = true;
+      } else if (iter < maxiter - 1){
+        restart_mstep(run, cov);
+      }
+    }
+    
+    if (verbose){
+      arma::uword n_active = 0;
+      for (arma::uword r=0; r<restarts; r++){
+        n_active += runs[r].active;
+      }
+      Rcpp::Rcout << "iter " << iter + 1 << ": ";
+      Rprintf("best log-likelihood of %f, %d restarts running\n", best, static_cast<int>(n_active));
+    }
+    Rcpp::checkUserInterrupt();
+  }
+  
+  arma::uword best_r = restarts;
+  for (arma::uword r=0; r<restarts; r++){
+    if (runs[r].error.empty() && !runs[r].llh_seq.empty() &&
+        (best_r == restarts || runs[r].llh_seq.back() > runs[best_r].llh_seq.back())){
+      best_r = r;
+    }
+  }
+  if (best_r == restarts){
+    Rcpp::stop("all restarts failed");
+  }
+  em_restart &run = runs[best_r];
+  
+  Rcpp::List mus_out;
+  Rcpp::List Sigmas_out;
+  for (arma::uword k=0; k<K; k++){
+    mus_out.push_back(arma::conv_to< std::vector<double> >::from(run.mus.col(k)));
+    run.Sigmas.slice(k).diag() += lambda;
+    Sigmas_out.push_back(run.Sigmas.slice(k));
+  }
+  Rcpp::List deltas_out;
+  for (arma::uword i=0; i<N; i++){
+    deltas_out.push_back(arma::conv_to< std::vector<double> >::from(run.deltas[i]));
+  }
+  
+  Rcpp::List llh_seqs;
+  std::vector<bool> stopped(restarts);
+  std::vector<std::string> errors(restarts);
+  for (arma::uword r=0; r<restarts; r++){
+    llh_seqs.push_back(runs[r].llh_seq);
+    stopped[r] = runs[r].stopped;
+    errors[r] = runs[r].error;
+  }
+  
+  return Rcpp::List::create(
+    Rcpp::Named("best") = best_r + 1,
+    Rcpp::Named("llh_seq") = run.llh_seq,
+    Rcpp::Named("llhs") = run.llhs,
+    Rcpp::Named("Gamma") = run.Gamma,
+    Rcpp::Named("mus") = mus_out,
+    Rcpp::Named("Sigmas") = Sigmas_out,
+    Rcpp::Named("deltas") = deltas_out,
+    Rcpp::Named("resets") = run.resets,
+    Rcpp::Named("llh_seqs") = llh_seqs,
+    Rcpp::Named("stopped") = stopped,
+    Rcpp::Named("errors") = errors
+  );
+}
 
-      arma::mat lstateprobs_dropfirst = lstateprobs[i].submat(arma::span(1, Ts[i]-1), arma::span::all);
-      arma::mat lalpha_droplast = lalphas[i].submat(arma::span::all, arma::span(0, Ts[i]-2));
-      lalpha_droplast = lalpha_droplast.t();
-      arma::mat lbeta_dropfirst = lbetas[i].submat(arma::span::all, arma::span(1, Ts[i]-1));
-      lbeta_dropfirst = lbeta_dropfirst.t();
-		
-      for (arma::uword k1=0; k1<K; k1++){
-        for (arma::uword k2=0; k2<K; k2++){
-          Gamma(k1, k2) += weights(i) *
-            arma::accu(exp(lalpha_droplast.col(k1) 
-                           + lstateprobs_dropfirst.col(k2) 
-                           + lbeta_dropfirst.col(k2) 
-                           - llhs(i)
-                           ));
-        }
+
+
+//////////////////////////////////////////////////////
+// train HMM online on obs seqs in feature files    //
+//////////////////////////////////////////////////////
+
+// pattern of nonmissing features of an obs ('1' nonmissing, '0' missing, one char per feature) -> missingness label
+std::map<std::string, arma::uword> missingness_patterns(
+    const std::vector< arma::uvec > &nonmissing_features,  // details on each missingness type
+    arma::uword M
+){
+  std::map<std::string, arma::uword> labels;
+  for (arma::uword m=0; m<nonmissing_features.size(); m++){
+    std::string key(M, '0');
+    for (arma::uword f=0; f<nonmissing_features[m].n_elem; f++){
+      if (nonmissing_features[m](f) >= M){
+        std::ostringstream msg;
+        msg << "entry " << (m+1) << " of nonmissing_features refers to feature " << (nonmissing_features[m](f)+1)
+            << " of " << M;
+        throw std::runtime_error(msg.str());
       }
+      key[nonmissing_features[m](f)] = '1';
+    }
+    labels[key] = m;
+  }
+  return labels;
+}
 
+// read one obs seq from an HTK feature file (as written by openSMILE's cHtkSink), [T x M]
+// through a read-only memory mapping; swap: result of smileHtk_IsVAXOrder(), which must be called
+// once on the calling thread before (it writes a global)
+// features stored as NaN count as missing: missingness_labels_i gets the index of the entry of
+// nonmissing_features that lists exactly the other features, nonmissing_i the rows without NaN
+void read_htk_seq(
+    const std::string &path,
+    const std::vector< arma::uvec > &nonmissing_features,  // details on each missingness type
+    bool swap,                                             // swap the byte order of the floats
+    arma::mat &X,
+    arma::uvec &missingness_labels_i,
+    arma::uvec &nonmissing_i
+){
+  CMappedFile file;
+  if (!file.open(path)){
+    throw std::runtime_error("can not open feature file " + path);
+  }
+  sHTKheader header;
+  if (file.size() < sizeof(sHTKheader)){
+    throw std::runtime_error("not an HTK feature file: " + path);
+  }
+  memcpy(&header, file.data(), sizeof(sHTKheader));
+  smileHtk_prepareHeader(&header);  // convert to host byte order
+  arma::uword T = header.nSamples;
+  arma::uword M = header.sampleSize / sizeof(float);
+  if (M == 0 || file.size() < sizeof(sHTKheader) + T * M * sizeof(float)){
+    throw std::runtime_error("truncated HTK feature file: " + path);
+  }
+  
+  std::map<std::string, arma::uword> labels = missingness_patterns(nonmissing_features, M);
+  
+  X.set_size(T, M);
+  missingness_labels_i.set_size(T);
+  std::vector<arma::uword> complete;
+  const uint8_t *data = file.data() + sizeof(sHTKheader);
+  std::string key(M, '1');
+  for (arma::uword t=0; t<T; t++){
+    for (arma::uword m=0; m<M; m++){
+      float v;
+      memcpy(&v, data + (t * M + m) * sizeof(float), sizeof(float));
+      if (swap){
+        smileHtk_SwapFloat(&v);
+      }
+      X(t, m) = v;
+      key[m] = std::isnan(v) ? '0' : '1';
     }
-    Gamma = Gamma % Gamma_old;
-		
-    // normalize transition probs out of each state
-    for (arma::uword k=0; k<K; k++){
-      Gamma.row(k) /= arma::accu(Gamma.row(k));
+    std::map<std::string, arma::uword>::const_iterator it = labels.find(key);
+    if (it == labels.end()){
+      std::ostringstream msg;
+      msg << "obs " << (t+1) << " of " << path << ": missing features do not match any entry of nonmissing_features";
+      throw std::runtime_error(msg.str());
     }
-		
-    // M-step (mu_k)
-    mus.zeros();		// reset all elements to zero
-    arma::vec zeta_sums(K, arma::fill::zeros);
-		
-    // weighted sum by responsibility (ignore partially censored obs)
-    for (arma::uword i=0; i<N; i++){
-      mus += weights(i) * (zetas[i] * Xs[i]).t();
-      zeta_sums += weights(i) * arma::sum(zetas[i], 1);
+    missingness_labels_i(t) = it->second;
+    if (key.find('0') == std::string::npos){
+      complete.push_back(t);
     }
-		
-    // divide by effective number of obs (ignore partially censored obs)
-    for (arma::uword k=0; k<K; k++){
-      mus.col(k) /= zeta_sums(k);
+  }
+  nonmissing_i = arma::conv_to<arma::uvec>::from(complete);
+}
+
+
+
+// write one obs seq as HTK feature file (parmKind USER), missing features as NaN
+// [[Rcpp::export]]
+void write_htk_cpp(
+    arma::mat X,              // data, [T x M]
+    std::string path,
+    double period = 0.01      // frame period in seconds
+){
+  FILE *f = fopen_speech(path.c_str(), "wb");
+  if (f == nullptr){
+    Rcpp::stop("can not open " + path + " for writing");
+  }
+  const bool swap = smileHtk_IsVAXOrder() != 0;
+  sHTKheader header;
+  header.nSamples = X.n_rows;
+  header.samplePeriod = static_cast<uint32_t>(std::round(period * 10000000.0));
+  header.sampleSize = static_cast<uint16_t>(sizeof(float) * X.n_cols);
+  header.parmKind = 9;  // USER
+  bool ok = smileHtk_writeHeader(f, &header);
+  std::vector<float> row(X.n_cols);
+  for (arma::uword t=0; t<X.n_rows && ok; t++){
+    for (arma::uword m=0; m<X.n_cols; m++){
+      row[m] = static_cast<float>(X(t, m));
+      if (swap){
+        smileHtk_SwapFloat(&row[m]);
+      }
     }
-		
-    // M-step (Sigma_k)
-    Sigmas.zeros();		// reset all elements to zero
-		
-    // weighted variance by responsibility (ignore partially censored obs)
-    for (arma::uword k=0; k<K; k++){
-      for (arma::uword i=0; i<N; i++){
-        arma::mat X_demean = Xs[i];
-        for (arma::uword m=0; m<M; m++){
-          X_demean.col(m) -= mus(m, k);
+    ok = fwrite(row.data(), sizeof(float), row.size(), f) == row.size();
+  }
+  fclose(f);
+  if (!ok){
+    Rcpp::stop("error writing " + path);
+  }
+}
+
+
+
+// stepwise (online) EM over obs seqs stored in feature files
+// the files are visited in mini-batches; after each batch the running sufficient statistics
+// (expected transition counts, first-state counts, weighted moments) are blended with the
+// batch statistics, S <- (1 - eta_u) S + eta_u S_batch with eta_u = (u + 2)^-kappa for the u-th update,
+// and the parameters are re-estimated from S
+// only one batch of obs seqs is held in memory, every seq uses the checkpointed forward-backward
+// [[Rcpp::export]]
+Rcpp::List hmm_online_cpp(
+  std::vector<std::string> files,      // HTK feature files, one obs seq each, missing features as NaN
+  arma::vec weights,                   // weight of each obs seq
+  arma::rowvec delta_init,		         // initial distribution
+  arma::mat mus_init,			             // state-specific means: rows=covariates, cols=state
+  std::vector<arma::mat> Sigmas_init,  // state-specific vcov matrices: rows/cols=covariates, elements=state
+  arma::mat Gamma_init,			           // transition matrix
+  std::vector< arma::uvec > nonmissing_features,  // details on each missingness type
+  double lambda = 0,				           // regularization parameter
+  arma::uword batch_size = 16,         // obs seqs per mini-batch
+  arma::uword epochs = 1,              // passes over all files
+  double kappa = 0.6,                  // step size decay, 0.5 < kappa <= 1
+  bool shuffle = true,                 // visit the files in random order in every epoch
+  bool verbose = true,				         // status updates
+  arma::uword nthreads = 1             // threads for the E-step over the obs seqs of a batch (0 = one per core)
+){
+  
+  arma::uword N = files.size();				// number of observation sequences
+  arma::uword M = mus_init.n_rows;			// number of measured covariates
+  arma::uword K = Gamma_init.n_rows;		// number of states
+  if (batch_size < 1){
+    batch_size = 1;
+  }
+  
+  arma::rowvec delta = delta_init;
+  arma::mat Gamma = Gamma_init;
+  arma::mat mus = mus_init;
+  arma::cube Sigmas(M, M, K);
+  for (arma::uword k=0; k<K; k++){
+    Sigmas.slice(k) = Sigmas_init[k];
+  }
+  
+  // running sufficient statistics
+  arma::mat counts;         // expected transition counts
+  arma::vec first_counts;   // expected counts of the first state
+  moment_stats stats;
+  
+  // log-likelihood of each batch, under the parameters before its update
+  std::vector<double> llh_seq;
+  
+  const bool swap = smileHtk_IsVAXOrder() != 0;  // before the workers start, see read_htk_seq
+  nthreads = n_seq_threads(batch_size, nthreads);
+  seq_pool pool(nthreads);
+  std::vector<arma::mat> xi_parts(nthreads);
+  std::vector<arma::vec> first_parts(nthreads);
+  std::vector<moment_stats> stats_parts(nthreads);
+  std::vector<double> llh_parts(nthreads);
+  
+  arma::uword u = 0;  // number of updates
+  for (arma::uword epoch=0; epoch<epochs; epoch++){
+    arma::uvec order = shuffle ? arma::randperm(N) : arma::regspace<arma::uvec>(0, N-1);
+    
+    for (arma::uword b0=0; b0<N; b0+=batch_size){
+      arma::uword nb = std::min(batch_size, N - b0);
+      
+      std::vector<emission_state> emission = 
+        make_emission_model(mus, Sigmas, nonmissing_features, lambda);
+      for (arma::uword j=0; j<nthreads; j++){
+        xi_parts[j].zeros(K, K);
+        first_parts[j].zeros(K);
+        stats_parts[j].reset(mus);
+        llh_parts[j] = 0;
+      }
+      
+      for_each_seq(pool, nb, [&](arma::uword b, arma::uword j){
+        arma::uword i = order(b0 + b);
+        arma::mat X;
+        arma::uvec missingness_labels_i;
+        arma::uvec nonmissing_i;
+        read_htk_seq(files[i], nonmissing_features, swap, X, missingness_labels_i, nonmissing_i);
+        if (X.n_cols != M){
+          throw std::runtime_error("number of features in " + files[i] + " does not match mus_init");
         }
-        arma::rowvec zetas_ik = zetas[i].row(k) ;
-        Sigmas.slice(k) += weights(i) * X_demean.t() * arma::diagmat(zetas_ik) * X_demean;
+        arma::vec zeta_first;
+        llh_parts[j] += weights(i) * estep_checkpointed(emission, X, missingness_labels_i, nonmissing_features, nonmissing_i,
+                                                        delta, Gamma, nullptr, weights(i),
+                                                        xi_parts[j], stats_parts[j], zeta_first, nullptr, nullptr);
+        first_parts[j] += weights(i) * zeta_first;
+      });
+      
+      // batch statistics, normalized by the weight of the batch
+      double batch_weight = 0;
+      for (arma::uword b=0; b<nb; b++){
+        batch_weight += weights(order(b0 + b));
       }
-      Sigmas.slice(k) /= zeta_sums(k);
-    }
-		
-    if (verbose){
-      if (iter == maxiter - 1){
-        Rcpp::Rcout << "maxiter reached; stopping" << std::endl;
+      arma::mat batch_counts(K, K, arma::fill::zeros);
+      arma::vec batch_first(K, arma::fill::zeros);
+      double batch_llh = 0;
+      for (arma::uword j=0; j<nthreads; j++){
+        batch_counts += xi_parts[j];
+        batch_first += first_parts[j];
+        batch_llh += llh_parts[j];
+      }
+      for (arma::uword j=1; j<nthreads; j++){
+        stats_parts[0].merge(stats_parts[j]);
+      }
+      batch_counts = batch_counts % Gamma / batch_weight;
+      batch_first /= batch_weight;
+      stats_parts[0].scale(1.0 / batch_weight);
+      llh_seq.push_back(batch_llh);
+      
+      // stepwise update of the running statistics
+      if (u == 0){
+        counts = batch_counts;
+        first_counts = batch_first;
+        stats = stats_parts[0];
+      } else {
+        double eta = std::pow(static_cast<double>(u + 2), -kappa);
+        counts = (1 - eta) * counts + eta * batch_counts;
+        first_counts = (1 - eta) * first_counts + eta * batch_first;
+        stats.set_shift(mus);
+        stats.scale(1 - eta);
+        stats_parts[0].scale(eta);
+        stats.merge(stats_parts[0]);
+      }
+      u++;
+      
+      // M-step from the running statistics, states without responsibility keep their estimates
+      for (arma::uword k=0; k<K; k++){
+        if (arma::accu(counts.row(k)) > 0){
+          Gamma.row(k) = counts.row(k) / arma::accu(counts.row(k));
+        }
+      }
+      delta = first_counts.t() / arma::accu(first_counts);
+      arma::mat mus_new = stats.means();
+      arma::cube Sigmas_new = stats.covs();
+      for (arma::uword k=0; k<K; k++){
+        if (stats.zeta_sums(k) > 0){
+          mus.col(k) = mus_new.col(k);
+          Sigmas.slice(k) = Sigmas_new.slice(k);
+        }
+      }
+      
+      if (verbose){
+        Rprintf("epoch %d, batch %d: log-likelihood of %f\n",
+                static_cast<int>(epoch + 1), static_cast<int>(b0 / batch_size + 1), batch_llh);
       }
+      Rcpp::checkUserInterrupt();
     }
-		
-  }
-	
-  Rcpp::List lstateprobs_out;
-  for (arma::uword i=0; i<N; i++){
-    lstateprobs_out.push_back(lstateprobs[i]);
   }
-	
+  
   Rcpp::List mus_out;
   Rcpp::List Sigmas_out;
   for (arma::uword k=0; k<K; k++){
@@ -797,21 +2151,14 @@ Rcpp::List hmm_autocorr_cpp(
     Sigmas.slice(k).diag() += lambda;
     Sigmas_out.push_back(Sigmas.slice(k));
   }
-	
-  Rcpp::List zetas_out;
-  for (arma::uword i=0; i<N; i++){
-    zetas_out.push_back(zetas[i]);
-  }
-
+  
   return Rcpp::List::create(
-    Rcpp::Named("lstateprobs") = lstateprobs_out,
-  	Rcpp::Named("llh_seq") = llh_seq,
-  	Rcpp::Named("llhs") = llhs,
-  	Rcpp::Named("Gamma") = Gamma,
-  	Rcpp::Named("mus") = mus_out,
-  	Rcpp::Named("Sigmas") = Sigmas_out,
-  	Rcpp::Named("zetas") = zetas_out,
-  	Rcpp::Named("resets") = resets
+    Rcpp::Named("llh_seq") = llh_seq,
+    Rcpp::Named("delta") = delta,
+    Rcpp::Named("Gamma") = Gamma,
+    Rcpp::Named("mus") = mus_out,
+    Rcpp::Named("Sigmas") = Sigmas_out,
+    Rcpp::Named("updates") = u
   );
 }
 
@@ -832,7 +2179,8 @@ Rcpp::List llh_cpp(
   std::vector< arma::uvec > missingness_labels,   // pattern of missingness features
   std::vector< arma::uvec > nonmissing_features,  // details on each missingness type
   double lambda,			          // regularization parameter
-  bool verbose = true				         // status updates
+  bool verbose = true,				         // status updates
+  std::string covariance = "full"    // structure of the state cov mats: "full", "diagonal" or "tied"
 ){
 	
   arma::uword N = Xs.size();				// number of observation sequences
@@ -844,13 +2192,15 @@ Rcpp::List llh_cpp(
   arma::uword K = Gamma.n_rows;			// number of states
 	
   // for obs seq i: rows=states, cols=time
-  std::vector<arma::mat> lalphas;
+  std::vector<arma::mat> alphas;
+  std::vector<arma::vec> lalpha_scales;
 	
   // for obs seq i: rows=time, cols=states
   std::vector<arma::mat> lstateprobs;	
 	
   for (arma::uword i=0; i<N; i++){
-    lalphas.push_back(arma::mat(K, Ts[i]));		// forward probs: Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
+    alphas.push_back(arma::mat(K, Ts[i]));		// scaled forward probs: Pr(X_1=x_1, ..., X_t=x_t, Z_t=k)
+    lalpha_scales.push_back(arma::vec(Ts[i]));
     lstateprobs.push_back(arma::mat(Ts[i], K));	// prob that state k generated obs t: Pr(X_t=x_t | Z_t=k)
   }
 		
@@ -860,6 +2210,12 @@ Rcpp::List llh_cpp(
   for (arma::uword k=0; k<K; k++){
     Sigmas.slice(k) = Sigmas_in[k];
   }
+  cov_structure cov = parse_covariance(covariance);
+  constrain_covs(Sigmas, arma::ones<arma::vec>(K), cov);
+	
+  // factorize the state cov mats once for all obs seqs
+  std::vector<emission_state> emission = 
+    make_emission_model(mus, Sigmas, nonmissing_features, lambda, cov);
 	
   // compute log likelihoods
   arma::vec llhs(N);
@@ -868,18 +2224,10 @@ Rcpp::List llh_cpp(
       Rcpp::Rcout << "obs seq " << i + 1 << std::endl;
     }
 	
-    // state probs Pr[X_t=x | Z_t=k, mus, Sigmas]: loop over clusters, plug X into dmvnorm for each
-    for (arma::uword k=0; k<K; k++){
-      if (verbose){
-        Rcpp::Rcout << "  state " << k + 1 << std::endl;
-      }
-      lstateprobs[i].col(k) = 
-        dmvnorm_cens(Xs[i],
-                     mus.col(k).t(), Sigmas.slice(k),
-                     missingness_labels[i],
-                     nonmissing_features,
-                     true, lambda);
-    }
+    // state probs Pr[X_t=x | Z_t=k, mus, Sigmas]
+    emission_lstateprobs(emission, Xs[i],
+                         rows_by_pattern(missingness_labels[i], nonmissing_features.size()),
+                         nonmissing_features, lstateprobs[i]);
 		
     arma::vec scale = arma::max(lstateprobs[i], 1); // pseudocode: get max{ log Pr( X_t=x_t | Z_t=k ) : all k }
     arma::mat lstateprobs_scaled = lstateprobs[i];
@@ -889,10 +2237,9 @@ Rcpp::List llh_cpp(
     arma::mat tstateprobs = exp(lstateprobs_scaled).t();	// t() for faster column access in forward/backward probs
 		
     // forward probs
-    lalphas[i] = forward(delta, Gamma, tstateprobs, scale);
+    forward_scaled(delta, Gamma, tstateprobs, scale, alphas[i], lalpha_scales[i]);
 		
-    double log_C_i = max(lalphas[i].col(Ts[i]-1));
-    llhs(i) = log(arma::accu(exp(lalphas[i].col(Ts[i]-1) - log_C_i))) + log_C_i;
+    llhs(i) = lalpha_scales[i](Ts[i]-1);  // alphas[i].col(T-1) sums to 1
 	
   }
 	
@@ -917,7 +2264,8 @@ Rcpp::List lstateprobs_cpp(
     std::vector< arma::uvec > nonmissing,           // indices of obs with no missingness
     std::vector< arma::uvec > missingness_labels,   // pattern of missingness features
     std::vector< arma::uvec > nonmissing_features,  // details on each missingness type
-    double lambda			                 // regularization parameter
+    double lambda,			               // regularization parameter
+    std::string covariance = "full"    // structure of the state cov mats: "full", "diagonal" or "tied"
 ){
   
   arma::uword N = Xs.size();				// number of observation sequences
@@ -941,20 +2289,20 @@ Rcpp::List lstateprobs_cpp(
   for (arma::uword k=0; k<K; k++){
     Sigmas.slice(k) = Sigmas_in[k];
   }
+  cov_structure cov = parse_covariance(covariance);
+  constrain_covs(Sigmas, arma::ones<arma::vec>(K), cov);
   
-  // compute log likelihoods
-  arma::vec llhs(N);
+  // factorize the state cov mats once for all obs seqs
+  std::vector<emission_state> emission = 
+    make_emission_model(mus, Sigmas, nonmissing_features, lambda, cov);
+  
+  // compute log probs
   for (arma::uword i=0; i<N; i++){
     
-    // state probs Pr[X_t=x | Z_t=k, mus, Sigmas]: loop over clusters, plug X into dmvnorm for each
-    for (arma::uword k=0; k<K; k++){
-      lstateprobs[i].col(k) = 
-        dmvnorm_cens(Xs[i],
-                     mus.col(k).t(), Sigmas.slice(k),
-                     missingness_labels[i],
-                     nonmissing_features,
-                     true, lambda);
-    }
+    // state probs Pr[X_t=x | Z_t=k, mus, Sigmas]
+    emission_lstateprobs(emission, Xs[i],
+                         rows_by_pattern(missingness_labels[i], nonmissing_features.size()),
+                         nonmissing_features, lstateprobs[i]);
     
   }
   
@@ -973,6 +2321,157 @@ Rcpp::List lstateprobs_cpp(
 // find most likely sequence of states //
 /////////////////////////////////////////
 
+// incremental viterbi decoder (same idea as cSmileViterbi in lld/pitchSmootherViterbi):
+// frames are added as they arrive, a frame's state is decided as soon as all surviving paths agree on it,
+// or once it lies lag frames behind the newest frame (then the currently best path decides)
+// only the backpointers of undecided frames are kept: O(K x lag) memory
+// agreement is tracked incrementally: every undecided frame counts its states that still lie on a surviving
+// path; a state whose last successor is dropped is removed, and its predecessor loses a successor in turn
+// (each state is removed once, so this is O(K) per frame on average)
+class viterbi_stream {
+public:
+  viterbi_stream(const arma::rowvec &delta,  // initial distribution
+                 const arma::mat &Gamma,     // transition matrix
+                 arma::uword lag_)           // max delay in frames until a state is decided
+    : ldelta(log(delta.t())), lGamma(log(Gamma)), K(Gamma.n_rows), lag(lag_),
+      backptr(Gamma.n_rows, lag_ + 1), succ(Gamma.n_rows, lag_ + 1), alive(lag_ + 1), t_next(0), t_out(0) {}
+  
+  // add frames, lstateprobs [L x K]: log Pr(X_t=x_t | Z_t=k); decided states are appended to out
+  void push(const arma::mat &lstateprobs, std::vector<arma::uword> &out){
+    arma::mat tlstateprobs = lstateprobs.t(); // transposed for faster column access
+    arma::vec lxi_new(K);
+    for (arma::uword l=0; l<tlstateprobs.n_cols; l++){
+      arma::uword t = t_next++;
+      arma::uword *bp = backptr.colptr(t % backptr.n_cols);
+      if (t == 0){
+        lxi = ldelta + tlstateprobs.col(l);
+      } else {
+        // log max_{z_1, ... z_t-1} Pr(Z_1=z_1, ... Z_t=k, X), and the best state at t-1
+        for (arma::uword k=0; k<K; k++){
+          lxi_new(k) = (lxi + lGamma.col(k)).max(bp[k]);
+        }
+        lxi = lxi_new + tlstateprobs.col(l);
+      }
+      lxi -= lxi.max();  // keep the scores bounded, argmax is unchanged
+      
+      // every state at t survives; states at t-1 without a successor are removed
+      // latest frame on which all surviving paths agree, if any
+      arma::uword s_agree = t_out;
+      bool agree = false;
+      succ.col(t % succ.n_cols).zeros();
+      alive(t % alive.n_elem) = K;
+      if (K == 1){
+        s_agree = t;
+        agree = true;
+      } else if (t > t_out){
+        arma::uword *prev = succ.colptr((t-1) % succ.n_cols);
+        for (arma::uword k=0; k<K; k++){
+          prev[bp[k]]++;
+        }
+        for (arma::uword k=0; k<K; k++){
+          if (prev[k] == 0){
+            remove(t-1, k, s_agree, agree);
+          }
+        }
+      }
+      if (agree){
+        decide(s_agree, surviving(s_agree), out);
+      }
+      
+      // frames more than lag behind are decided by the best path
+      if (t_out + lag <= t){
+        arma::uword k_t;
+        lxi.max(k_t);
+        arma::uword k_s = trace(t, k_t, t - lag);
+        decide(t - lag, k_s, out);
+      }
+    }
+  }
+  
+  // decide all remaining frames by the best path and start a new seq
+  void flush(std::vector<arma::uword> &out){
+    if (t_next > t_out){
+      arma::uword k_t;
+      lxi.max(k_t);
+      decide(t_next - 1, k_t, out);
+    }
+    t_next = 0;
+    t_out = 0;
+  }
+  
+  arma::uword pending() const { return t_next - t_out; }
+  
+private:
+  arma::vec ldelta;       // log initial distribution
+  arma::mat lGamma;       // log transition probabilities
+  arma::uword K;          // number of states
+  arma::uword lag;
+  arma::vec lxi;          // log score of the best path into state k at the newest frame, up to a constant
+  arma::umat backptr;     // ring buffer, column t % (lag+1): best state at t-1 given state k at t
+  arma::umat succ;        // ring buffer: number of states at t+1 whose best predecessor is state k at t
+  arma::uvec alive;       // ring buffer: number of states at t on a surviving path
+  arma::uword t_next;     // frames added
+  arma::uword t_out;      // frames decided
+  
+  // state k at undecided frame s has no successor left: remove it and, in turn, predecessors left without successor
+  // frames on which a single state survives are reported through s_agree/agree (the latest one)
+  void remove(arma::uword s, arma::uword k, arma::uword &s_agree, bool &agree){
+    for (;;){
+      if (--alive(s % alive.n_elem) == 1 && (!agree || s > s_agree)){
+        s_agree = s;
+        agree = true;
+      }
+      if (s == t_out){
+        return;
+      }
+      k = backptr(k, s % backptr.n_cols);
+      s--;
+      if (--succ(k, s % succ.n_cols) > 0){
+        return;
+      }
+    }
+  }
+  
+  // the single state at frame s on a surviving path (s < newest frame)
+  arma::uword surviving(arma::uword s) const {
+    if (s + 1 == t_next){
+      return 0;  // K == 1
+    }
+    const arma::uword *n = succ.colptr(s % succ.n_cols);
+    for (arma::uword k=0; k<K; k++){
+      if (n[k] > 0){
+        return k;
+      }
+    }
+    return 0;
+  }
+  
+  // state at frame s of the path that is in state k at frame t >= s
+  arma::uword trace(arma::uword t, arma::uword k, arma::uword s) const {
+    for (; t>s; t--){
+      k = backptr(k, t % backptr.n_cols);
+    }
+    return k;
+  }
+  
+  // frame s is in state k: write the states of frames t_out, ..., s
+  void decide(arma::uword s, arma::uword k, std::vector<arma::uword> &out){
+    if (s < t_out){
+      return;
+    }
+    arma::uword n = out.size();
+    out.resize(n + s - t_out + 1);
+    out[n + s - t_out] = k;
+    for (arma::uword t=s; t>t_out; t--){
+      k = backptr(k, t % backptr.n_cols);
+      out[n + t - 1 - t_out] = k;
+    }
+    t_out = s + 1;
+  }
+};
+
+
+
 // [[Rcpp::export]]
 std::vector< std::vector<arma::uword> > viterbi_cpp(
   std::vector<arma::mat> lstateprobs,	// rows=time, cols=covariates
@@ -981,66 +2480,308 @@ std::vector< std::vector<arma::uword> > viterbi_cpp(
 ){
   
   arma::uword N = lstateprobs.size();				// number of observation sequences
-  std::vector<arma::uword> Ts;			// number of observations in each obs sequence
-  for (arma::uword i=0; i<N; i++){
-    Ts.push_back(lstateprobs[i].n_rows);
-  }
   arma::uword K = Gamma.n_rows;			// number of states
   
-  // for obs seq i: rows=states, cols=time
-  std::vector<arma::mat> lxis;
-  std::vector<arma::mat> tlstateprobs; // transposed for faster column access
-  
-  for (arma::uword i=0; i<N; i++){
-    lxis.push_back(arma::mat(K, Ts[i]));
-    tlstateprobs.push_back(lstateprobs[i].t());
-  }
-  
   // log transition probabilities
   arma::mat lGamma = log(Gamma);
   
   // predicted sequence
-  std::vector< std::vector<arma::uword> > seqs;
+  std::vector< std::vector<arma::uword> > seqs(N);
   
-  // compute log-likelihood of most probable sequence up to t
-  // log max_{z_1, ... z_t-1} Pr(Z_1=z_1, ... Z_t=k, X)
   for (arma::uword i=0; i<N; i++){
     
-    lxis[i].col(0) = log(delta.t()) + tlstateprobs[i].col(0);
-    for (arma::uword t=1; t<Ts[i]; t++){
-      for (arma::uword k=1; k<K; k++){
-        lxis[i](k,t) = max(lxis[i].col(t-1) + lGamma.col(k));
+    arma::uword T = lstateprobs[i].n_rows;
+    arma::mat tlstateprobs = lstateprobs[i].t(); // transposed for faster column access
+    
+    // compute log-likelihood of most probable sequence up to t
+    // log max_{z_1, ... z_t-1} Pr(Z_1=z_1, ... Z_t=k, X)
+    arma::mat lxi(K, T);
+    lxi.col(0) = log(delta.t()) + tlstateprobs.col(0);
+    for (arma::uword t=1; t<T; t++){
+      for (arma::uword k=0; k<K; k++){
+        lxi(k,t) = max(lxi.col(t-1) + lGamma.col(k));
       }
-      lxis[i].col(t) += tlstateprobs[i].col(t);
+      lxi.col(t) += tlstateprobs.col(t);
     }
     
-  }
-  
-  // work backward to decode most probable sequence up to t
-  // argmax_{z_1, ... z_T} Pr(Z_1=z_1, ... Z_T=z_T, X)
-  for (arma::uword i=0; i<N; i++){
-    
-    std::vector<arma::uword> revseq; // reverse order
-    
-    arma::uword k_T;
-    lxis[i].col(Ts[i]-1).max(k_T); // (state mle @ T | xi) -> k_T
-    revseq.push_back(k_T);
+    // work backward to decode most probable sequence up to t
+    // argmax_{z_1, ... z_T} Pr(Z_1=z_1, ... Z_T=z_T, X)
+    seqs[i].resize(T);
+    arma::uword k;
+    lxi.col(T-1).max(k); // (state mle @ T | xi) -> k_T
+    seqs[i][T-1] = k;
+    for (arma::uword t=T-1; t>0; t--){
+      (lxi.col(t-1) + lGamma.col(k)).max(k); // (state mle @ t-1 | xi, state @ t) -> k
+      seqs[i][t-1] = k;
+    }
     
-    for (arma::uword t=Ts[i]-1; t>0; t--){
-      arma::uword k;
-      (lxis[i].col(t-1) + lGamma.col(revseq.back())).max(k); // (state mle @ t-1 | xi, state @ t) -> k
-      revseq.push_back(k);
+    for (arma::uword t=0; t<T; t++){
+      seqs[i][t]++; // convert to R indexing
     }
     
-    std::reverse(revseq.begin(), revseq.end());
-    for (arma::uword t=0; t<Ts[i]; t++){
-      revseq[t]++; // convert to R indexing
+  }
+  
+  return seqs;
+  
+}
+
+
+
+// streaming viterbi decoder for live use: create with viterbi_stream_cpp(), feed frames with
+// viterbi_stream_push_cpp(), which returns the states decided so far (R indexing), and finish
+// an obs seq with viterbi_stream_flush_cpp()
+// [[Rcpp::export]]
+SEXP viterbi_stream_cpp(
+  arma::rowvec delta,		          	  // initial distribution: use stationary distr of Markov chain
+  arma::mat Gamma,		              	// transition matrix
+  arma::uword lag = 100               // max delay in frames until a state is decided
+){
+  Rcpp::XPtr<viterbi_stream> decoder(new viterbi_stream(delta, Gamma, lag), true);
+  return decoder;
+}
+
+// [[Rcpp::export]]
+std::vector<arma::uword> viterbi_stream_push_cpp(
+  SEXP decoder,
+  arma::mat lstateprobs	              // new frames: rows=time, cols=states
+){
+  Rcpp::XPtr<viterbi_stream> stream(decoder);
+  std::vector<arma::uword> seq;
+  stream->push(lstateprobs, seq);
+  for (arma::uword t=0; t<seq.size(); t++){
+    seq[t]++; // convert to R indexing
+  }
+  return seq;
+}
+
+// [[Rcpp::export]]
+std::vector<arma::uword> viterbi_stream_flush_cpp(
+  SEXP decoder
+){
+  Rcpp::XPtr<viterbi_stream> stream(decoder);
+  std::vector<arma::uword> seq;
+  stream->flush(seq);
+  for (arma::uword t=0; t<seq.size(); t++){
+    seq[t]++; // convert to R indexing
+  }
+  return seq;
+}
+
+
+
+//////////////////////////////////////////////////////
+// score audio files with a trained HMM             //
+//////////////////////////////////////////////////////
+
+// trained model, set up once and shared read-only by all files
+struct hmm_scoring_model {
+  arma::rowvec delta;		          	  // initial distribution
+  arma::mat Gamma;			              // transition matrix
+  arma::rowvec center;                // standardization of the features: (x - center) / scale
+  arma::rowvec scale;
+  std::vector< arma::uvec > nonmissing_features;  // details on each missingness type
+  std::map<std::string, arma::uword> patterns;    // see missingness_patterns
+  std::vector<emission_state> emission;
+};
+
+// scores the frames of one file as they arrive from the tick loop: frames are standardized and
+// buffered in blocks, every block goes through the emission model, the scaled forward recursion
+// (log-likelihood) and the streaming viterbi decoder; nothing else of the file is kept
+class hmm_file_scorer {
+public:
+  static const arma::uword block_size = 256;
+  
+  hmm_file_scorer(const hmm_scoring_model &model_, arma::uword lag, bool decode_)
+    : llh(0), nFrames(0), model(&model_), decoder(model_.delta, model_.Gamma, lag), decode(decode_),
+      block(block_size, model_.center.n_elem), block_labels(block_size), nBlock(0),
+      key(model_.center.n_elem, '1') {}
+  
+  static void staticAddFrame(void *p, const FLOAT_DMEM *features, long nFeatures, double){
+    ((hmm_file_scorer *) p)->addFrame(features, nFeatures);
+  }
+  
+  void addFrame(const FLOAT_DMEM *features, long nFeatures){
+    if (!error.empty()){
+      return;
+    }
+    if ((arma::uword)nFeatures != block.n_cols){
+      std::ostringstream msg;
+      msg << "frame has " << nFeatures << " features, the model has " << block.n_cols;
+      error = msg.str();
+      return;
+    }
+    for (arma::uword m=0; m<block.n_cols; m++){
+      double x = features[m];
+      block(nBlock, m) = (x - model->center(m)) / model->scale(m);
+      key[m] = std::isnan(x) ? '0' : '1';
+    }
+    std::map<std::string, arma::uword>::const_iterator it = model->patterns.find(key);
+    if (it == model->patterns.end()){
+      std::ostringstream msg;
+      msg << "frame " << (nFrames + nBlock + 1) << ": missing features do not match any entry of nonmissing_features";
+      error = msg.str();
+      return;
+    }
+    block_labels(nBlock++) = it->second;
+    if (nBlock == block_size){
+      scoreBlock();
+    }
+  }
+  
+  // score the buffered frames and decide the remaining states, after the last frame
+  void finish(){
+    if (error.empty()){
+      scoreBlock();
+      if (decode){
+        decoder.flush(path);
+      }
+    }
+  }
+  
+  std::string error;
+  double llh;                         // log-likelihood of the frames so far
+  arma::uword nFrames;
+  std::vector<arma::uword> path;      // most probable states (decided so far)
+  
+private:
+  const hmm_scoring_model *model;
+  viterbi_stream decoder;
+  bool decode;
+  arma::mat block;                    // standardized frames, [block_size x M], first nBlock rows used
+  arma::uvec block_labels;
+  arma::uword nBlock;
+  std::string key;
+  arma::rowvec alpha;                 // scaled forward probs of the last frame
+  
+  void scoreBlock(){
+    if (nBlock == 0){
+      return;
     }
+    arma::mat X = nBlock == block_size ? block : block.head_rows(nBlock);
+    arma::mat lstateprobs(nBlock, model->Gamma.n_rows);
+    emission_lstateprobs(model->emission, X,
+                         rows_by_pattern(block_labels.head(nBlock), model->nonmissing_features.size()),
+                         model->nonmissing_features, lstateprobs);
     
-    seqs.push_back(revseq);
+    // scaled forward recursion, as in forward_scaled
+    for (arma::uword t=0; t<nBlock; t++){
+      double scale = lstateprobs.row(t).max();
+      arma::rowvec stateprobs = exp(lstateprobs.row(t) - scale);
+      if (nFrames == 0){
+        alpha = model->delta % stateprobs;
+      } else {
+        alpha = alpha * model->Gamma % stateprobs;
+      }
+      double C_t = arma::accu(alpha);
+      alpha /= C_t;
+      llh += log(C_t) + scale;
+      nFrames++;
+    }
     
+    if (decode){
+      decoder.push(lstateprobs, path);
+    }
+    nBlock = 0;
   }
+};
+
+// runs the openSMILE graph per file and hands the frames of the data sink directly to the scorer of the file
+class CRcppHmmScorer : public CRcppWave {
+public:
+  std::vector<hmm_file_scorer> scorers;   // one per input file
+protected:
+  virtual void prepare1file(cComponentManager *cMan, int iFile) {
+    CRcppWave::prepare1file(cMan, iFile);
+    cMan->setFeatureFrameListener(hmm_file_scorer::staticAddFrame, &scorers[iFile]);
+  }
+  virtual void getData1file(cComponentManager *cMan, int iFile) {
+    cMan->setFeatureFrameListener(nullptr, nullptr);
+    scorers[iFile].finish();
+  }
+};
+
+
+
+// log-likelihood and most probable state sequence of audio files under a trained HMM
+// features are extracted with config_string_in (as in rcpp_openSmileGetFeatures) and scored frame by
+// frame while the file is processed, the feature matrices are never built; features the config
+// outputs as NaN count as missing
+// [[Rcpp::export]]
+Rcpp::List hmm_score_files_cpp(
+  std::vector<std::string> audio_files_in,
+  std::string config_string_in,
+  arma::rowvec delta,		          	  // initial distribution: use stationary distr of Markov chain
+  arma::mat mus,			                // state-specific means: rows=covariates, cols=state
+  std::vector<arma::mat> Sigmas_in,		// state-specific vcov matrices: rows/cols=covariates, elements=state
+  arma::mat Gamma,			              // transition matrix
+  std::vector< arma::uvec > nonmissing_features,  // details on each missingness type
+  arma::rowvec center,                // feature standardization used in training: (x - center) / scale
+  arma::rowvec scale,
+  double lambda = 0,			            // regularization parameter
+  std::string covariance = "full",    // structure of the state cov mats: "full", "diagonal" or "tied"
+  bool decode = true,                 // return the most probable state sequences
+  arma::uword lag = 100,              // max delay in frames of the streaming viterbi decoder
+  int nWorkers = 1                    // files processed concurrently
+){
+  setlocale(LC_ALL, " ");
   
-  return seqs;
+  arma::uword M = mus.n_rows;			  // number of measured covariates
+  arma::uword K = Gamma.n_rows;			// number of states
+  if (center.n_elem != M || scale.n_elem != M){
+    Rcpp::stop("center and scale must have one element per feature");
+  }
   
+  hmm_scoring_model model;
+  model.delta = delta;
+  model.Gamma = Gamma;
+  model.center = center;
+  model.scale = scale;
+  model.nonmissing_features = nonmissing_features;
+  model.patterns = missingness_patterns(nonmissing_features, M);
+  arma::cube Sigmas(M, M, K);
+  for (arma::uword k=0; k<K; k++){
+    Sigmas.slice(k) = Sigmas_in[k];
+  }
+  cov_structure cov = parse_covariance(covariance);
+  constrain_covs(Sigmas, arma::ones<arma::vec>(K), cov);
+  model.emission = make_emission_model(mus, Sigmas, nonmissing_features, lambda, cov);
+  
+  //tilda handling  
+  for (arma::uword i=0; i<audio_files_in.size(); i++){
+    audio_files_in[i] = tildaString(audio_files_in[i]);  
+  }
+  
+  CRcppHmmScorer scorer;
+  scorer.scorers.assign(audio_files_in.size(), hmm_file_scorer(model, lag, decode));
+  scorer.setNumWorkers(nWorkers);
+  try {
+    if (scorer.setInputData(audio_files_in, config_string_in)){
+      scorer.work();
+    }
+  }
+  catch (const std::bad_alloc& e) {
+    Rcpp::stop("Allocation failed: " + std::string(e.what()));
+  }
+  
+  arma::vec llhs(audio_files_in.size());
+  std::vector<arma::uword> nframes(audio_files_in.size());
+  Rcpp::List paths;
+  std::vector<std::string> errors(audio_files_in.size());
+  for (arma::uword i=0; i<audio_files_in.size(); i++){
+    hmm_file_scorer &file = scorer.scorers[i];
+    llhs(i) = file.error.empty() && file.nFrames > 0 ? file.llh : arma::datum::nan;
+    nframes[i] = file.nFrames;
+    for (arma::uword t=0; t<file.path.size(); t++){
+      file.path[t]++; // convert to R indexing
+    }
+    paths.push_back(file.path);
+    errors[i] = file.error;
+  }
+  
+  return Rcpp::List::create(
+    Rcpp::Named("llhs") = llhs,
+    Rcpp::Named("nframes") = nframes,
+    Rcpp::Named("paths") = paths,
+    Rcpp::Named("errors") = errors
+  );
 }
@@ -222,6 +222,21 @@ const char * cCommandlineParser::getStr( const char *name ) const
   return 0;
 }
 
+int cCommandlineParser::setStr( const char *name, const char *value )
+{
+  int n = findOpt( name );
+  if (n >= 0) {
+    if (opt[n].type != CMDOPT_STR)
+      { COMP_ERR("commandline argument '%s' is not of type string!",name); }
+    if (opt[n].dfltStr != nullptr) free(opt[n].dfltStr);
+    if (value != nullptr) opt[n].dfltStr = strdup(value);
+    else opt[n].dfltStr = nullptr;
+    opt[n].isSet = 1;
+    return 1;
+  }
+  return 0;
+}
+
 int cCommandlineParser::isSet( const char *name ) const
 {
   int n = findOpt( name );
@@ -102,6 +102,8 @@ Also be sure to include the necessary component header files
 
 
 #include <iocore/RcppDataSink.hpp>
+#include <algorithm>
+#include <utility>
 #if defined(WIN32)
 #include <sys/time.h>
 #endif
@@ -109,47 +111,40 @@ Also be sure to include the necessary component header files
 
 //-----------------------------------------
 
-void cComponentManager::setWaveFeaturesCB(const arma::rowvec &features_row, const arma::rowvec & timeFrame)
+#define RCPP_FEATURES_CHUNK 1024   // rows allocated at once if the number of frames is not known (yet)
+
+void cComponentManager::reserveFeatureRows(long nRows, long nFeatures)
 {
-  if(nullptr == rcpp_wave_header || 
-     0 == rcpp_audio_features_buffer.n_rows)
-  {
-    arma::mat addMat(features_row);
-    rcpp_audio_features_buffer.insert_rows(rcpp_audio_features_buffer.n_rows, addMat);
-    rcpp_audio_timestamps_buffer.insert_cols(rcpp_audio_timestamps_buffer.n_cols, timeFrame);    
-  }
-  else
-  {
-    if(nullptr == rcpp_audio_timestamps)
-    {
-      SMILE_MSG(4,"cComponentManager::setWaveFeaturesCB : frameStep = %lf",frameStep);
-      SMILE_MSG(4,"cComponentManager::setWaveFeaturesCB : rcpp_wave_header->sampleRate = %d",rcpp_wave_header->sampleRate);
-      SMILE_MSG(4,"cComponentManager::setWaveFeaturesCB : rcpp_wave_header->nBlocks = %d",rcpp_wave_header->nBlocks);
-      SMILE_MSG(4,"cComponentManager::setWaveFeaturesCB : rcpp_audio_features_buffer.n_cols = %d",rcpp_audio_features_buffer.n_cols);      
-      if(frameStep < 0.0000000001)
-        SMILE_ERR(0,"cComponentManager::setWaveFeaturesCB : invalid frameStep = 0.");  
-      int timestamps_count =  (int)(rcpp_wave_header->nBlocks / (rcpp_wave_header->sampleRate * frameStep));
-      SMILE_MSG(4,"cComponentManager::setWaveFeaturesCB : timestamps_count = %d",timestamps_count);       
-      rcpp_audio_timestamps = new arma::rowvec(timestamps_count);
-      rcpp_audio_features = new arma::mat(timestamps_count, rcpp_audio_features_buffer.n_cols);
-      for(int iRow=0; iRow<rcpp_audio_features_buffer.n_rows; iRow++ )
-      {
-        rcpp_audio_timestamps->operator()(iRow) = rcpp_audio_timestamps_buffer(iRow);
-        for(int iCol=0; iCol<rcpp_audio_features_buffer.n_cols; iCol++)
-        {
-          rcpp_audio_features->operator()(iRow, iCol) = rcpp_audio_features_buffer(iRow, iCol);
-        }
-      }
-      currentRow = rcpp_audio_features_buffer.n_rows;
-    }
-    
-    for(int iFeat=0; iFeat<features_row.n_cols; iFeat++)
-    {
-      rcpp_audio_features->operator()(currentRow, iFeat) = features_row(iFeat);
-    }
-    rcpp_audio_timestamps->operator()(currentRow) = timeFrame(0);
-    currentRow++;
+  if (nRows <= rcpp_features_capacity && (long)rcpp_audio_features.n_cols == nFeatures)
+    return;
+  // resize keeps the rows already written
+  rcpp_audio_features.resize(nRows, nFeatures);
+  rcpp_audio_timestamps.resize(nRows);
+  rcpp_features_capacity = nRows;
+}
+
+void cComponentManager::setWaveFeaturesCB(const FLOAT_DMEM *features, long nFeatures, double time)
+{
+  if (nullptr != rcpp_frame_listener) {
+    rcpp_frame_listener(rcpp_frame_listener_obj, features, nFeatures, time);
+    return;
+  }
+  if (0 == currentRow) {
+    reserveFeatureRows(rcpp_features_estimate > 0 ? rcpp_features_estimate : RCPP_FEATURES_CHUNK, nFeatures);
+  } else if ((long)rcpp_audio_features.n_cols != nFeatures) {
+    SMILE_ERR(1,"cComponentManager::setWaveFeaturesCB : frame has %ld features, expected %ld, frame ignored.",nFeatures,(long)rcpp_audio_features.n_cols);
+    return;
+  } else if (currentRow >= rcpp_features_capacity) {
+    // more frames than estimated: grow by chunks (at least doubling), amortised copy only
+    reserveFeatureRows(rcpp_features_capacity + std::max(rcpp_features_capacity, (long)RCPP_FEATURES_CHUNK), nFeatures);
   }
+  double *dst = rcpp_audio_features.memptr() + currentRow;
+  const long stride = rcpp_features_capacity;
+  for (long iFeat=0; iFeat<nFeatures; iFeat++) {
+    dst[iFeat*stride] = static_cast<double>(features[iFeat]);
+  }
+  rcpp_audio_timestamps[currentRow] = time;
+  currentRow++;
 }
 
 void cComponentManager::setWaveFrameBordersCB(const double &frameStart,  const double &frameEnd)
@@ -167,7 +162,22 @@ void cComponentManager::setWaveFrameBordersCB(const double &frameStart,  const d
 
 void cComponentManager::setWaveHeaderCB(const sWaveParameters &rcpp_header_)
 {
+  delete rcpp_wave_header;
   rcpp_wave_header = new sWaveParameters(rcpp_header_);
+  SMILE_MSG(4,"cComponentManager::setWaveHeaderCB : frameStep = %lf",frameStep);
+  SMILE_MSG(4,"cComponentManager::setWaveHeaderCB : rcpp_wave_header->sampleRate = %d",rcpp_wave_header->sampleRate);
+  SMILE_MSG(4,"cComponentManager::setWaveHeaderCB : rcpp_wave_header->nBlocks = %d",rcpp_wave_header->nBlocks);
+  if (frameStep < 0.0000000001 || rcpp_wave_header->sampleRate <= 0) {
+    SMILE_ERR(0,"cComponentManager::setWaveHeaderCB : invalid frameStep = 0, the number of frames cannot be estimated.");
+    return;
+  }
+  if (rcpp_keep_samples)
+    rcpp_wave_samples.reserve(rcpp_wave_header->nBlocks * (long)rcpp_wave_header->nChan);
+  rcpp_features_estimate = (long)(rcpp_wave_header->nBlocks / (rcpp_wave_header->sampleRate * frameStep));
+  SMILE_MSG(4,"cComponentManager::setWaveHeaderCB : timestamps_count = %ld",rcpp_features_estimate);
+  // frames that arrived before the header are kept, the rest is allocated at once
+  if (currentRow > 0)
+    reserveFeatureRows(rcpp_features_estimate, rcpp_audio_features.n_cols);
 }
 
 
@@ -175,25 +185,67 @@ bool cComponentManager::getFeatures( arma::mat & rcpp_audio_features_out,
                                      arma::rowvec & rcpp_audio_timestamps_out,
                                      sWaveParameters & rcpp_wave_header_out)
 {
-  if(nullptr == rcpp_audio_features 
-       ||
-    nullptr == rcpp_audio_timestamps
+  if(0 == currentRow
        ||
     nullptr == rcpp_wave_header)
     return false;
   
-  rcpp_audio_features_out = *rcpp_audio_features;
-  rcpp_audio_timestamps_out = *rcpp_audio_timestamps;
+  // rows as estimated from the wave header (zero padded), or all frames if there are more;
+  // the resize is a no-op if the estimate was right
+  long nRows = std::max((long)currentRow, rcpp_features_estimate);
+  if (nRows != rcpp_features_capacity) {
+    rcpp_audio_features.resize(nRows, rcpp_audio_features.n_cols);
+    rcpp_audio_timestamps.resize(nRows);
+  }
+  rcpp_audio_features_out = std::move(rcpp_audio_features);
+  rcpp_audio_timestamps_out = std::move(rcpp_audio_timestamps);
   rcpp_wave_header_out = *rcpp_wave_header;
+  rcpp_audio_features.reset();
+  rcpp_audio_timestamps.reset();
+  rcpp_features_capacity = 0;
+  currentRow = 0;
   return true;
 }
 
 
+void cComponentManager::setWaveSamplesCB(const FLOAT_DMEM *samples, long nFrames, long nChan)
+{
+  if (!rcpp_keep_samples) return;
+  rcpp_wave_samples_nChan = nChan;
+  size_t n0 = rcpp_wave_samples.size();
+  rcpp_wave_samples.resize(n0 + nFrames*nChan);
+  int32_t *out = rcpp_wave_samples.data() + n0;
+  // same int32 full scale as CRcppWave::parseWavFile
+  for (long i=0; i<nFrames*nChan; i++) {
+    double v = samples[i];
+    if (v > 1.0) v = 1.0;
+    else if (v < -1.0) v = -1.0;
+    out[i] = (int32_t)(v * 2147483647.0);
+  }
+}
+
+void cComponentManager::getWaveSamples(std::vector<int32_t> & rcpp_wave_samples_out, long & nChan_out)
+{
+  long nChan = rcpp_wave_samples_nChan;
+  nChan_out = nChan;
+  if (nChan <= 1) {
+    rcpp_wave_samples_out = std::move(rcpp_wave_samples);
+  } else {
+    long nFrames = (long)rcpp_wave_samples.size() / nChan;
+    rcpp_wave_samples_out.resize(nFrames*nChan);
+    for (long c=0; c<nChan; c++)
+      for (long i=0; i<nFrames; i++)
+        rcpp_wave_samples_out[c*nFrames + i] = rcpp_wave_samples[i*nChan + c];
+  }
+  rcpp_wave_samples.clear();
+  rcpp_wave_samples.shrink_to_fit();
+}
+
 void cComponentManager::getWaveFrameBorders(arma::rowvec & rcpp_audio_start_frames_out,
                                             arma::rowvec & rcpp_audio_end_frames_out)
 {
-  rcpp_audio_start_frames_out = rcpp_audio_start_frames;
-  rcpp_audio_end_frames_out = rcpp_audio_end_frames;
+  rcpp_audio_start_frames_out = std::move(rcpp_audio_start_frames);
+  rcpp_audio_end_frames_out = std::move(rcpp_audio_end_frames);
 }
 /************************/
 
@@ -217,6 +269,8 @@ void cComponentManager::registerType(cConfigManager *_confman) {
     //#ifdef DEBUG
     complist->setField( "execDebug", "print summary of component run statistics to log for each tick", 0);
     complist->setField( "oldSingleIterationTickLoop", "1 = run the old single iteration tick loop with a single EOI tick loop after the main tick loop. Use this for backwards compatibility for older configs with components such as fullinputMean.", 0);
+    complist->setField( "tickScheduler", "1 = data-driven ticks in single thread mode: components are ticked in the data flow order of their levels, and only if one of their input levels was written (or one of their output levels was read) since their last unsuccessful tick. All components are ticked in the end-of-input tick loops. 0 = tick every component in every tick (default).", 0);
+    complist->setField( "tickBatch", "max. number of successive ticks of a component within one tick of the data-driven scheduler, as long as the component succeeds (processes several frames per tick loop iteration)", 4);
     //#endif
     ConfigInstance *Tdflt = new ConfigInstance( "cComponentManagerInst", complist, 1 );
     _confman->registerType(Tdflt);
@@ -648,6 +702,8 @@ lastComponent(0),
 componentThreadId(nullptr),
 messageCounter(0), 
 oldSingleIterationTickLoop(0),
+tickScheduler(0),
+tickBatch(1),
 pauseStartNr(-1),
 tickLoopPaused(0),
 tickLoopPauseTimeout(10),
@@ -946,6 +1002,13 @@ void cComponentManager::createInstances(int readConfig)
   tmp = myvprint("%s.oldSingleIterationTickLoop", CM_CONF_INST);
   oldSingleIterationTickLoop = confman->getInt(tmp);
   free(tmp);
+  tmp = myvprint("%s.tickScheduler", CM_CONF_INST);
+  tickScheduler = confman->getInt(tmp);
+  free(tmp);
+  tmp = myvprint("%s.tickBatch", CM_CONF_INST);
+  tickBatch = confman->getInt(tmp);
+  free(tmp);
+  if (tickBatch < 1) tickBatch = 1;
   //#endif
 
 
@@ -1027,6 +1090,7 @@ void cComponentManager::createInstances(int readConfig)
 
     SMILE_MSG(2,"successfully finished createInstances\n                                 (%i component instances were finalised, %i data memories were finalised)", nFinC, nFinD);
     ready = 1;
+    buildSchedule();
   }
 }
 
@@ -1126,8 +1190,19 @@ int cComponentManager::registerComponentInstance(cSmileComponent * _component, c
         if (nullptr != waveSource &&
             RccpWavFiles == rccpMode) {
           waveSource->connectSetWaveHeaderCB(cComponentManager::staticSetWaveHeaderCB);
+          waveSource->connectSetWaveSamplesCB(cComponentManager::staticSetWaveSamplesCB);
         }
       }
+#ifdef HAVE_MPGLIB
+      {
+        cMp3Source *mp3Source = dynamic_cast<cMp3Source *>(component[id]);
+        if (nullptr != mp3Source &&
+            RccpWavFiles == rccpMode) {
+          mp3Source->connectSetWaveHeaderCB(cComponentManager::staticSetWaveHeaderCB);
+          mp3Source->connectSetWaveSamplesCB(cComponentManager::staticSetWaveSamplesCB);
+        }
+      }
+#endif
       {
         cTurnDetector *turnDetector = dynamic_cast<cTurnDetector *>(component[id]);
         if (nullptr != turnDetector &&
@@ -1139,8 +1214,8 @@ int cComponentManager::registerComponentInstance(cSmileComponent * _component, c
         cWinToVecProcessor *winToVecProcessor = dynamic_cast<cWinToVecProcessor *>(component[id]);
         if (nullptr != winToVecProcessor &&
             RccpWavFiles == rccpMode) {
-          SMILE_MSG(0, "cComponentManager::registerComponentInstance frameStep=%lf", frameStep);
           frameStep = winToVecProcessor->getFrameStep();
+          SMILE_MSG(4, "registerComponentInstance: frameStep=%lf", frameStep);
         }
       }      
     }
@@ -1193,10 +1268,31 @@ void cComponentManager::resetInstances()
   }
   nComponents = 0;
   lastComponent = 0; // ???
+  schedule.clear();
   ready=0;    // flag that indicates if all components are set up and ready...
   isConfigured=0;
   isFinalised=0;
   EOI=0;
+  EOIcondition=0;
+  resetRcppOutput();
+}
+
+void cComponentManager::resetRcppOutput()
+{
+  delete rcpp_wave_header;
+  rcpp_wave_header = nullptr;
+  rcpp_audio_features.reset();
+  rcpp_audio_timestamps.reset();
+  rcpp_features_capacity = 0;
+  rcpp_features_estimate = 0;
+  rcpp_audio_start_frames.reset();
+  rcpp_audio_end_frames.reset();
+  rcpp_wave_samples.clear();
+  rcpp_wave_samples.shrink_to_fit();
+  rcpp_wave_samples_nChan = 1;
+  currentRow = 0;
+  currentRowTurn = 0;
+  frameStep = -1.f;
 }
 
 int cComponentManager::findComponentInstance(const char *_compname) const
@@ -1283,9 +1379,137 @@ double cComponentManager::getSmileTime()
   return ( (double)(curTime.tv_sec - startTime.tv_sec) + (double)(curTime.tv_usec - startTime.tv_usec)/1000000.0 );
 }
 
+/* data-driven scheduling: the read/write requests registered with the data memories give the levels
+   each component reads and writes (requests of sub-components such as "inst.reader" belong to "inst");
+   the components are ordered so that the writer of a level comes before its readers (the config order is kept
+   otherwise, and for cycles) */
+void cComponentManager::buildSchedule()
+{
+  schedule.clear();
+  if (!tickScheduler) return;
+  int n = lastComponent + 1;
+  std::vector<sSchedEntry> entries(n);
+  for (int i=0; i<n; i++) {
+    entries[i].id = i;
+    entries[i].lastRun = 1;
+  }
+  // owner component index of the request of a (sub-)component instance
+  auto findOwner = [this](const char *instName) {
+    std::string name(instName != nullptr ? instName : "");
+    while (!name.empty()) {
+      int id = findComponentInstance(name.c_str());
+      if (id >= 0) return id;
+      size_t dot = name.rfind('.');
+      if (dot == std::string::npos) break;
+      name.resize(dot);
+    }
+    return -1;
+  };
+  for (int i=0; i<n; i++) {
+    cDataMemory *dm = dynamic_cast<cDataMemory *>(component[i]);
+    if (dm == nullptr) continue;
+    for (int w=0; w<2; w++) {
+      int nRq = w ? dm->getNWriteRequests() : dm->getNReadRequests();
+      for (int r=0; r<nRq; r++) {
+        const sDmLevelRWRequest *rq = w ? dm->getWriteRequest(r) : dm->getReadRequest(r);
+        int id = findOwner(rq->instanceName);
+        int level = dm->findLevel(rq->levelName);
+        if ((id < 0)||(level < 0)) continue;
+        sSchedLevel l = { dm, level };
+        (w ? entries[id].outputs : entries[id].inputs).push_back(l);
+      }
+    }
+  }
+  // topological order (Kahn), ready components are taken in config order
+  std::vector<int> nPred(n, 0);
+  std::vector< std::vector<int> > succ(n);
+  for (int i=0; i<n; i++) {
+    for (const sSchedLevel &in : entries[i].inputs) {
+      for (int j=0; j<n; j++) {
+        if (j == i) continue;
+        for (const sSchedLevel &out : entries[j].outputs) {
+          if ((out.dm == in.dm)&&(out.level == in.level)) {
+            succ[j].push_back(i);
+            nPred[i]++;
+          }
+        }
+      }
+    }
+  }
+  std::vector<char> done(n, 0);
+  for (int nDone=0; nDone<n; nDone++) {
+    int next = -1;
+    for (int i=0; i<n; i++) {
+      if (!done[i] && nPred[i] == 0) { next = i; break; }
+    }
+    if (next < 0) {  // cycle: continue in config order
+      for (int i=0; i<n; i++) {
+        if (!done[i]) { next = i; break; }
+      }
+    }
+    done[next] = 1;
+    for (int j : succ[next]) nPred[j]--;
+    if (component[next] != nullptr) schedule.push_back(entries[next]);
+  }
+  SMILE_MSG(3,"data-driven tick scheduler: %i component instances in data flow order", (int)schedule.size());
+}
+
+long cComponentManager::tickScheduled(long long tickNr, long lastNrun)
+{
+  long nRun = 0;
+  char *stat=nullptr;
+  for (sSchedEntry &e : schedule) {
+    int i = e.id;
+    if ((component[i] == nullptr)||(componentThreadId[i] == -2)) continue;
+    if (!EOIcondition && !e.lastRun && !e.inputs.empty()) {
+      // an unsuccessful tick would fail again unless an input level was written or an output level was read
+      bool changed = false;
+      for (size_t l=0; l<e.inputs.size() && !changed; l++) {
+        changed = e.inputs[l].dm->getCurW(e.inputs[l].level) != e.inputW[l];
+      }
+      for (size_t l=0; l<e.outputs.size() && !changed; l++) {
+        changed = e.outputs[l].dm->getCurR(e.outputs[l].level) != e.outputR[l];
+      }
+      if (!changed) continue;
+    }
+    int nBatch = 0;
+    do {
+      e.inputW.resize(e.inputs.size());
+      for (size_t l=0; l<e.inputs.size(); l++) {
+        e.inputW[l] = e.inputs[l].dm->getCurW(e.inputs[l].level);
+      }
+      e.outputR.resize(e.outputs.size());
+      for (size_t l=0; l<e.outputs.size(); l++) {
+        e.outputR[l] = e.outputs[l].dm->getCurR(e.outputs[l].level);
+      }
+      SMILE_DBG(4,"~~~~> 'ticking' component '%s' (idx %i)",component[i]->getInstName(),i);
+      e.lastRun = component[i]->tick(tickNr, EOIcondition, lastNrun);
+      if (e.lastRun) nBatch++;
+    } while (e.lastRun && nBatch < tickBatch);
+    if (nBatch > 0) {
+      nRun++;
+      if (execDebug) { // show summary of components executed during this tick
+        if (stat != nullptr) {
+          char *x = stat;
+          stat = myvprint("%s %s(%i)",x,component[i]->getInstName(),nBatch);
+          free(x);
+        } else {
+          stat = myvprint("%s(%i)",component[i]->getInstName(),nBatch);
+        }
+      }
+    }
+  }
+  if (execDebug) { // show summary of components executed during this tick
+    SMILE_PRINT("SUMMARY tick #%i (scheduled), (eoi=%i) ran (%i): %s\n", (int)tickNr, EOI, nRun, stat);
+    if (stat != nullptr) free(stat);
+  }
+  return nRun;
+}
+
 long cComponentManager::tick(int threadId, long long tickNr, long lastNrun)
 {
   if (!ready) return 0;
+  if ((threadId == -1)&&(!schedule.empty())) return tickScheduled(tickNr, lastNrun);
   int i;
   long nRun = 0; int nRunnable = 0;
   char *stat=nullptr;
@@ -2244,7 +2468,4 @@ cComponentManager::~cComponentManager()
   if (regFnlist != nullptr) free(regFnlist);
 #endif
 #endif
-  delete rcpp_audio_features;
-  delete rcpp_audio_timestamps;
-  delete rcpp_wave_header;
 }
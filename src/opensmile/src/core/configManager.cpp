@@ -450,7 +450,8 @@ ConfigType::ConfigType(const char *_name, int N_) :
 ConfigType::ConfigType( ConfigType const& copy, const char *_newname) :
   N(copy.N),
   I(copy.I),
-  element(nullptr)
+  element(nullptr),
+  fieldIndex(copy.fieldIndex)
 {
   if (_newname != nullptr) {
     // save last name as parent name
@@ -916,6 +917,7 @@ int ConfigType::setField(const char *_name, const char *description, int type, i
     //printf("name: %s.%s (Desc)\n",this->getName(),_name); fflush(stdout);
     element[I].N = N_;
     element[I].isMandatory = 0;
+    fieldIndex.emplace(element[I].name, I);
     return I++;
   } else {
     element[FF].enabled = 1;
@@ -1019,6 +1021,12 @@ int ConfigType::findField(const char *fname, int *arrI, char **arrS) const
     SMILE_DBG(7,"ConfigType::findField: called with fname == nullptr!");
     return -1;
   }
+  if (strchr(fname,'[') == nullptr) {
+    // plain field name, no copy needed
+    if (arrI != nullptr) *arrI = -1;
+    auto it = fieldIndex.find(fname);
+    return it != fieldIndex.end() ? it->second : -1;
+  }
   char *base = strdup(fname);
   char * s = strchr(base,'[');
   int isArr=0;
@@ -1054,25 +1062,21 @@ int ConfigType::findField(const char *fname, int *arrI, char **arrS) const
   } else if (arrI != nullptr) { *arrI = -1; }
 
   // now find "base":
-  int i;
-  for (i=0; i<N; i++) {
-    //if (element[i].name != nullptr) {
-      if (!strcmp(element[i].name,base)) {
-        free(base);
+  auto it = fieldIndex.find(base);
+  free(base);
+  if (it != fieldIndex.end()) {
+    int i = it->second;
 /*
-        if ((element[i].type >= CFTP_ARR)&&(!isArr)) {
-          SMILE_ERR(1,"missing array index [] for element '%s'",element[i].name);
-          return -1;
-        }  TODO: move this somewhere else (in every function that uses findField(H)....!)*/
-        if ((element[i].type < CFTP_ARR)&&(isArr)) {
-          SMILE_ERR(1,"array index [] specified for non-array element '%s'",element[i].name);
-          return -1;
-        }
-        return i;
-      }
-    //}
+    if ((element[i].type >= CFTP_ARR)&&(!isArr)) {
+      SMILE_ERR(1,"missing array index [] for element '%s'",element[i].name);
+      return -1;
+    }  TODO: move this somewhere else (in every function that uses findField(H)....!)*/
+    if ((element[i].type < CFTP_ARR)&&(isArr)) {
+      SMILE_ERR(1,"array index [] specified for non-array element '%s'",element[i].name);
+      return -1;
+    }
+    return i;
   }
-  free(base);
   return -1;  // field not found
 }
 
@@ -1286,6 +1290,36 @@ int ConfigInstance::getType(const char *_name)
   } else { return r; }
 }
 
+/* unlike findField, this does not raise errors for names that do not exist, it returns an invalid handle */
+ConfigField ConfigInstance::getField(const char *_name)
+{
+  ConfigInstance *cur = this;
+  while ((_name != nullptr)&&(cur != nullptr)) {
+    char *base=nullptr;
+    const char *rem=nullptr;
+    int h = instNameSplit(_name, &base, &rem);
+    int aIdx = -1;
+    char *aStr = nullptr;
+    int idx = cur->type->findField(base,&aIdx,&aStr);
+    if (base!=nullptr) free(base);
+    if ((idx < 0)||(idx >= cur->N)||(cur->field[idx] == nullptr)) {
+      if (aStr != nullptr) free(aStr);
+      return ConfigField();
+    }
+    if (aStr != nullptr) {  // associative array: the key is resolved now, too
+      aIdx = cur->field[idx]->findField(aStr,1);
+      free(aStr);
+      if (aIdx < 0) return ConfigField();
+    }
+    if (h == 0) return ConfigField(cur, idx, aIdx);
+    int t = cur->field[idx]->getType();
+    if ((t != CFTP_OBJ)&&(t != CFTP_OBJ_ARR)) return ConfigField();
+    cur = cur->field[idx]->getObj(aIdx);
+    _name = rem;
+  }
+  return ConfigField();
+}
+
 /* this function does not check n for valid range!!*/
 /* the memory pointed to by val is freed, if the content is copied over exisiting content,
    otherwise the memory is not freed and the pointer is copied. the memory pointed to by
@@ -1583,12 +1617,38 @@ int cFileConfigReader::addLine(int n, const char *line, int lineNr)
 // TODO: cache config files which have already been loaded once (including all includes?)
 /* each instance has a header: [instname:type] followed by the lines with values */
 /* including other config files can be done via the command:  \{path/and/file_to.include} */
+/* reads the next line of a config from the file "in", or, if in == nullptr, from the string at *pos (which is advanced);
+   same semantics as smile_getline, returns -1 at the end of the input */
+static long configReadLine(char **lineptr, size_t *n, FILE *in, const char **pos)
+{
+  if (in != nullptr) return (long)smile_getline(lineptr, n, in);
+  if ((*pos == nullptr)||(**pos == 0)) return -1;
+  const char *eol = strchr(*pos,'\n');
+  size_t len = (eol != nullptr) ? (size_t)(eol - *pos) + 1 : strlen(*pos);
+  if ((*lineptr == nullptr)||(*n < len+1)) {
+    char *tmp = (char *)realloc(*lineptr, len+1);
+    if (tmp == nullptr) OUT_OF_MEMORY;
+    *lineptr = tmp; *n = len+1;
+  }
+  memcpy(*lineptr, *pos, len);
+  (*lineptr)[len] = 0;
+  *pos += len;
+  return (long)len;
+}
+
 int cFileConfigReader::openInput(const char*fname, int *idx0)
 {
   FILE *in=nullptr;
+  const char *inPos = nullptr;
   char *localThisLevelFile = nullptr;
   // open file "_inputpath"
-  if (fname == nullptr) {
+  if ((fname == nullptr)&&(inputString != nullptr)) {
+    SMILE_MSG(3, "reading config '%s' from memory", inputPath);
+    inPos = inputString;
+    if (lastLevelFile != nullptr)
+      free(lastLevelFile);
+    lastLevelFile = nullptr;
+  } else if (fname == nullptr) {
     SMILE_MSG(3, "reading config file '%s'", inputPath);
     in = fopen(inputPath, "r");
     if (in == nullptr) 
@@ -1672,7 +1732,7 @@ int cFileConfigReader::openInput(const char*fname, int *idx0)
   int inComment = 0;
 
   do {
-    read = smile_getline(&line, &n, in);
+    read = configReadLine(&line, &n, in, &inPos);
     char *origline = line;
     
     if ((read != (size_t)-1)&&(origline!=nullptr)) { ///XXXX
@@ -1806,7 +1866,7 @@ int cFileConfigReader::openInput(const char*fname, int *idx0)
       line = nullptr; 
     }
   } while (read != (size_t)(-1));
-  fclose(in);
+  if (in != nullptr) fclose(in);
   if (line != nullptr) { 
     free(line); 
     line = nullptr; 
@@ -2335,7 +2395,8 @@ cConfigManager::cConfigManager(cCommandlineParser *parser) :
   nTypes(0), 
   nInst(0),
   nReaders(0),
-  cmdparser(parser)
+  cmdparser(parser),
+  nInstChanges(0)
 {
   defaults = (ConfigInstance **)calloc(1,sizeof(ConfigInstance *)*NEL_ALLOC_BLOCK);
   if (defaults != nullptr) nTypesAlloc = NEL_ALLOC_BLOCK;
@@ -2386,6 +2447,8 @@ int cConfigManager::addInstance(ConfigInstance *_inst)
     } else { OUT_OF_MEMORY; }
   }
   inst[nInst] = _inst;
+  instIndex.emplace(_inst->getName(), nInst);
+  nInstChanges++;
   return nInst++;
 }
 
@@ -2400,6 +2463,12 @@ int cConfigManager::deleteInstance(const char *_instname)   /* deletes instance
 	}
 	inst[i] = nullptr;
 	nInst--;
+	// indices after idx have moved
+	instIndex.clear();
+	for (i=nInst-1; i>=0; i--) {
+	  instIndex[inst[i]->getName()] = i;
+	}
+	nInstChanges++;
 	return 1;
   } else {
     SMILE_ERR(1,"cannot delete instance '%s' -> not found!",_instname);
@@ -2410,31 +2479,32 @@ int cConfigManager::deleteInstance(const char *_instname)   /* deletes instance
 /* return value is index of instance or -1 if instance was not found */
 int cConfigManager::findInstance(const char *_instname) const
 {
-  int i;
   if (_instname == nullptr) {
     SMILE_DBG(7,"findInstance called with _instname = nullptr!!");
     return -1;
   }
-  for (i=0; i<nInst; i++) {
-    SMILE_DBG(7,"findInstance: comparing instname ('%s') with '%s' for inst %i",_instname,inst[i]->getName(),i);
-    if (!strcmp(inst[i]->getName(),_instname)) {
-      SMILE_DBG(7,"findInstance: match (%i)!",i);
-      return i;
-    }
+  auto it = instIndex.find(_instname);
+  if (it != instIndex.end()) {
+    SMILE_DBG(7,"findInstance: match (%i)!",it->second);
+    return it->second;
   }
   return -1;
 }
 
+int cConfigManager::findInstance(const char *_instname, size_t len) const
+{
+  if (_instname == nullptr) return -1;
+  auto it = instIndex.find(std::string(_instname, len));
+  if (it != instIndex.end()) return it->second;
+  return -1;
+}
+
 /* return value is index of instance or -1 if instance was not found */
 int cConfigManager::findType(const char *_typename) const
 {
-  int i;
   if (_typename == nullptr) return -1;
-  for (i=0; i<nTypes; i++) {
-    if (defaults[i]->getType() != nullptr) {
-      if (!strcmp(defaults[i]->getTypeName(),_typename)) return i;
-    }
-  }
+  auto it = typeIndex.find(_typename);
+  if (it != typeIndex.end()) return it->second;
   return -1;
 }
 
@@ -2504,6 +2574,7 @@ int cConfigManager::updateInstance(ConfigInstance *_inst)
   } else {
     //update only
     inst[idx]->updateWith(_inst);
+    nInstChanges++;
     update = 1;
   }
   return update;
@@ -2530,6 +2601,7 @@ int cConfigManager::registerType(ConfigInstance *_type)
     } else { OUT_OF_MEMORY; }
   }
   defaults[nTypes] = _type;
+  if (_type->getType() != nullptr) typeIndex.emplace(_type->getTypeName(), nTypes);
   return nTypes++;
 }
 
@@ -2581,11 +2653,10 @@ void cConfigManager::readConfig()
 /* no hierarchical names are supported... */
 ConfigInstance * cConfigManager::getInstance(const char *_instname)
 {
-  const char * _subname;
-  char * _instbasename=nullptr;
-  int h = instNameSplit(_instname, &_instbasename, &_subname);
-  int idx = findInstance(_instbasename);
-  if (_instbasename != nullptr) free(_instbasename);
+  if (_instname == nullptr) return nullptr;
+  const char *x = strchr(_instname,'.');
+  int h = (x != nullptr);
+  int idx = h ? findInstance(_instname, (size_t)(x - _instname)) : findInstance(_instname);
   if (idx >= 0) {
     if (h) { // search through the hierarchy
       CONF_MANAGER_ERR("cConfigManager::getInstance: cannot get sub-instance, use getValue instead!");
@@ -2598,15 +2669,14 @@ ConfigInstance * cConfigManager::getInstance(const char *_instname)
 
 const ConfigValue * cConfigManager::getValue(const char *_name) const
 {
-  const char * _subname=nullptr;
-  char * _instbasename=nullptr;
-
   SMILE_DBG(7,"cConfigManager::getValue: _name = '%s'",_name);
+  if (_name == nullptr) return nullptr;
 
-  int h = instNameSplit(_name, &_instbasename, &_subname);
-  SMILE_DBG(7,"cConfigManager::getValue: instNameSplit returned %i",h);
-  int idx = findInstance(_instbasename);
-  if (_instbasename != nullptr) free(_instbasename);
+  // split at the first '.' without copying the instance name
+  const char *x = strchr(_name,'.');
+  int h = (x != nullptr);
+  const char * _subname = h ? x+1 : nullptr;
+  int idx = h ? findInstance(_name, (size_t)(x - _name)) : findInstance(_name);
   if (idx >= 0) {
     if (h) { // search through the hierarchy
       return inst[idx]->getValue(-1,_subname);
@@ -2617,6 +2687,16 @@ const ConfigValue * cConfigManager::getValue(const char *_name) const
   return nullptr;
 }
 
+ConfigField cConfigManager::getField(const char *_name)
+{
+  if (_name == nullptr) return ConfigField();
+  const char *x = strchr(_name,'.');
+  if (x == nullptr) return ConfigField();  // field name not given
+  int idx = findInstance(_name, (size_t)(x - _name));
+  if (idx < 0) return ConfigField();
+  return inst[idx]->getField(x+1);
+}
+
 int cConfigManager::getArraySize(const char *_name) const
 {
   const ConfigValue *v = getValue(_name);
@@ -75,6 +75,7 @@ SMILECOMPONENT_REGCOMP(cDataMemory)
 
   ct->setField("isRb", "The default for the isRb option for all levels.", 1,0,0);
   ct->setField("nT", "The default level buffer size in frames for all levels.", 100,0,0);
+  ct->setField("lockFreeRb", "1 = access ring-buffer levels without mutexes. The single writer of a level reserves the frames it writes, waits only for readers still copying the old frames in these slots, and publishes the frames after their data and time meta information are written; readers pin the frames they copy. Useful for multi-threaded processing. 0 = reader/writer locking of the level data.", 0);
   if (ct->setField("level", "An associative array containing the level configuration (obsolete, you should use the cDataWriter configuration in the components that write to the dataMemory to properly configure the dataMemory!)",
                   dml, 1) == -1) {
      rA=1; // if subtype not yet found, request , re-register in the next iteration
@@ -87,6 +88,12 @@ SMILECOMPONENT_REGCOMP(cDataMemory)
 
 SMILECOMPONENT_CREATE(cDataMemory)
 
+void cDataMemory::fetchConfig()
+{
+  lockFreeRb = getInt("lockFreeRb");
+  if (lockFreeRb) { SMILE_IDBG(2,"lock free access to ring-buffer levels enabled"); }
+}
+
 
 
 void TimeMetaInfoMinimal::cloneFrom(const TimeMetaInfo *tm)
@@ -112,19 +119,14 @@ const char * FrameMetaInfo::getName(int n, int *_arrIdx)
   long  lN=0;
   lN = Ne; 
 
-  static long nn=0; ////
-  static long ff=0; ////
-
   if ((n>=0)&&(n<lN)) {
     long f=0,tmp=0;
 
-    if (n>nn) {f=ff; tmp=nn; } //// fast, but unsafe? TODO: check!
-    //TODO: this code is NOT thread safe. solutions:
-    // a) use a mutex... this actually should do the job...
-    // b) use a lookup table for n->f which must be built earlier or here if it doesn exist (but then we must use mutexes again to ensure exclusive building and waiting of other threads for the built index)
+    // continue the search from the last lookup (per level, protected by myMtx)
+    if (n>getNameCacheN) {f=getNameCacheF; tmp=getNameCacheN; }
     
     for(; f<N; f++) {
-      nn=tmp; ff=f; ////
+      getNameCacheN=tmp; getNameCacheF=f;
       tmp += field[f].N;
       if (tmp>n) break;
     }
@@ -342,7 +344,7 @@ cMatrix::~cMatrix()
 }
 
 cMatrix::cMatrix(int lN, int lnT, int ltype) :
-  cVector(0), nT(0)
+  cVector(0), nT(0), nTAlloc(0)
 {
   if ((lN>0)&&(lnT>0)) {
     switch (ltype) {
@@ -359,6 +361,7 @@ cMatrix::cMatrix(int lN, int lnT, int ltype) :
     }
     N = lN;
     nT = lnT;
+    nTAlloc = lnT;
     type = ltype;
     tmetaArr = 1;
     tmeta = new TimeMetaInfo[lnT]; //(TimeMetaInfo *)calloc(1,sizeof(TimeMetaInfo)*_nT);
@@ -472,6 +475,27 @@ void cDataMemoryLevel::frameRd(long rIdx, INT_DMEM *_data)
   }
 }
 
+void cDataMemoryLevel::framesRd(long rIdx, long n, cMatrix *mat, long col)
+{
+  if (n <= 0) return;
+  rIdx %= lcfg.nT;
+  if (rIdx < 0) rIdx += lcfg.nT;
+  // the range is one contiguous span, or two if it wraps around the end of the ring buffer
+  long n1 = MIN(n, lcfg.nT - rIdx);
+  long N = lcfg.N;
+  if (lcfg.type == DMEM_FLOAT) {
+    memcpy(mat->dataF + col*N, data->dataF + rIdx*N, sizeof(FLOAT_DMEM)*N*n1);
+    if (n > n1) memcpy(mat->dataF + (col+n1)*N, data->dataF, sizeof(FLOAT_DMEM)*N*(n-n1));
+  } else if (lcfg.type == DMEM_INT) {
+    memcpy(mat->dataI + col*N, data->dataI + rIdx*N, sizeof(INT_DMEM)*N*n1);
+    if (n > n1) memcpy(mat->dataI + (col+n1)*N, data->dataI, sizeof(INT_DMEM)*N*(n-n1));
+  }
+  TimeMetaInfo *tm = mat->tmeta + col;
+  long i;
+  for (i=0; i<n1; i++) tm[i].cloneFrom(tmeta + rIdx + i);
+  for ( ; i<n; i++) tm[i].cloneFrom(tmeta + (i-n1));
+}
+
 /*
 const sDmLevelConfig * cDataMemoryLevel::getConfig()
 {
@@ -579,6 +603,14 @@ void cDataMemoryLevel::allocReaders() {
   if (nReaders > 0) { // if registered readers are present...
     curRr = (long*)calloc(1,sizeof(long)*nReaders);
   }
+  if (lockFree) { // one more slot for unregistered readers
+    lfCurRr = new std::atomic<long>[nReaders+1];
+    lfPin = new std::atomic<long>[nReaders+1];
+    for (int i=0; i<=nReaders; i++) {
+      lfCurRr[i].store(0);
+      lfPin[i].store(LONG_MAX);
+    }
+  }
 }
 
 
@@ -780,6 +812,15 @@ int cDataMemoryLevel::finaliseLevel()   // finalize config and allocate data mem
 
 void cDataMemoryLevel::catchupCurR(int rdId, int _curR) 
 {
+  if (lockFree) { // only the reader itself sets its index
+    int slot = lfSlot(rdId);
+    if (slot == nReaders) smileMutexLock(RWptrMtx);
+    long w = lfCurW.load(std::memory_order_acquire);
+    if ((_curR >= 0)&&(_curR <= w)) lfCurRr[slot].store(_curR, std::memory_order_release);
+    else lfCurRr[slot].store(w-1, std::memory_order_release);
+    if (slot == nReaders) smileMutexUnlock(RWptrMtx);
+    return;
+  }
   smileMutexLock(RWptrMtx);
   if ((rdId < 0)||(rdId >= nReaders)) { 
     if ((_curR >= 0)&&(_curR <= curW)) curR = _curR;
@@ -793,6 +834,70 @@ void cDataMemoryLevel::catchupCurR(int rdId, int _curR)
   smileMutexUnlock(RWptrMtx);
 }
 
+long cDataMemoryLevel::lfReserveW(long *vIdx, long n, int special, long *wEnd)
+{
+  long w = lfCurW.load(std::memory_order_relaxed); // only the writer changes it
+  if (special == DMEM_IDX_CURW) *vIdx = w;
+  else if (special != -1) return -1;
+  if ((*vIdx < 0)||(*vIdx > w)) return -1;
+  int nh=0;
+  if (lcfg.noHang==1) { if (nReaders == 0) nh = 1; }
+  else if (lcfg.noHang==2) nh = 1;
+  if ((!nh)&&(n > lcfg.nT - (w - lfMinR()))) return -1;
+
+  *wEnd = MAX(w, *vIdx+n);
+  // announce the reservation before looking at the pins, readers pin before they look at the reservation
+  // (both sequentially consistent), so either the reader sees the reservation or the writer sees the pin
+  lfCurWres.store(*wEnd);
+  lfCurWlo.store(*vIdx);
+  long minPin = *wEnd - lcfg.nT;
+  int i;
+  for (i=0; i<=nReaders; i++) {
+    long p;
+    // wait for readers still copying old frames from the reserved slots, or any frames if published ones are rewritten
+    while ((p = lfPin[i].load()) != LONG_MAX) {
+      if ((p >= minPin)&&(*vIdx == w)) break;
+      smileYield();
+    }
+  }
+  if (minPin > lfMinR()) {
+    SMILE_DBG(3,"data lost while writing to ringbuffer level '%s'",getName());
+  }
+  return *vIdx%lcfg.nT;
+}
+
+long cDataMemoryLevel::lfBeginRead(int slot, long actualVidx, long *vIdx, long vIdxEnd, int special, int noUpd, int *padEnd, long *own, int range)
+{
+  if (slot == nReaders) smileMutexLock(RWptrMtx); // unregistered readers share one read index and pin
+  long vIdx0 = *vIdx;
+  long rIdx;
+  while (1) {
+    *vIdx = vIdx0;
+    *own = lfCurRr[slot].load(std::memory_order_relaxed);
+    long w = lfCurW.load(std::memory_order_acquire);
+    if (range) rIdx = validateIdxRangeR(actualVidx, vIdx, vIdxEnd, special, own, w, noUpd, padEnd);
+    else rIdx = validateIdxR(vIdx, special, own, w, noUpd);
+    if (rIdx < 0) break;
+    lfPin[slot].store(*vIdx);
+    if (*vIdx < lfCurWres.load() - lcfg.nT) { // the writer overwrites the first frame(s) now
+      lfPin[slot].store(LONG_MAX, std::memory_order_release);
+      rIdx = range ? -1 : -2;
+      break;
+    }
+    if (lfCurWlo.load() >= w) break;
+    // frames which are already published are rewritten, wait until the writer is done
+    lfPin[slot].store(LONG_MAX, std::memory_order_release);
+    smileYield();
+  }
+  return rIdx;
+}
+
+void cDataMemoryLevel::lfEndRead(int slot, long own)
+{
+  lfCurRr[slot].store(own, std::memory_order_release);
+  lfPin[slot].store(LONG_MAX, std::memory_order_release);
+  if (slot == nReaders) smileMutexUnlock(RWptrMtx);
+}
 
 int cDataMemoryLevel::setFrame(long vIdx, const cVector *vec, int special)  // id must already be resolved...!
 {
@@ -805,6 +910,10 @@ int cDataMemoryLevel::setFrame(long vIdx, const cVector *vec, int special)  // i
   if (lcfg.N != vec->N) { COMP_ERR("setFrame: cannot set frame in level '%s', framesize mismatch: %i != %i (expected)",getName(),vec->N,lcfg.N); }
   if (lcfg.type != vec->type) { COMP_ERR("setFrame: frame type mismtach between frame and level (frame=%i, level=%i)",vec->type,lcfg.type); }
 
+  long rIdx, wEnd=0;
+  if (lockFree) {
+    rIdx = lfReserveW(&vIdx,1,special,&wEnd);
+  } else {
 //****** acquire write lock.... *******
   smileMutexLock(RWstatMtx);
   // set write request flag, incase the level is currently locked for reading
@@ -820,12 +929,13 @@ int cDataMemoryLevel::setFrame(long vIdx, const cVector *vec, int special)  // i
 #ifdef DM_DEBUG_LOGGER
   long vIdx0=vIdx;
 #endif
-  long rIdx = validateIdxW(&vIdx,special);
+  rIdx = validateIdxW(&vIdx,special);
 #ifdef DM_DEBUG_LOGGER
   // logging in setFrame:
   datamemoryLogger(this->lcfg.name, vIdx0, vIdx, rIdx, lcfg.nT, special, this->curR, this->curW, this->EOI, this->nReaders, this->curRr, vec);
 #endif
   smileMutexUnlock(RWptrMtx);
+  }
   
   int ret = 0;
   if (rIdx>=0) {
@@ -838,7 +948,11 @@ int cDataMemoryLevel::setFrame(long vIdx, const cVector *vec, int special)  // i
     SMILE_ERR(4,"setFrame: frame index (vIdx %i -> rIdx %i) out of range, frame was not set (level '%s')!",vIdx,rIdx,getName());
   }
 
-  smileMutexUnlock(RWmtx);
+  if (lockFree) {
+    if (rIdx>=0) lfPublishW(wEnd);
+  } else {
+    smileMutexUnlock(RWmtx);
+  }
   return ret;
 }
 
@@ -853,6 +967,10 @@ int cDataMemoryLevel::setMatrix(long vIdx, const cMatrix *mat, int special)  //
   if (lcfg.N != mat->N) { COMP_ERR("setMatrix: cannot set frames in level '%s', framesize mismatch: %i != %i (expected)",getName(),mat->N,lcfg.N); }
   if (lcfg.type != mat->type) { COMP_ERR("setMatrix: frame type mismtach between frame and level (frame=%i, level=%i)",mat->type,lcfg.type); }
 
+  long rIdx, wEnd=0;
+  if (lockFree) {
+    rIdx = lfReserveW(&vIdx,mat->nT,special,&wEnd);
+  } else {
 //****** acquire write lock.... *******
   smileMutexLock(RWstatMtx);
   // set write request flag, incase the level is currently locked for reading
@@ -866,8 +984,9 @@ int cDataMemoryLevel::setMatrix(long vIdx, const cMatrix *mat, int special)  //
 
   // validate start index
   smileMutexLock(RWptrMtx);
-  long rIdx = validateIdxRangeW(&vIdx,vIdx+mat->nT,special);
+  rIdx = validateIdxRangeW(&vIdx,vIdx+mat->nT,special);
   smileMutexUnlock(RWptrMtx);
+  }
 
   int ret = 0;
   if (rIdx>=0) {
@@ -899,7 +1018,11 @@ int cDataMemoryLevel::setMatrix(long vIdx, const cMatrix *mat, int special)  //
     SMILE_DBG(4,"ERROR, setMatrix: frame index range (vIdxStart %i - vIdxEnd %i  => rIdxStart %i) out of range, frame was not set (level '%s')!",vIdx,vIdx+mat->nT,rIdx,getName());
   }
 
-  smileMutexUnlock(RWmtx);
+  if (lockFree) {
+    if (rIdx>=0) lfPublishW(wEnd);
+  } else {
+    smileMutexUnlock(RWmtx);
+  }
   return ret;
 }
 
@@ -916,6 +1039,12 @@ cVector * cDataMemoryLevel::getFrame(long vIdx, int special, int rdId, int *resu
 {
   if (!lcfg.finalised) { COMP_ERR("cannot get frame from non-finalised level '%s'! call finalise() first!",getName()); }
 
+  long rIdx, own=0;
+  int slot = 0;
+  if (lockFree) {
+    slot = lfSlot(rdId);
+    rIdx = lfBeginRead(slot,vIdx,&vIdx,vIdx+1,special,0,nullptr,&own,0);
+  } else {
 //****** acquire read lock.... *******
   smileMutexLock(RWstatMtx);
   // check for urgent write request:
@@ -938,8 +1067,9 @@ cVector * cDataMemoryLevel::getFrame(long vIdx, int special, int rdId, int *resu
 //****************
 
   smileMutexLock(RWptrMtx);
-  long rIdx = validateIdxR(&vIdx,special,rdId);
+  rIdx = validateIdxR(&vIdx,special,rdId);
   smileMutexUnlock(RWptrMtx);
+  }
 
   cVector *vec=nullptr;
   if (rIdx>=0) {
@@ -960,6 +1090,9 @@ cVector * cDataMemoryLevel::getFrame(long vIdx, int special, int rdId, int *resu
     }
   }
 
+  if (lockFree) {
+    lfEndRead(slot,own);
+  } else {
   //**** now unlock ******
   smileMutexLock(RWstatMtx);
   nCurRdr--;
@@ -970,6 +1103,7 @@ cVector * cDataMemoryLevel::getFrame(long vIdx, int special, int rdId, int *resu
   if (nCurRdr==0) smileMutexUnlock(RWmtx);
   smileMutexUnlock(RWstatMtx);
   //********************
+  }
 
   return vec;
 }
@@ -977,7 +1111,7 @@ cVector * cDataMemoryLevel::getFrame(long vIdx, int special, int rdId, int *resu
 //TODO: add an optimized 'simple' level for high performance and low overhead wave handling
 //  no tmeta, very simple access functions etc.
 //  tmeta if accessed will be emultated?
-cMatrix * cDataMemoryLevel::getMatrix(long vIdx, long vIdxEnd, int special, int rdId, int *result)
+cMatrix * cDataMemoryLevel::getMatrix(long vIdx, long vIdxEnd, int special, int rdId, int *result, cMatrix *reuse)
 {
   if (!lcfg.finalised) { COMP_ERR("cannot get matrix from non-finalised level! call finalise() first!"); }
 
@@ -986,6 +1120,12 @@ cMatrix * cDataMemoryLevel::getMatrix(long vIdx, long vIdxEnd, int special, int
   if (vIdx < 0) vIdx = 0;
   int padEnd = 0; // will be filled with the number of samples at the end of the matrix to be padded
 
+  long rIdx, own=0;
+  int slot = 0;
+  if (lockFree) {
+    slot = lfSlot(rdId);
+    rIdx = lfBeginRead(slot,vIdxold,&vIdx,vIdxEnd,special,0,&padEnd,&own,1);
+  } else {
 //****** acquire read lock.... *******
   smileMutexLock(RWstatMtx);
   // check for urgent write request:
@@ -1006,79 +1146,64 @@ cMatrix * cDataMemoryLevel::getMatrix(long vIdx, long vIdxEnd, int special, int
 //****************
 
   smileMutexLock(RWptrMtx);
-  long rIdx = validateIdxRangeR(vIdxold, &vIdx, vIdxEnd, special, rdId, 0, &padEnd);  // TODO : if EOI state, then allow vIdxEnd out of range! pad frame...
+  rIdx = validateIdxRangeR(vIdxold, &vIdx, vIdxEnd, special, rdId, 0, &padEnd);  // TODO : if EOI state, then allow vIdxEnd out of range! pad frame...
   smileMutexUnlock(RWptrMtx);
+  }
 
   cMatrix *mat=nullptr;
   if (rIdx>=0) {
-    if (vIdxold < 0) mat = new cMatrix(lcfg.N,vIdxEnd-vIdxold,lcfg.type);
-    else mat = new cMatrix(lcfg.N,vIdxEnd-vIdx,lcfg.type);
-    SMILE_DBG(4,"creating new data matrix (%s)  vIdxold=%i , vIdx=%i, vIdxEnd=%i, lcfg.N=%i",this->getName(),vIdxold,vIdx,vIdxEnd,lcfg.N)
+    long nT = (vIdxold < 0) ? vIdxEnd-vIdxold : vIdxEnd-vIdx;
+    if ((reuse != nullptr)&&(reuse->N == lcfg.N)&&(reuse->type == lcfg.type)&&(reuse->nTAlloc == nT)
+        &&(reuse->tmeta != nullptr)&&(reuse->tmetaArr)&&(!reuse->tmetaAlien)) {
+      mat = reuse;  // fill the caller's matrix in place, no allocation
+      mat->nT = nT;
+    } else {
+      if (reuse != nullptr) delete reuse;
+      mat = new cMatrix(lcfg.N,nT,lcfg.type);
+      SMILE_DBG(4,"creating new data matrix (%s)  vIdxold=%i , vIdx=%i, vIdxEnd=%i, lcfg.N=%i",this->getName(),vIdxold,vIdx,vIdxEnd,lcfg.N)
+    }
     if (mat == nullptr) OUT_OF_MEMORY;
     long i,j;
     if (vIdxold < 0) {
       long i0 = 0-vIdxold;
-      if (lcfg.type == DMEM_FLOAT) {
-        for (i=0; i<i0; i++) {
-          if (special == DMEM_PAD_ZERO) for (j=0; j<mat->N; j++) mat->dataF[i*lcfg.N+j] = 0.0; // pad with value
-          else frameRd((rIdx)%lcfg.nT, mat->dataF + (i*lcfg.N)); // fill with first frame
-          getTimeMeta((rIdx)%lcfg.nT,mat->tmeta + i);
-        }
-        for (i=0; i<vIdxEnd; i++) { frameRd((rIdx+i)%lcfg.nT, mat->dataF + (i+i0)*lcfg.N); getTimeMeta((rIdx+i)%lcfg.nT,mat->tmeta + i +i0); }
-      } else if (lcfg.type == DMEM_INT) {
-        for (i=0; i<i0; i++) {
-          if (special == DMEM_PAD_ZERO) for (j=0; j<mat->N; j++) mat->dataI[i*lcfg.N+j] = 0; // pad with value
-          else frameRd((rIdx)%lcfg.nT, mat->dataI + (i*lcfg.N)); // fill with first frame
+      for (i=0; i<i0; i++) {
+        if (special == DMEM_PAD_ZERO) {  // pad with value
+          if (lcfg.type == DMEM_FLOAT) for (j=0; j<mat->N; j++) mat->dataF[i*lcfg.N+j] = 0.0;
+          else if (lcfg.type == DMEM_INT) for (j=0; j<mat->N; j++) mat->dataI[i*lcfg.N+j] = 0;
           getTimeMeta((rIdx)%lcfg.nT,mat->tmeta + i);
+        } else {
+          framesRd(rIdx, 1, mat, i);  // fill with first frame
         }
-        for (i=0; i<vIdxEnd; i++) { frameRd((rIdx+i)%lcfg.nT, mat->dataI + (i+i0)*lcfg.N); getTimeMeta((rIdx+i)%lcfg.nT,mat->tmeta + i +i0); }
       }
+      framesRd(rIdx, vIdxEnd, mat, i0);
     } else if (padEnd>0) {
-      if (lcfg.type == DMEM_FLOAT) {
-        for (i=0; i<(vIdxEnd-vIdx)-padEnd; i++) { frameRd((rIdx+i)%lcfg.nT, mat->dataF + (i*lcfg.N)); getTimeMeta((rIdx+i)%lcfg.nT,mat->tmeta + i); }
-        long i0 = i-1;
-        for (; i<(vIdxEnd-vIdx); i++) {
-          if (special == DMEM_PAD_ZERO) for (j=0; j<mat->N; j++) mat->dataF[i*lcfg.N+j] = 0.0; // pad with value
-          else frameRd((rIdx+i0)%lcfg.nT, mat->dataF + (i*lcfg.N)); // fill with last frame
-          getTimeMeta((rIdx+i0)%lcfg.nT,mat->tmeta + i);
-        }
-        // TODO: Test DMEM_PAD_NONE option to truncate the frame!!
-        if (special == DMEM_PAD_NONE) {
-          mat->nT = (vIdxEnd-vIdx)-padEnd;
-        }
-      } else if (lcfg.type == DMEM_INT) {
-        for (i=0; i<(vIdxEnd-vIdx)-padEnd; i++) { frameRd((rIdx+i)%lcfg.nT, mat->dataI + (i*lcfg.N)); getTimeMeta((rIdx+i)%lcfg.nT,mat->tmeta + i); }
-        long i0 = i-1;
-        for (; i<(vIdxEnd-vIdx); i++) {
-          if (special == DMEM_PAD_ZERO) for (j=0; j<mat->N; j++) mat->dataI[i*lcfg.N+j] = 0; // pad with value
-          else frameRd((rIdx+i0)%lcfg.nT, mat->dataI + (i*lcfg.N)); // fill with last frame
+      long nRd = (vIdxEnd-vIdx)-padEnd;
+      framesRd(rIdx, nRd, mat, 0);
+      long i0 = nRd-1;
+      for (i=nRd; i<(vIdxEnd-vIdx); i++) {
+        if (special == DMEM_PAD_ZERO) {  // pad with value
+          if (lcfg.type == DMEM_FLOAT) for (j=0; j<mat->N; j++) mat->dataF[i*lcfg.N+j] = 0.0;
+          else if (lcfg.type == DMEM_INT) for (j=0; j<mat->N; j++) mat->dataI[i*lcfg.N+j] = 0;
           getTimeMeta((rIdx+i0)%lcfg.nT,mat->tmeta + i);
-        }
-        // TODO: Test DMEM_PAD_NONE option to truncate the frame!!
-        if (special == DMEM_PAD_NONE) {
-          mat->nT = (vIdxEnd-vIdx)-padEnd;
-        }
-      }
-
-    } else {
-      if (lcfg.type == DMEM_FLOAT) {
-        for (i=0; i<mat->nT; i++) {
-          frameRd((rIdx+i)%lcfg.nT, mat->dataF + i*lcfg.N);
-          getTimeMeta((rIdx+i)%lcfg.nT,mat->tmeta + i);
+        } else {
+          framesRd(rIdx+i0, 1, mat, i);  // fill with last frame
         }
       }
-      else if (lcfg.type == DMEM_INT) {
-        for (i=0; i<mat->nT; i++) {
-          frameRd((rIdx+i)%lcfg.nT, mat->dataI + i*lcfg.N);
-          getTimeMeta((rIdx+i)%lcfg.nT,mat->tmeta + i);
-        }
+      // TODO: Test DMEM_PAD_NONE option to truncate the frame!!
+      if (special == DMEM_PAD_NONE) {
+        mat->nT = nRd;
       }
+    } else {
+      framesRd(rIdx, mat->nT, mat, 0);
     }
     mat->fmeta = &(fmeta);
   } else {
     SMILE_DBG(4,"ERROR, getMatrix: frame index range (vIdxStart %i - vIdxEnd %i  => rIdxStart %i) out of range, matrix cannot be read (level '%s')!",vIdx,vIdxEnd,rIdx,getName());
   }
   
+  if (lockFree) {
+    lfEndRead(slot,own);
+  } else {
   //**** now unlock ******
   smileMutexLock(RWstatMtx);
   nCurRdr--;
@@ -1089,6 +1214,7 @@ cMatrix * cDataMemoryLevel::getMatrix(long vIdx, long vIdxEnd, int special, int
   if (nCurRdr==0) smileMutexUnlock(RWmtx);
   smileMutexUnlock(RWstatMtx);
   //********************
+  }
   
   return mat;
 }
@@ -1096,6 +1222,7 @@ cMatrix * cDataMemoryLevel::getMatrix(long vIdx, long vIdxEnd, int special, int
 // methods to get info about current level fill status (e.g. number of frames written, curW, curR(global) and freeSpace, etc.)
 long cDataMemoryLevel::getMaxR() 
 { 
+  if (lockFree) return lfCurW.load(std::memory_order_acquire)-1;
   smileMutexLock(RWptrMtx);
   long res = curW-1;
   smileMutexUnlock(RWptrMtx);
@@ -1104,7 +1231,10 @@ long cDataMemoryLevel::getMaxR()
 
 long cDataMemoryLevel::getMinR() {  // minimum readable index (relevant only for ringbuffers, otherwise it will always return 0)
   long res=0;
-  if (lcfg.isRb) {
+  if (lockFree) {
+    long w = lfCurW.load(std::memory_order_acquire);
+    if (w > lcfg.nT) res = w-lcfg.nT;
+  } else if (lcfg.isRb) {
     smileMutexLock(RWptrMtx);
     if (curW > lcfg.nT)
       res = curW-lcfg.nT;
@@ -1371,6 +1501,7 @@ int cDataMemory::myFinaliseInstance()
     // allocate reader config array
     SMILE_DBG(4,"allocating reader positions in %i level(s)",nLevels+1);
     for (i=0; i<=nLevels; i++) {
+      level[i]->setLockFree(lockFreeRb);
       level[i]->allocReaders();
     }
   } else {
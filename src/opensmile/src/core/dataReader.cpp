@@ -87,6 +87,7 @@ cDataReader::cDataReader(const char *_name) : cSmileComponent(_name),
   curR(0),  
   V(nullptr),
   m(nullptr),  
+  mLevel(nullptr),
   stepM(1),
   lengthM(1),
   ignMisBegM(0),
@@ -123,6 +124,7 @@ void cDataReader::fetchConfig() {
     dmLevel = (const char **)calloc(1,sizeof(const char*)*nLevels);
     level = (int *)calloc(1,sizeof(int)*nLevels);
     rdId = (int *)calloc(1,sizeof(int)*nLevels);
+    mLevel = (cMatrix **)calloc(1,sizeof(cMatrix *)*nLevels);
 
     if (dmLevel==nullptr) OUT_OF_MEMORY;
     for (i=0; i<nLevels; i++) {
@@ -504,9 +506,11 @@ cMatrix * cDataReader::getMatrix(long vIdx, long length, int special, int privat
     }
     if (r) {
       if (my_m!=nullptr) {
-        if (length != my_m->nT) {
+        if (length != my_m->nTAlloc) {
           delete my_m;
           my_m=nullptr;
+        } else {
+          my_m->nT = length;  // might have been truncated by the previous read
         }
       }
       if (my_m == nullptr) my_m = new cMatrix(myLcfg->N,length,myLcfg->type);
@@ -528,8 +532,9 @@ cMatrix * cDataReader::getMatrix(long vIdx, long length, int special, int privat
       long minlen = length;
       for (i=0; i<nLevels; i++) {
 
-        cMatrix *m2 = dm->getMatrix(level[i],vIdx,vIdx+length, special, rdId[i]);
+        cMatrix *m2 = dm->getMatrix(level[i],vIdx,vIdx+length, special, rdId[i], nullptr, mLevel[i]);
         if (m2 != nullptr) {
+          mLevel[i] = m2;
           if (m2->nT < minlen) { minlen = m2->nT; }
           // copy data from f2 into V at the correct position
           if (m2->type == DMEM_FLOAT) {
@@ -555,12 +560,10 @@ cMatrix * cDataReader::getMatrix(long vIdx, long length, int special, int privat
               //f += f2->fmeta->N;
             }
             my_m->fmeta = myfmeta;
-
-          delete m2;
         }
       }
       if (minlen < length) {
-        // TODO: if the matrix size increases again, we cannot increase! Introduce cMatrix->nAlloc variable?
+        // the allocation is kept (nTAlloc), the next read sets nT back to the full length
         my_m->nT = minlen;
       }
 
@@ -571,9 +574,9 @@ cMatrix * cDataReader::getMatrix(long vIdx, long length, int special, int privat
     }
 
   } else {
-    cMatrix *m2 = dm->getMatrix(level[0],vIdx,vIdx+length, special, rdId[0]);
+    // the internal matrix is refilled in place if it has the right size (getMatrix frees it otherwise)
+    cMatrix *m2 = dm->getMatrix(level[0],vIdx,vIdx+length, special, rdId[0], nullptr, privateVec ? nullptr : m);
     if ((m2 != nullptr)&&(!privateVec)) {
-      if (m != nullptr) delete m;
       m = m2;
       // ???:
       //if (vIdx+length > curR) curR = vIdx+length;
@@ -726,6 +729,12 @@ int cDataReader::setupSequentialMatrixReading(double step, double length, double
 cDataReader::~cDataReader() {
   if (V!=nullptr) delete V;
   if (m!=nullptr) delete m;
+  if (mLevel!=nullptr) {
+    for (int i=0; i<nLevels; i++) {
+      if (mLevel[i]!=nullptr) delete mLevel[i];
+    }
+    free(mLevel);
+  }
   if (dmLevel!=nullptr) free(dmLevel);
   if (rdId != nullptr) free(rdId);
   if (level!=nullptr)  free(level);
@@ -184,6 +184,7 @@ cSmileComponent::cSmileComponent(const char *instname) :
   doProfile_(DO_PROFILING),
   printProfile_(PRINT_PROFILING),
   profileCur_(0.0), profileSum_(0.0),  
+  fieldCacheChanges_(-1),
   confman_(nullptr),  
   cname_(nullptr),
   isRegistered_(0),
@@ -200,6 +201,25 @@ cSmileComponent::cSmileComponent(const char *instname) :
   cfname_ = iname_;
 }
 
+const ConfigValue * cSmileComponent::getCachedValue(const char *name)
+{
+  if ((confman_ == nullptr)||(name == nullptr)) return nullptr;
+  long nChanges = confman_->getNInstChanges();
+  if (fieldCacheChanges_ != nChanges) {  // handles may point to deleted instances
+    fieldCache_.clear();
+    fieldCacheChanges_ = nChanges;
+  }
+  auto it = fieldCache_.find(name);
+  if (it == fieldCache_.end()) {
+    it = fieldCache_.emplace(name, std::make_pair(std::string(name), getField(name))).first;
+  } else if (it->second.first != name) {
+    it->second = std::make_pair(std::string(name), getField(name));
+  }
+  const ConfigValue *v = it->second.second.getValue();
+  if ((v == nullptr)||(v->getType() >= CFTP_ARR)) return nullptr;
+  return v;
+}
+
 void cSmileComponent::setComponentEnvironment(cComponentManager *compman, int id, cSmileComponent *parent)
 {
   if (compman != nullptr) {
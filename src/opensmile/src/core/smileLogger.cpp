@@ -54,6 +54,7 @@
 
 
 #include <time.h>
+#include <chrono>
 
 //#include <exceptions.hpp>
 #include <core/smileLogger.hpp>
@@ -72,10 +73,12 @@
 /********************* class implementation ***********************************/
 
 cSmileLogger::cSmileLogger(int _loglevel, const char * _logfile, int _append) :
+  mainThread(std::this_thread::get_id()),
+  stopDrain(0),
   logf(nullptr),
   silence(0),
   _enableLogPrint(1),
-  msg(nullptr)  
+  deferConsole(0)
 {
   if (_logfile != nullptr) {
     logfile = strdup(_logfile);
@@ -89,14 +92,15 @@ cSmileLogger::cSmileLogger(int _loglevel, const char * _logfile, int _append) :
   } else {
     ll_msg = ll_wrn = ll_err = ll_dbg = 0;
   }
-  smileMutexCreate(logmsgMtx);
 }
 
 cSmileLogger::cSmileLogger(int loglevel_msg, int loglevel_wrn, int loglevel_err, int loglevel_dbg, const char *_logfile, int _append):
+  mainThread(std::this_thread::get_id()),
+  stopDrain(0),
   logf(nullptr),
   silence(0),
   _enableLogPrint(1),  
-  msg(nullptr)
+  deferConsole(0)
 {
   if (_logfile != nullptr) {
     logfile = strdup(_logfile);
@@ -109,17 +113,24 @@ cSmileLogger::cSmileLogger(int loglevel_msg, int loglevel_wrn, int loglevel_err,
   ll_wrn = loglevel_wrn;
   ll_err = loglevel_err;
   ll_dbg = loglevel_dbg;
-  smileMutexCreate(logmsgMtx);
 }
 
 cSmileLogger::~cSmileLogger()
 {
-  smileMutexLock(logmsgMtx);
-  if (msg != nullptr) free(msg);
+  {
+    std::lock_guard<std::mutex> lock(logmsgMtx);
+    stopDrain = 1;
+  }
+  drainCv.notify_all();
+  if (drainThread.joinable()) drainThread.join();
+
+  std::lock_guard<std::mutex> lock(logmsgMtx);
+  drainRings();
   closeLogfile();
   if (logfile != nullptr) free(logfile);
-  smileMutexUnlock(logmsgMtx);
-  smileMutexDestroy(logmsgMtx);
+  std::lock_guard<std::mutex> rlock(ringsMtx);
+  for (size_t i = 0; i < rings.size(); i++) delete rings[i];
+  rings.clear();
 }
 
 /* opens the logfile */
@@ -164,134 +175,338 @@ void cSmileLogger::setLogLevel(int level)
 
 void cSmileLogger::setLogFile(char *file, int _append, int _stde)
 {
+  setLogFile((const char *)file, _append, _stde);
+}
+
+void cSmileLogger::setLogFile(const char *file, int _append, int _stde)
+{
+  std::lock_guard<std::mutex> lock(logmsgMtx);
+  // pending messages still go to the previous file
+  drainRings();
+  if (logfile) {
+    free(logfile); logfile = nullptr;
+  }
+  stde = _stde;
   if (file != nullptr) {
-    if (logfile) {
-      free(logfile); logfile = nullptr;
-    }
     logfile = strdup(file);
-    stde = _stde;
     openLogfile(_append);
+  } else {
+    closeLogfile();
   }
 }
 
-void cSmileLogger::setLogFile(const char *file, int _append, int _stde)
+void cSmileLogger::setDeferConsoleOutput(int defer)
 {
-  if (file != nullptr) {
-    if (logfile) {
-      free(logfile); logfile = nullptr;
+  std::lock_guard<std::mutex> lock(logmsgMtx);
+  deferConsole = defer;
+  if (!deferConsole) {
+    drainRings();
+    flushConsole();
+  }
+}
+
+void cSmileLogger::flush()
+{
+  std::lock_guard<std::mutex> lock(logmsgMtx);
+  drainRings();
+  flushConsole();
+}
+
+/* the ring of the calling thread is registered on its first message; when the thread exits,
+   the ring is left to the drain, which frees it once all its messages are written */
+namespace {
+  struct sThreadRing {
+    cSmileLogger *owner = nullptr;
+    sSmileLogRing *ring = nullptr;
+    ~sThreadRing() { if (ring != nullptr) ring->orphaned.store(1, std::memory_order_release); }
+  };
+}
+
+sSmileLogRing * cSmileLogger::threadRing()
+{
+  static thread_local sThreadRing tr;
+  if (tr.owner == this) return tr.ring;
+  // a thread only has a ring for one logger, other loggers format at once
+  if (tr.owner != nullptr) return nullptr;
+  sSmileLogRing *ring = new sSmileLogRing();
+  {
+    std::lock_guard<std::mutex> lock(ringsMtx);
+    rings.push_back(ring);
+    if (!drainThread.joinable()) {
+      drainThread = std::thread(&cSmileLogger::drainLoop, this);
     }
-    logfile = strdup(file);
-    stde = _stde;
-    openLogfile(_append);
   }
+  tr.owner = this;
+  tr.ring = ring;
+  return ring;
 }
 
-// formating of log message, save result in msg
-void cSmileLogger::fmtLogMsg(const char *type, char *t, int level, const char *m)
+void cSmileLogger::drainLoop()
 {
-  if (t == nullptr) return;
-  if (msg != nullptr) {
-    free(msg); msg = nullptr;
+  std::unique_lock<std::mutex> lock(logmsgMtx);
+  while (!stopDrain) {
+    drainCv.wait_for(lock, std::chrono::milliseconds(LOG_DRAIN_PERIOD_MS));
+    drainRings();
   }
-  if ((type != nullptr)&&(m!=nullptr)) {
-    msg = myvprint("(%s) [%i] in %s : %s",type,level,m,t);
-  } else if (type != nullptr) {
-    msg = myvprint("(%s) [%i] : %s",type,level,t);
-  } else if (m != nullptr) {
-    msg = myvprint("(MSG) [%i] in %s : %s",level,m,t);
-  } else {
-    msg = myvprint("(MSG) [%i] : %s",level,t);
+}
+
+/* minimal printf: each conversion of the format string is passed to snprintf on its own,
+   with the argument read from the record; arguments that were passed with a different
+   type than the conversion expects are converted */
+
+template <typename T>
+static void appendFormatted(std::string &out, const char *spec, T v)
+{
+  char buf[256];
+  int n = snprintf(buf, sizeof(buf), spec, v);
+  if (n < 0) return;
+  if (n < (int)sizeof(buf)) { out.append(buf, n); return; }
+  size_t o = out.size();
+  out.resize(o + n + 1);
+  snprintf(&out[o], n + 1, spec, v);
+  out.resize(o + n);
+}
+
+struct sLogArg {
+  int tag;
+  long long i;
+  double d;
+  const char *s;
+  const void *p;
+};
+
+static int readLogArg(const char *&a, const char *end, sLogArg &arg)
+{
+  if (a >= end) return 0;
+  arg.tag = *a++;
+  arg.i = 0; arg.d = 0.0; arg.s = nullptr; arg.p = nullptr;
+  switch (arg.tag) {
+    case 1: // LOGARG_INT
+      memcpy(&arg.i, a, sizeof(arg.i)); a += sizeof(arg.i);
+      arg.d = (double)arg.i;
+      break;
+    case 2: // LOGARG_DBL
+      memcpy(&arg.d, a, sizeof(arg.d)); a += sizeof(arg.d);
+      arg.i = (long long)arg.d;
+      break;
+    case 3: // LOGARG_STR
+      arg.s = a; a += strlen(a) + 1;
+      break;
+    case 4: // LOGARG_PTR
+      memcpy(&arg.p, a, sizeof(arg.p)); a += sizeof(arg.p);
+      arg.i = (long long)(intptr_t)arg.p;
+      break;
+    default:
+      return 0;
   }
+  return 1;
 }
 
-// main log message dispatcher
-void cSmileLogger::logMsg(int itype, char *s, int level, const char *m)
+static void formatLogArgs(const char *fmt, const char *a, const char *end, std::string &out)
 {
-  if (!silence) {
-    // check loglevel and type
-    const char *type=nullptr;
-    switch (itype) {
-       case LOG_PRINT :
-            if (level > ll_msg) { free(s); return; }
-            type=nullptr;
-            break;
-       case LOG_MESSAGE :
-            if (level > ll_msg) { free(s); return; }
-            type=nullptr;
-            break;
-       case LOG_ERROR :
-            if (level > ll_err) { free(s); return; }
-            type="ERROR";
-            break;
-       case LOG_WARNING :
-            if (level > ll_wrn) { free(s); return; }
-            type="WARN";
-            break;
-       case LOG_DEBUG :
-            if (level > ll_dbg) { free(s); return; }
-            type="DBG";
-            break;
-       default: return;
+  const char *p = fmt;
+  char spec[48];
+  while (*p) {
+    if (*p != '%') {
+      const char *q = strchr(p, '%');
+      if (q == nullptr) q = p + strlen(p);
+      out.append(p, q - p);
+      p = q;
+      continue;
     }
-
-    smileMutexLock(logmsgMtx);
-    // format log message
-    if (itype == LOG_PRINT) {
-      if (msg != nullptr) {
-        free(msg); msg = nullptr;
-      }
-      msg = myvprint("%s",s);
-      if (_enableLogPrint) {
-        // write to file
-        writeMsgToFile(1);
+    if (p[1] == '%') { out.push_back('%'); p += 2; continue; }
+    // flags, width and precision are kept, length modifiers are set from the argument size
+    const char *q = p + 1;
+    size_t n = 0;
+    int nl = 0;
+    char conv = 0;
+    spec[n++] = '%';
+    while (*q && n < sizeof(spec) - 8) {
+      char c = *q++;
+      if (c == '*') {
+        sLogArg w;
+        if (readLogArg(a, end, w)) n += snprintf(spec + n, sizeof(spec) - n, "%i", (int)w.i);
+      } else if (strchr("lqjzt", c)) {
+        nl++;
+        if (c != 'l') nl = 2;
+      } else if (c == 'h' || c == 'L') {
+        // short types are promoted, long double is passed as double
+      } else if (strchr("diouxXeEfFgGaAcspn", c)) {
+        conv = c; break;
+      } else {
+        spec[n++] = c;
       }
+    }
+    if (conv == 0) { out.append(p, q - p); p = q; continue; }
+    p = q;
+    sLogArg arg;
+    if (!readLogArg(a, end, arg)) { out.append("(?)"); continue; }
+    switch (conv) {
+      case 'd': case 'i':
+        if (nl >= 2) { spec[n++] = 'l'; spec[n++] = 'l'; }
+        else if (nl == 1) { spec[n++] = 'l'; }
+        spec[n++] = conv; spec[n] = 0;
+        if (nl >= 2) appendFormatted(out, spec, arg.i);
+        else if (nl == 1) appendFormatted(out, spec, (long)arg.i);
+        else appendFormatted(out, spec, (int)arg.i);
+        break;
+      case 'o': case 'u': case 'x': case 'X':
+        if (nl >= 2) { spec[n++] = 'l'; spec[n++] = 'l'; }
+        else if (nl == 1) { spec[n++] = 'l'; }
+        spec[n++] = conv; spec[n] = 0;
+        if (nl >= 2) appendFormatted(out, spec, (unsigned long long)arg.i);
+        else if (nl == 1) appendFormatted(out, spec, (unsigned long)arg.i);
+        else appendFormatted(out, spec, (unsigned int)arg.i);
+        break;
+      case 'c':
+        spec[n++] = conv; spec[n] = 0;
+        appendFormatted(out, spec, (int)arg.i);
+        break;
+      case 's':
+        spec[n++] = conv; spec[n] = 0;
+        appendFormatted(out, spec, arg.s != nullptr ? arg.s : "(?)");
+        break;
+      case 'p':
+        spec[n++] = conv; spec[n] = 0;
+        appendFormatted(out, spec, arg.p);
+        break;
+      case 'n':
+        break;
+      default:  // floating point
+        spec[n++] = conv; spec[n] = 0;
+        appendFormatted(out, spec, arg.d);
+        break;
+    }
+  }
+}
 
+// format all messages pending in the rings (logmsgMtx must be held)
+void cSmileLogger::drainRings()
+{
+  std::lock_guard<std::mutex> lock(ringsMtx);
+  std::string t;
+  int written = 0;
+  for (size_t i = 0; i < rings.size(); ) {
+    sSmileLogRing *ring = rings[i];
+    int orphaned = ring->orphaned.load(std::memory_order_acquire);
+    unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+    unsigned int head = ring->head.load(std::memory_order_acquire);
+    for ( ; tail != head; tail++) {
+      const sSmileLogRecord &r = ring->rec[tail & (LOG_RING_SIZE-1)];
+      const char *module = r.data;
+      const char *fmt = module + strlen(module) + 1;
+      const char *args = fmt + strlen(fmt) + 1;
+      t.clear();
+      formatLogArgs(fmt, args, r.data + r.len, t);
+      outputMsg(r.type, t.c_str(), r.level, r.type == LOG_PRINT ? nullptr : module, r.instance, r.time);
+      written++;
+    }
+    ring->tail.store(tail, std::memory_order_release);
+    if (orphaned) {
+      delete ring;
+      rings.erase(rings.begin() + i);
     } else {
-      fmtLogMsg(type,s,level,m);
-      // write to file
-      writeMsgToFile();
+      i++;
     }
-    free(s);
-    
+  }
+  if (written && logf != nullptr) fflush(logf);
+}
 
-    // print to console
-    if ((stde)||(logf == nullptr)||(itype==LOG_PRINT))
-      printMsgToConsole();
+// formating of log message, save result in msg
+void cSmileLogger::fmtLogMsg(const char *type, const char *t, int level, const char *m, int instance)
+{
+  char head[64];
+  msg.clear();
+  if (type != nullptr) snprintf(head, sizeof(head), "(%s) [%i]", type, level);
+  else snprintf(head, sizeof(head), "(MSG) [%i]", level);
+  msg.append(head);
+  if (m != nullptr) {
+    msg.append(instance ? " in instance '" : " in ");
+    msg.append(m);
+    if (instance) msg.push_back('\'');
+  }
+  msg.append(" : ");
+  msg.append(t);
+}
 
-    smileMutexUnlock(logmsgMtx);
+// format and output one message (logmsgMtx must be held)
+void cSmileLogger::outputMsg(int itype, const char *s, int level, const char *m, int instance, time_t t)
+{
+  const char *type=nullptr;
+  switch (itype) {
+     case LOG_PRINT :   type=nullptr; break;
+     case LOG_MESSAGE : type=nullptr; break;
+     case LOG_ERROR :   type="ERROR"; break;
+     case LOG_WARNING : type="WARN"; break;
+     case LOG_DEBUG :   type="DBG"; break;
+     default: return;
   }
+
+  if (itype == LOG_PRINT) {
+    msg.assign(s);
+    if (_enableLogPrint) {
+      // write to file
+      writeMsgToFile(t, 1);
+    }
+  } else {
+    fmtLogMsg(type,s,level,m,instance);
+    // write to file
+    writeMsgToFile(t);
+  }
+
+  // print to console
+  if ((stde)||(logf == nullptr)||(itype==LOG_PRINT))
+    printMsgToConsole();
+}
+
+// main log message dispatcher
+void cSmileLogger::logMsg(int itype, char *s, int level, const char *m)
+{
+  if (s == nullptr) return;
+  if (silence || level > typeLevel(itype)) { free(s); return; }
+
+  std::lock_guard<std::mutex> lock(logmsgMtx);
+  // keep the order with messages of this thread that are still in its ring
+  drainRings();
+  time_t t;
+  time(&t);
+  outputMsg(itype, s, level, m, 0, t);
+  free(s);
+  if (logf != nullptr) fflush(logf);
+  flushConsole();
 }
 
-// print message to console , without a timestamp
+// queue message for the console, without a timestamp
 void cSmileLogger::printMsgToConsole()
 {
-  if (msg != nullptr) {
-    #ifdef __ANDROID__
-      #ifndef __STATIC_LINK
-         __android_log_print(ANDROID_LOG_INFO, "opensmile", "%s",msg);
-      #else
-        Rprintf("%s\n",msg);
-        
-      #endif
+  deferredConsole.append(msg);
+  deferredConsole.push_back('\n');
+}
+
+// print queued console output, if called from the main thread and output is not deferred
+void cSmileLogger::flushConsole()
+{
+  if (deferConsole || deferredConsole.empty() || std::this_thread::get_id() != mainThread)
+    return;
+  #ifdef __ANDROID__
+    #ifndef __STATIC_LINK
+       __android_log_print(ANDROID_LOG_INFO, "opensmile", "%s",deferredConsole.c_str());
     #else
-    Rprintf("%s\n",msg);
-    
+      Rprintf("%s",deferredConsole.c_str());
     #endif
-    //#ifdef __MINGW32
-    //
-    //#endif
-  }
+  #else
+  Rprintf("%s",deferredConsole.c_str());
+  #endif
+  deferredConsole.clear();
 }
 
-// write a log message in *msg to current logfile (if open)
+// write a log message in msg to current logfile (if open)
 // add a date- and timestamp to message
-void cSmileLogger::writeMsgToFile(int pr)
+void cSmileLogger::writeMsgToFile(time_t t, int pr)
 {
-  if ((logf != nullptr)&&(msg != nullptr)) {
+  if (logf != nullptr) {
     if (pr==0) {
       // date string
-      time_t t;
-      time(&t);
       struct tm *ti;
       ti = localtime(&t);
       fprintf(logf,"[ %.2i.%.2i.%.4i - %.2i:%.2i:%.2i ]\n    ",
@@ -300,8 +515,7 @@ void cSmileLogger::writeMsgToFile(int pr)
       );
     }
     // log message
-    fprintf(logf,"%s\n",msg);
-    fflush(logf);
+    fprintf(logf,"%s\n",msg.c_str());
   }
 }
 
@@ -90,6 +90,10 @@ cVectorProcessor::cVectorProcessor(const char *_name) :
   fNi(nullptr),
   fNo(nullptr),
   vecO(nullptr),
+  blockFrames(0),
+  blockIn(nullptr),
+  blockOut(nullptr),
+  blockRes(nullptr),
   includeSingleElementFields(0),
   processArrayFields(1),
   preserveFieldNames(1),  
@@ -309,6 +313,93 @@ int cVectorProcessor::flushVectorInt(INT_DMEM *dst, long Nsrc, long Ndst, int id
   return 0;
 }
 
+// result of a frame after one more field returned r, as in myTick:
+// 1 = write the frame, -1 = do not write it, 0 = failed (not written, myTick would return 0)
+static inline int vpFrameRes(int s, int r)
+{
+  if (r == 0) return 0;
+  if ((r < 0) && (s == 1)) return -1;
+  return s;
+}
+
+// reads up to blockFrames frames and processes them with processVectorFloatBlock,
+// returns -1 if the block path is not applicable and the frame by frame path in myTick should run.
+// Frames are written (or not) as myTick would write them one by one, 1 is returned if
+// myTick would have returned 1 for at least one of the frames
+int cVectorProcessor::processBlock()
+{
+  const sDmLevelConfig *c = writer_->getLevelConfig();
+  if ((c == nullptr) || (c->type != DMEM_FLOAT)) return -1;
+  long nMax = blockFrames;
+  while ((nMax > 1) && !(writer_->checkWrite(nMax))) nMax /= 2;
+  if (nMax < 2) return -1;
+
+  if ((blockIn == nullptr) || (blockIn->nTAlloc < blockFrames)) {
+    if (blockIn != nullptr) delete blockIn;
+    if (blockOut != nullptr) delete blockOut;
+    if (blockRes != nullptr) free(blockRes);
+    blockIn = new cMatrix(Ni, blockFrames, DMEM_FLOAT);
+    blockOut = new cMatrix(No, blockFrames, DMEM_FLOAT);
+    blockRes = (int *)calloc(1, sizeof(int) * blockFrames);
+  }
+  long n = 0;
+  while (n < nMax) {
+    cVector *vec = reader_->getNextFrame();
+    if (vec == nullptr) break;
+    memcpy(blockIn->dataF + n*Ni, vec->dataF, sizeof(FLOAT_DMEM) * MIN(Ni, vec->N));
+    blockOut->tmeta[n].cloneFrom(vec->tmeta);
+    blockRes[n] = 1;
+    n++;
+  }
+  if (n == 0) return -1;
+
+  int i;
+  int iO = 0;
+  int res;
+  long f;
+  long oi = 0, oo = 0;
+  for (i=0; i<Nfi; i++) {
+    if ((fNi[i] == 1 && includeSingleElementFields == 0 && processArrayFields == 1) || (fNi[i] < 1)) {
+      continue;
+    }
+    if (fNo[iO] <= 0) {
+      SMILE_IERR(1,"output field size for field %i is 0 in call to processVectorFloat!\n  Please check if setupNewNames or setupNamesForField returns a number > 0 !!",iO);
+      COMP_ERR("aborting here, since this is a serious bug in this component ...");
+    }
+    res = processVectorFloatBlock(blockIn->dataF + oi, Ni, blockOut->dataF + oo, No, n, fNi[i], fNo[iO], i);
+    if (res != VECTORPROCESSOR_BLOCK_NOT_HANDLED) {
+      // the result holds for all frames of the block
+      for (f = 0; f < n; f++) blockRes[f] = vpFrameRes(blockRes[f], res);
+    } else {
+      for (f = 0; f < n; f++) {
+        res = processVectorFloat(blockIn->dataF + f*Ni + oi, blockOut->dataF + f*No + oo, fNi[i], fNo[iO], i);
+        blockRes[f] = vpFrameRes(blockRes[f], res);
+      }
+    }
+    oi += fNi[i];
+    oo += fNo[iO];
+    iO++;
+  }
+
+  // move the frames to be written to the front of the block, in order
+  int ret = 0;
+  long nOut = 0;
+  for (f = 0; f < n; f++) {
+    if (blockRes[f] != 0) ret = 1;
+    if (blockRes[f] != 1) continue;
+    if (nOut < f) {
+      memcpy(blockOut->dataF + nOut*No, blockOut->dataF + f*No, sizeof(FLOAT_DMEM) * No);
+      blockOut->tmeta[nOut].cloneFrom(blockOut->tmeta + f);
+    }
+    nOut++;
+  }
+  if (nOut > 0) {
+    blockOut->nT = nOut;
+    writer_->setNextMatrix(blockOut);
+  }
+  return ret;
+}
+
 int cVectorProcessor::myTick(long long t)
 {
   SMILE_IDBG(4,"tick # %i, running vector processor",t);
@@ -316,6 +407,11 @@ int cVectorProcessor::myTick(long long t)
   if (!(writer_->checkWrite(1))) return 0;
   // printf("'%s' checkwrite ok\n",getInstName());
 
+  if (blockFrames > 1) {
+    int r = processBlock();
+    if (r >= 0) return r;
+  }
+
   // get next frame from dataMemory
   cVector *vec = reader_->getNextFrame();
   int i;
@@ -439,5 +535,8 @@ cVectorProcessor::~cVectorProcessor()
   if (fconfInv != nullptr) free(fconfInv);
   if (confBs != nullptr)  free(confBs);
   if (vecO!=nullptr) delete vecO;
+  if (blockIn!=nullptr) delete blockIn;
+  if (blockOut!=nullptr) delete blockOut;
+  if (blockRes!=nullptr) free(blockRes);
 }
 
@@ -0,0 +1,364 @@
+/*F***************************************************************************
+ * 
+ * openSMILE - the Munich open source Multimedia Interpretation by 
+ * Large-scale Extraction toolkit
+ * 
+ * This file is part of openSMILE.
+ * 
+ * openSMILE is copyright (c) by audEERING GmbH. All rights reserved.
+ * 
+ * See file "COPYING" for details on usage rights and licensing terms.
+ * By using, copying, editing, compiling, modifying, reading, etc. this
+ * file, you agree to the licensing terms in the file COPYING.
+ * If you do not agree to the licensing terms,
+ * you must immediately destroy all copies of this file.
+ * 
+ * THIS SOFTWARE COMES "AS IS", WITH NO WARRANTIES. THIS MEANS NO EXPRESS,
+ * IMPLIED OR STATUTORY WARRANTY, INCLUDING WITHOUT LIMITATION, WARRANTIES OF
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ANY WARRANTY AGAINST
+ * INTERFERENCE WITH YOUR ENJOYMENT OF THE SOFTWARE OR ANY WARRANTY OF TITLE
+ * OR NON-INFRINGEMENT. THERE IS NO WARRANTY THAT THIS SOFTWARE WILL FULFILL
+ * ANY OF YOUR PARTICULAR PURPOSES OR NEEDS. ALSO, YOU MUST PASS THIS
+ * DISCLAIMER ON WHENEVER YOU DISTRIBUTE THE SOFTWARE OR DERIVATIVE WORKS.
+ * NEITHER TUM NOR ANY CONTRIBUTOR TO THE SOFTWARE WILL BE LIABLE FOR ANY
+ * DAMAGES RELATED TO THE SOFTWARE OR THIS LICENSE AGREEMENT, INCLUDING
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL OR INCIDENTAL DAMAGES, TO THE
+ * MAXIMUM EXTENT THE LAW PERMITS, NO MATTER WHAT LEGAL THEORY IT IS BASED ON.
+ * ALSO, YOU MUST PASS THIS LIMITATION OF LIABILITY ON WHENEVER YOU DISTRIBUTE
+ * THE SOFTWARE OR DERIVATIVE WORKS.
+ * 
+ * Main authors: Florian Eyben, Felix Weninger, 
+ * 	      Martin Woellmer, Bjoern Schuller
+ * 
+ * Copyright (c) 2008-2013, 
+ *   Institute for Human-Machine Communication,
+ *   Technische Universitaet Muenchen, Germany
+ * 
+ * Copyright (c) 2013-2015, 
+ *   audEERING UG (haftungsbeschraenkt),
+ *   Gilching, Germany
+ * 
+ * Copyright (c) 2016,	 
+ *   audEERING GmbH,
+ *   Gilching Germany
+ ***************************************************************************E*/
+
+
+/*  openSMILE batched real FFT
+
+see fftBatch.hpp
+
+*/
+
+
+#include <dspcore/fftBatch.hpp>
+#include <map>
+#include <mutex>
+
+#define MODULE "cFftBatch"
+
+/* SIMD lane vectors: a block of L frames is transformed with one instruction per operation */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+
+struct sFftVecF {
+  typedef float T;
+  enum { L = 4 };
+  __m128 v;
+  sFftVecF() {}
+  sFftVecF(__m128 x) : v(x) {}
+  static sFftVecF load(const float *p) { return _mm_loadu_ps(p); }
+  static sFftVecF set1(float x) { return _mm_set1_ps(x); }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+};
+static inline sFftVecF operator+(sFftVecF a, sFftVecF b) { return _mm_add_ps(a.v, b.v); }
+static inline sFftVecF operator-(sFftVecF a, sFftVecF b) { return _mm_sub_ps(a.v, b.v); }
+static inline sFftVecF operator*(sFftVecF a, sFftVecF b) { return _mm_mul_ps(a.v, b.v); }
+
+struct sFftVecD {
+  typedef double T;
+  enum { L = 2 };
+  __m128d v;
+  sFftVecD() {}
+  sFftVecD(__m128d x) : v(x) {}
+  static sFftVecD load(const double *p) { return _mm_loadu_pd(p); }
+  static sFftVecD set1(double x) { return _mm_set1_pd(x); }
+  void store(double *p) const { _mm_storeu_pd(p, v); }
+};
+static inline sFftVecD operator+(sFftVecD a, sFftVecD b) { return _mm_add_pd(a.v, b.v); }
+static inline sFftVecD operator-(sFftVecD a, sFftVecD b) { return _mm_sub_pd(a.v, b.v); }
+static inline sFftVecD operator*(sFftVecD a, sFftVecD b) { return _mm_mul_pd(a.v, b.v); }
+
+#else
+
+template <typename T_, int L_>
+struct sFftVecScalar {
+  typedef T_ T;
+  enum { L = L_ };
+  T v[L];
+  static sFftVecScalar load(const T *p) { sFftVecScalar r; for (int l = 0; l < L; l++) r.v[l] = p[l]; return r; }
+  static sFftVecScalar set1(T x) { sFftVecScalar r; for (int l = 0; l < L; l++) r.v[l] = x; return r; }
+  void store(T *p) const { for (int l = 0; l < L; l++) p[l] = v[l]; }
+};
+template <typename T, int L>
+static inline sFftVecScalar<T,L> operator+(const sFftVecScalar<T,L> &a, const sFftVecScalar<T,L> &b)
+  { sFftVecScalar<T,L> r; for (int l = 0; l < L; l++) r.v[l] = a.v[l] + b.v[l]; return r; }
+template <typename T, int L>
+static inline sFftVecScalar<T,L> operator-(const sFftVecScalar<T,L> &a, const sFftVecScalar<T,L> &b)
+  { sFftVecScalar<T,L> r; for (int l = 0; l < L; l++) r.v[l] = a.v[l] - b.v[l]; return r; }
+template <typename T, int L>
+static inline sFftVecScalar<T,L> operator*(const sFftVecScalar<T,L> &a, const sFftVecScalar<T,L> &b)
+  { sFftVecScalar<T,L> r; for (int l = 0; l < L; l++) r.v[l] = a.v[l] * b.v[l]; return r; }
+
+typedef sFftVecScalar<float,4> sFftVecF;
+typedef sFftVecScalar<double,2> sFftVecD;
+
+#endif
+
+/********************* plan ***********************************/
+
+cFftBatchPlan::cFftBatchPlan(long _n) :
+  n(_n), m(_n/2), log2m(0)
+{
+  long j;
+  while ((1L << log2m) < m) log2m++;
+  bitrev.resize(m);
+  for (j = 0; j < m; j++) {
+    long r = 0;
+    for (int b = 0; b < log2m; b++) {
+      if (j & (1L << b)) r |= 1L << (log2m - 1 - b);
+    }
+    bitrev[j] = r;
+  }
+  wr.resize(m); wi.resize(m);
+  rr.resize(m); ri.resize(m);
+  wrf.resize(m); wif.resize(m);
+  rrf.resize(m); rif.resize(m);
+  for (j = 0; j < m; j++) {
+    double a = 2.0 * M_PI * (double)j / (double)m;
+    wr[j] = cos(a);
+    wi[j] = -sin(a);
+    a = 2.0 * M_PI * (double)j / (double)n;
+    rr[j] = cos(a);
+    ri[j] = -sin(a);
+    wrf[j] = (float)wr[j]; wif[j] = (float)wi[j];
+    rrf[j] = (float)rr[j]; rif[j] = (float)ri[j];
+  }
+}
+
+std::shared_ptr<const cFftBatchPlan> cFftBatchPlan::get(long n)
+{
+  if (!cFftBatch::isSupportedSize(n)) {
+    COMP_ERR("batched FFT of size %ld is not supported, the size must be a power of 2 >= 4", n);
+  }
+  static std::mutex plansMtx;
+  static std::map<long, std::weak_ptr<const cFftBatchPlan> > plans;
+  std::lock_guard<std::mutex> lock(plansMtx);
+  std::shared_ptr<const cFftBatchPlan> p = plans[n].lock();
+  if (!p) {
+    p = std::make_shared<const cFftBatchPlan>(n);
+    plans[n] = p;
+  }
+  return p;
+}
+
+/********************* transforms ***********************************/
+
+/* in-place complex FFT (negative exponent) of size m on L lanes, element j of lane l at [j*L + l].
+   The input is in bit reversed order, the output in natural order.
+   Pairs of radix-2 decimation in time stages are done as one radix-4 stage. */
+template <class V>
+static void fftBatchComplex(const cFftBatchPlan &p, const typename V::T *wr, const typename V::T *wi,
+                            typename V::T *re, typename V::T *im)
+{
+  typedef typename V::T T;
+  const long L = V::L;
+  const long m = p.m;
+  long h = 1;
+  if (p.log2m & 1) {
+    for (long j = 0; j < m; j += 2) {
+      T *r0 = re + j*L, *i0 = im + j*L;
+      V ar = V::load(r0), ai = V::load(i0);
+      V br = V::load(r0 + L), bi = V::load(i0 + L);
+      (ar + br).store(r0); (ai + bi).store(i0);
+      (ar - br).store(r0 + L); (ai - bi).store(i0 + L);
+    }
+    h = 2;
+  }
+  for ( ; h < m; h *= 4) {
+    const long step = m / (4*h);
+    for (long g = 0; g < m; g += 4*h) {
+      for (long k = 0; k < h; k++) {
+        T *r0 = re + (g+k)*L, *r1 = r0 + h*L, *r2 = r1 + h*L, *r3 = r2 + h*L;
+        T *i0 = im + (g+k)*L, *i1 = i0 + h*L, *i2 = i1 + h*L, *i3 = i2 + h*L;
+        V w1r = V::set1(wr[k*step]), w1i = V::set1(wi[k*step]);
+        V w2r = V::set1(wr[2*k*step]), w2i = V::set1(wi[2*k*step]);
+        V w3r = V::set1(wr[3*k*step]), w3i = V::set1(wi[3*k*step]);
+        V x0r = V::load(r0), x0i = V::load(i0);
+        V x1r = V::load(r1), x1i = V::load(i1);
+        V x2r = V::load(r2), x2i = V::load(i2);
+        V x3r = V::load(r3), x3i = V::load(i3);
+        // the element at offset h belongs to the first stage twiddle (w^2k), 2h and 3h to the second
+        V t1r = x1r*w2r - x1i*w2i, t1i = x1r*w2i + x1i*w2r;
+        V t2r = x2r*w1r - x2i*w1i, t2i = x2r*w1i + x2i*w1r;
+        V t3r = x3r*w3r - x3i*w3i, t3i = x3r*w3i + x3i*w3r;
+        V s0r = x0r + t1r, s0i = x0i + t1i;
+        V s1r = x0r - t1r, s1i = x0i - t1i;
+        V s2r = t2r + t3r, s2i = t2i + t3i;
+        V dr = t2r - t3r, di = t2i - t3i;
+        (s0r + s2r).store(r0); (s0i + s2i).store(i0);
+        (s0r - s2r).store(r2); (s0i - s2i).store(i2);
+        (s1r + di).store(r1); (s1i - dr).store(i1);
+        (s1r - di).store(r3); (s1i + dr).store(i3);
+      }
+    }
+  }
+}
+
+/* forward real FFT: the n real values x are transformed as m complex values z_j = x_2j + i x_2j+1,
+   the spectrum X is then split from Z: X_k = E_k + e^(-2 pi i k/n) O_k with
+   E_k = (Z_k + conj(Z_m-k))/2 and O_k = (Z_k - conj(Z_m-k))/2i */
+template <class V>
+static void fftBatchForward(const cFftBatchPlan &p, const typename V::T *wr, const typename V::T *wi,
+                            const typename V::T *rr, const typename V::T *ri, typename V::T *re, typename V::T *im,
+                            const FLOAT_DMEM *src, long srcStride, long nSrc, long padLeft,
+                            FLOAT_DMEM *dst, long dstStride, long nFrames)
+{
+  typedef typename V::T T;
+  const long L = V::L;
+  const long m = p.m;
+  const V half = V::set1((T)0.5);
+  for (long f0 = 0; f0 < nFrames; f0 += L) {
+    long nl = nFrames - f0 < L ? nFrames - f0 : L;
+    for (long l = 0; l < L; l++) {
+      const FLOAT_DMEM *x = src + (f0 + l)*srcStride;
+      for (long j = 0; j < m; j++) {
+        long d = p.bitrev[j]*L + l;
+        long t = 2*j - padLeft;
+        if (l >= nl) { re[d] = 0; im[d] = 0; continue; }
+        re[d] = (t >= 0 && t < nSrc) ? (T)x[t] : (T)0;
+        im[d] = (t+1 >= 0 && t+1 < nSrc) ? (T)x[t+1] : (T)0;
+      }
+    }
+    fftBatchComplex<V>(p, wr, wi, re, im);
+    // X_0 and X_m (both real) go to re[0] and im[0]
+    V z0r = V::load(re), z0i = V::load(im);
+    (z0r + z0i).store(re);
+    (z0r - z0i).store(im);
+    for (long k = 1; k <= m/2; k++) {
+      T *rk = re + k*L, *ik = im + k*L, *rm = re + (m-k)*L, *im_ = im + (m-k)*L;
+      V zkr = V::load(rk), zki = V::load(ik), zmr = V::load(rm), zmi = V::load(im_);
+      V er = (zkr + zmr)*half, ei = (zki - zmi)*half;
+      V or_ = (zki + zmi)*half, oi = (zmr - zkr)*half;
+      V cr = V::set1(rr[k]), ci = V::set1(ri[k]);
+      V pr = or_*cr - oi*ci, pi = oi*cr + or_*ci;
+      (er + pr).store(rk); (ei + pi).store(ik);
+      (er - pr).store(rm); (pi - ei).store(im_);
+    }
+    // rdft layout: a[0] = X_0, a[1] = X_n/2, a[2k] = Re(X_k), a[2k+1] = -Im(X_k)
+    for (long l = 0; l < nl; l++) {
+      FLOAT_DMEM *a = dst + (f0 + l)*dstStride;
+      a[0] = (FLOAT_DMEM)re[l];
+      a[1] = (FLOAT_DMEM)im[l];
+      for (long k = 1; k < m; k++) {
+        a[2*k] = (FLOAT_DMEM)re[k*L + l];
+        a[2*k+1] = (FLOAT_DMEM)(-im[k*L + l]);
+      }
+    }
+  }
+}
+
+/* inverse real FFT: Z_k = E_k + i O_k is rebuilt from the half spectrum with
+   E_k = (X_k + conj(X_m-k))/2 and O_k = (X_k - conj(X_m-k)) e^(2 pi i k/n)/2,
+   the inverse complex FFT of Z gives the output pairs y_2j + i y_2j+1 */
+template <class V>
+static void fftBatchInverse(const cFftBatchPlan &p, const typename V::T *wr, const typename V::T *wi,
+                            const typename V::T *rr, const typename V::T *ri, typename V::T *re, typename V::T *im,
+                            typename V::T *xr, typename V::T *xi,
+                            const FLOAT_DMEM *src, long srcStride, FLOAT_DMEM *dst, long dstStride, long nFrames,
+                            FLOAT_DMEM scale)
+{
+  typedef typename V::T T;
+  const long L = V::L;
+  const long m = p.m;
+  const V half = V::set1((T)0.5);
+  for (long f0 = 0; f0 < nFrames; f0 += L) {
+    long nl = nFrames - f0 < L ? nFrames - f0 : L;
+    for (long l = 0; l < L; l++) {
+      const FLOAT_DMEM *a = src + (f0 + l)*srcStride;
+      if (l >= nl) {
+        for (long k = 0; k < m; k++) { xr[k*L + l] = 0; xi[k*L + l] = 0; }
+        continue;
+      }
+      xr[l] = (T)a[0];
+      xi[l] = (T)a[1];
+      for (long k = 1; k < m; k++) {
+        xr[k*L + l] = (T)a[2*k];
+        xi[k*L + l] = -(T)a[2*k+1];
+      }
+    }
+    // the input of the forward complex FFT is conj(Z), in bit reversed order
+    V x0 = V::load(xr), xm = V::load(xi);
+    ((x0 + xm)*half).store(re);
+    (V::set1(0) - (x0 - xm)*half).store(im);
+    for (long k = 1; k <= m/2; k++) {
+      V xkr = V::load(xr + k*L), xki = V::load(xi + k*L);
+      V xmr = V::load(xr + (m-k)*L), xmi = V::load(xi + (m-k)*L);
+      V er = (xkr + xmr)*half, ei = (xki - xmi)*half;
+      V dr = xkr - xmr, di = xki + xmi;
+      V cr = V::set1(rr[k]), ci = V::set1(ri[k]);
+      V or_ = (dr*cr + di*ci)*half, oi = (di*cr - dr*ci)*half;
+      long bk = p.bitrev[k]*L, bm = p.bitrev[m-k]*L;
+      (er - oi).store(re + bk); (V::set1(0) - (ei + or_)).store(im + bk);
+      (er + oi).store(re + bm); (ei - or_).store(im + bm);
+    }
+    fftBatchComplex<V>(p, wr, wi, re, im);
+    for (long l = 0; l < nl; l++) {
+      FLOAT_DMEM *y = dst + (f0 + l)*dstStride;
+      for (long j = 0; j < m; j++) {
+        y[2*j] = (FLOAT_DMEM)re[j*L + l] * scale;
+        y[2*j+1] = (FLOAT_DMEM)(-im[j*L + l]) * scale;
+      }
+    }
+  }
+}
+
+cFftBatch::cFftBatch(long n, int _singlePrecision) :
+  plan(cFftBatchPlan::get(n)),
+  singlePrecision(_singlePrecision)
+{
+  if (singlePrecision) workF.resize(4 * plan->m * sFftVecF::L);
+  else workD.resize(4 * plan->m * sFftVecD::L);
+}
+
+void cFftBatch::forward(const FLOAT_DMEM *src, long srcStride, long nSrc, long padLeft,
+                        FLOAT_DMEM *dst, long dstStride, long nFrames)
+{
+  const cFftBatchPlan &p = *plan;
+  if (singlePrecision) {
+    float *re = workF.data(), *im = re + p.m * sFftVecF::L;
+    fftBatchForward<sFftVecF>(p, p.wrf.data(), p.wif.data(), p.rrf.data(), p.rif.data(), re, im,
+        src, srcStride, nSrc, padLeft, dst, dstStride, nFrames);
+  } else {
+    double *re = workD.data(), *im = re + p.m * sFftVecD::L;
+    fftBatchForward<sFftVecD>(p, p.wr.data(), p.wi.data(), p.rr.data(), p.ri.data(), re, im,
+        src, srcStride, nSrc, padLeft, dst, dstStride, nFrames);
+  }
+}
+
+void cFftBatch::inverse(const FLOAT_DMEM *src, long srcStride,
+                        FLOAT_DMEM *dst, long dstStride, long nFrames, FLOAT_DMEM scale)
+{
+  const cFftBatchPlan &p = *plan;
+  if (singlePrecision) {
+    const long mL = p.m * sFftVecF::L;
+    float *re = workF.data();
+    fftBatchInverse<sFftVecF>(p, p.wrf.data(), p.wif.data(), p.rrf.data(), p.rif.data(),
+        re, re + mL, re + 2*mL, re + 3*mL, src, srcStride, dst, dstStride, nFrames, scale);
+  } else {
+    const long mL = p.m * sFftVecD::L;
+    double *re = workD.data();
+    fftBatchInverse<sFftVecD>(p, p.wr.data(), p.wi.data(), p.rr.data(), p.ri.data(),
+        re, re + mL, re + 2*mL, re + 3*mL, src, srcStride, dst, dstStride, nFrames, scale);
+  }
+}
@@ -71,6 +71,8 @@ SMILECOMPONENT_REGCOMP(cTransformFFT)
   SMILECOMPONENT_IFNOTREGAGAIN(
     ct->setField("inverse", "1 = perform inverse real FFT", 0);
     ct->setField("zeroPadSymmetric", "1 = zero pad symmetric (when zero padding to next power of 2), i.e. center frame and pad left and right with zeros. New since version 2.3: this is the default, but should not affect FFT magnitudes at all, only phase.", 1);
+    ct->setField("batchFrames", "Number of frames to transform at once (if available) with the batched SIMD FFT (see batchSinglePrecision). 1 = transform frame by frame with the standard rdft code.", 1);
+    ct->setField("batchSinglePrecision", "1 = compute the batched FFT (batchFrames > 1) in single precision (twice as many frames per SIMD instruction), 0 = compute it in double precision. The results differ from the frame by frame FFT only by rounding in both cases.", 0);
   )
   SMILECOMPONENT_MAKEINFO(cTransformFFT);
 }
@@ -85,7 +87,8 @@ cTransformFFT::cTransformFFT(const char *_name) :
   w_(nullptr),
   xconv_(nullptr),
   newFsSet_(0),
-  frameSizeSecOut_(0.0)
+  frameSizeSecOut_(0.0),
+  batch_(nullptr)
 { }
 
 void cTransformFFT::fetchConfig()
@@ -99,6 +102,13 @@ void cTransformFFT::fetchConfig()
     inverse_ = 1; // sign of exponent
   }
   zeroPadSymmetric_ = getInt("zeroPadSymmetric");
+  batchFrames_ = getInt("batchFrames");
+  if (batchFrames_ < 1) batchFrames_ = 1;
+  batchSinglePrecision_ = getInt("batchSinglePrecision");
+  if (batchFrames_ > 1) {
+    SMILE_IDBG(2, "batched FFT over up to %i frames (%s precision)", batchFrames_, batchSinglePrecision_ ? "single" : "double");
+    setBlockFrames(batchFrames_);
+  }
 }
 
 int cTransformFFT::configureWriter(sDmLevelConfig &c)
@@ -192,9 +202,11 @@ int cTransformFFT::myFinaliseInstance()
       multiConfFree(xconv_);
       xconv_ = nullptr;
     }
+    freeBatch();
     ip_ = (int**)multiConfAlloc(); 
     w_ = (FLOAT_TYPE_FFT**)multiConfAlloc();
     xconv_ = (FLOAT_TYPE_FFT**)multiConfAlloc();
+    batch_ = (cFftBatch**)multiConfAlloc();
   }
   return ret;
 }
@@ -260,8 +272,41 @@ int cTransformFFT::processVectorFloat(const FLOAT_DMEM *src, FLOAT_DMEM *dst, lo
   return 1;
 }
 
+// transforms nFrames frames at once, the output matches processVectorFloat up to rounding
+int cTransformFFT::processVectorFloatBlock(const FLOAT_DMEM *src, long srcStride, FLOAT_DMEM *dst, long dstStride,
+                                           long nFrames, long Nsrc, long Ndst, int idxi)
+{
+  // sizes the batched FFT does not handle are transformed frame by frame with rdft
+  if (!cFftBatch::isSupportedSize(Ndst)) return VECTORPROCESSOR_BLOCK_NOT_HANDLED;
+  idxi = getFconf(idxi);
+  cFftBatch *b = batch_[idxi];
+  if (b == nullptr) {
+    b = new cFftBatch(Ndst, batchSinglePrecision_);
+    batch_[idxi] = b;
+  }
+  if (inverse_ == 1) {
+    long padLeft = zeroPadSymmetric_ ? (Ndst - Nsrc) / 2 : 0;
+    b->forward(src, srcStride, Nsrc, padLeft, dst, dstStride, nFrames);
+  } else {
+    b->inverse(src, srcStride, dst, dstStride, nFrames, (FLOAT_DMEM)2.0 / (FLOAT_DMEM)Ndst);
+  }
+  return 1;
+}
+
+void cTransformFFT::freeBatch()
+{
+  if (batch_ != nullptr) {
+    for (int i = 0; i < getNf(); i++) {
+      if (batch_[i] != nullptr) delete batch_[i];
+    }
+    free(batch_);
+    batch_ = nullptr;
+  }
+}
+
 cTransformFFT::~cTransformFFT()
 {
+  freeBatch();
   if (ip_ != nullptr)
     multiConfFree(ip_);
   if (w_ != nullptr)
@@ -120,6 +120,8 @@ class  cCommandlineParser {
 
     double getDouble(const char *name) const;
     const char * getStr(const char *name) const;
+    /* overwrite the value of an existing string option (e.g. to re-run a parsed config with another input file) */
+    int setStr(const char *name, const char *value);
 
     ~cCommandlineParser();
 };
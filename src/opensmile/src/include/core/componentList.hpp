@@ -49,6 +49,7 @@
 
 // sources:
 #include <iocore/waveSource.hpp>
+#include <iocore/mp3Source.hpp>
 #include <iocore/arffSource.hpp>
 #include <iocore/csvSource.hpp>
 #include <iocore/htkSource.hpp>
@@ -208,6 +209,9 @@
 
   // sources:
   cWaveSource::registerComponent,
+#ifdef HAVE_MPGLIB
+  cMp3Source::registerComponent,
+#endif
   //cArffSource::registerComponent,
   //cCsvSource::registerComponent,
   //cHtkSource::registerComponent,
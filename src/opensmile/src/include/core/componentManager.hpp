@@ -50,6 +50,8 @@
 #include <core/smileCommon.hpp>
 #include <core/smileComponent.hpp>
 #include <armadillo>
+#include <vector>
+#include <stdint.h>
 // this is the name of the configuration instance in the config file the component manager will search for:
 #define CM_CONF_INST  "componentInstances"
 
@@ -57,6 +59,7 @@
 // global component list: -----------------
 #undef class
 class  cComponentManager;
+class  cDataMemory;
 typedef sComponentInfo * (*registerFunction)(cConfigManager *_confman, cComponentManager *_compman);
 typedef void (*unRegisterFunction)();
 
@@ -126,12 +129,12 @@ public:
                     cComponentManager::RcppModeWork rccpMode,
                     const registerFunction _clist[] = componentlist);               // create component manager
 
-  static void staticSetWaveFeaturesCB(void *p, const arma::rowvec &features_row, const arma::rowvec & timeFrame)
+  static void staticSetWaveFeaturesCB(void *p, const FLOAT_DMEM *features, long nFeatures, double time)
   {
-    ((cComponentManager *) p)->setWaveFeaturesCB(features_row, timeFrame);
+    ((cComponentManager *) p)->setWaveFeaturesCB(features, nFeatures, time);
   }
 
-  void setWaveFeaturesCB(const arma::rowvec &features_row, const arma::rowvec & timeFrame);
+  void setWaveFeaturesCB(const FLOAT_DMEM *features, long nFeatures, double time);
 
   static void staticSetWaveHeaderCB(void *p, const sWaveParameters &rcpp_header_)
   {
@@ -140,6 +143,13 @@ public:
 
   void setWaveHeaderCB(const sWaveParameters &rcpp_header_);
 
+  static void staticSetWaveSamplesCB(void *p, const FLOAT_DMEM *samples, long nFrames, long nChan)
+  {
+    ((cComponentManager *) p)->setWaveSamplesCB(samples, nFrames, nChan);
+  }
+
+  void setWaveSamplesCB(const FLOAT_DMEM *samples, long nFrames, long nChan);
+
   static void staticSetWaveFrameBordersCB(void *p, const double &frameStart, const double &frameEnd)
   {
     ((cComponentManager *) p)->setWaveFrameBordersCB(frameStart, frameEnd);
@@ -147,6 +157,7 @@ public:
   
   void setWaveFrameBordersCB(const double &frameStart,  const double &frameEnd);  
   
+  //moves the collected features out (no copy), the component manager keeps no features afterwards
   bool getFeatures(arma::mat & rcpp_audio_features_out,
                       arma::rowvec & rcpp_audio_timestamps_out,
                       sWaveParameters & rcpp_wave_header_out);
@@ -154,6 +165,28 @@ public:
   void getWaveFrameBorders(arma::rowvec & rcpp_audio_start_frames_out,
                            arma::rowvec & rcpp_audio_end_frames_out);
 
+  //header of the file read by the wave source (copied), false if no header was read yet
+  bool getWaveHeader(sWaveParameters & rcpp_wave_header_out) const {
+    if (nullptr == rcpp_wave_header) return false;
+    rcpp_wave_header_out = *rcpp_wave_header;
+    return true;
+  }
+  //config of the current run, component instance options can be changed before createInstances()
+  cConfigManager * getConfigManager() const { return confman; }
+
+  //hand every frame of the data sink to listener as it arrives (in the tick loop) instead of collecting it for getFeatures,
+  //nullptr restores collecting; obj is passed through to listener
+  typedef void (*FeatureFrameListener)(void *obj, const FLOAT_DMEM *features, long nFeatures, double time);
+  void setFeatureFrameListener(FeatureFrameListener listener, void *obj) {
+    rcpp_frame_listener = listener;
+    rcpp_frame_listener_obj = obj;
+  }
+
+  //keep the samples read by cWaveSource (off by default), so the audio does not have to be decoded a second time
+  void setKeepWaveSamples(bool keep) { rcpp_keep_samples = keep; }
+  //moves the kept samples out as int32 full scale, channel after channel: samples[c*nFrames + i]
+  void getWaveSamples(std::vector<int32_t> & rcpp_wave_samples_out, long & nChan_out);
+
   int compIsDm(const char *_compn);
   int ciRegisterComps(int _dm);
   int ciConfigureComps(int _dm);
@@ -260,17 +293,26 @@ timeout :  if how=2, then max number of ticks of nRun>0 , after which pause requ
   ~cComponentManager();              // unregister and free all component objects
 
 private:
-  arma::mat * rcpp_audio_features {nullptr};
-  arma::rowvec * rcpp_audio_timestamps {nullptr};
-  arma::mat rcpp_audio_features_buffer;
-  arma::rowvec rcpp_audio_timestamps_buffer;
+  //features are written in place into the rows of a column major matrix (the layout R uses),
+  //rows are allocated in chunks, see reserveFeatureRows
+  arma::mat rcpp_audio_features;
+  arma::rowvec rcpp_audio_timestamps;
+  long rcpp_features_capacity {0};
+  long rcpp_features_estimate {0};  //frames expected from the wave header, output is padded to this
+  void reserveFeatureRows(long nRows, long nFeatures);
   arma::rowvec rcpp_audio_start_frames;   //from cTurnDetector
   arma::rowvec rcpp_audio_end_frames;     //from cTurnDetector
+  bool rcpp_keep_samples {false};
+  FeatureFrameListener rcpp_frame_listener {nullptr};
+  void *rcpp_frame_listener_obj {nullptr};
+  std::vector<int32_t> rcpp_wave_samples;  //from cWaveSource, interleaved as read
+  long rcpp_wave_samples_nChan {1};
   
   int currentRow {0};
   int currentRowTurn {0};  
   double frameStep {-1.f}; //if -1 we have not data
   sWaveParameters * rcpp_wave_header{nullptr};
+  void resetRcppOutput();  // drop the collected features/header/turn borders, called by resetInstances
   cComponentManager::RcppModeWork rccpMode;
 
   cConfigManager *confman;
@@ -302,6 +344,25 @@ private:
   long messageCounter;
   int oldSingleIterationTickLoop;
 
+  // data-driven tick scheduler (single thread mode), see buildSchedule()
+  int tickScheduler;   // 1 = tick only components with new input, in data flow order; 0 = tick all components in every tick
+  int tickBatch;       // max. successive ticks of a component within one scheduled tick, while it succeeds
+  struct sSchedLevel {
+    cDataMemory *dm;
+    int level;
+  };
+  struct sSchedEntry {
+    int id;                            // component index
+    std::vector<sSchedLevel> inputs;   // levels the component reads from
+    std::vector<sSchedLevel> outputs;  // levels the component writes to
+    std::vector<long> inputW;          // write index of the inputs before the last tick
+    std::vector<long> outputR;         // read index of the outputs before the last tick
+    int lastRun;                       // the last tick succeeded
+  };
+  std::vector<sSchedEntry> schedule;   // component instances in topological order of the level graph
+  void buildSchedule();
+  long tickScheduled(long long tickNr, long lastNrun);
+
   long long pauseStartNr;
   int tickLoopPaused;
   int tickLoopPauseTimeout;
@@ -57,6 +57,7 @@
 #include <core/commandlineParser.hpp>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 int instNameSplit(const char *n, char **b, const char **s);
 
@@ -323,6 +324,7 @@ class  ConfigType {
 
     int                        N,I;  // I points to current Field that is to be set by setField()
     ConfigDescription  *       element;
+    std::unordered_map<std::string, int> fieldIndex;  // field name -> index in element, for findField
 
   public:
     const ConfigDescription * operator[] (int n);
@@ -378,6 +380,28 @@ class  ConfigType {
 };
 
 
+/* a field of a config instance, resolved once by its (hierarchical) name, see cConfigManager::getField:
+   reading the value through the handle costs no name lookup. The handle stays valid as long as the
+   instance holding the field (and, for sub-objects, the parent field) is not deleted, handles kept
+   for longer are re-resolved when cConfigManager::getNInstChanges() changes */
+class  ConfigField {
+  private:
+    ConfigInstance *inst;
+    int n;
+    int arrIdx;
+
+  public:
+    ConfigField() : inst(nullptr), n(-1), arrIdx(-1) {}
+    ConfigField(ConfigInstance *_inst, int _n, int _arrIdx) : inst(_inst), n(_n), arrIdx(_arrIdx) {}
+    bool isValid() const { return inst != nullptr; }
+    inline const ConfigValue * getValue() const;  /* nullptr if the field has no value */
+    int getInt() const { const ConfigValue *v = getValue(); if (v!=nullptr) return v->getInt(); else return 0; }
+    double getDouble() const { const ConfigValue *v = getValue(); if (v!=nullptr) return v->getDouble(); else return 0.0; }
+    const char * getStr() const { const ConfigValue *v = getValue(); if (v!=nullptr) return v->getStr(); else return nullptr; }
+    char getChar() const { const ConfigValue *v = getValue(); if (v!=nullptr) return v->getChar(); else return 0; }
+    int isSet() const { const ConfigValue *v = getValue(); if (v!=nullptr) return v->isSet(); else return 0; }
+};
+
 /******* Config Instance *********/
 class  ConfigInstance {
   private:
@@ -418,6 +442,14 @@ class  ConfigInstance {
       return getValue(-1,_name,arrIdx);
     }
     ConfigInstance *getSubInstance(const char *_name);
+    /* resolve a (hierarchical) field name once, the returned handle is invalid if the field does not exist */
+    ConfigField getField(const char *_name);
+    /* value of field n (element arrIdx for arrays), without range checks, nullptr if not set */
+    const ConfigValue *getFieldValue(int n, int arrIdx) const {
+      const ConfigValue *v = field[n];
+      if ((v != nullptr)&&(arrIdx >= 0)&&(v->getType() >= CFTP_ARR)) return (*(const ConfigValueArr*)v)[arrIdx];
+      return v;
+    }
 
 	// note: added "const" here...?
     int getInt(const char *_name) { const ConfigValue *r = getValue(-1,_name); if (r!=nullptr) return r->getInt(); else return 0; }
@@ -436,6 +468,12 @@ class  ConfigInstance {
     ~ConfigInstance();
 };
 
+inline const ConfigValue * ConfigField::getValue() const
+{
+  if (inst == nullptr) return nullptr;
+  return inst->getFieldValue(n, arrIdx);
+}
+
 
 /******* Config Reader *******/
 class  cConfigManager;
@@ -475,13 +513,16 @@ class  cFileConfigReader : public cConfigReader {
   private:
     fileInstance *inst;
     int nInst, nInstAlloc;
+    const char *inputString;  // in-memory top level config (only valid while the constructor reads it), nullptr = read the file inputPath
 
     void setNlines(int n, int nlines);
     int addInst(const char*_instname, const char*_typename);
     int addLine(int n, const char *line, int lineNr);
 
   public:
-    cFileConfigReader(const char *filename, int id=-1, cCommandlineParser *cmdparser_=nullptr) : cConfigReader(filename,id,cmdparser_), inst(nullptr), nInst(0), nInstAlloc(0) { openInput(); }
+    /* if configString is given, the top level config is parsed from this string instead of the file,
+       filename is then only used in messages and as base path for relative includes */
+    cFileConfigReader(const char *filename, int id=-1, cCommandlineParser *cmdparser_=nullptr, const char *configString=nullptr) : cConfigReader(filename,id,cmdparser_), inst(nullptr), nInst(0), nInstAlloc(0), inputString(configString) { openInput(); inputString = nullptr; }
     virtual int openInput(const char*name=nullptr, int *idx0=nullptr);
     virtual int closeInput() { return 0; }
 
@@ -505,6 +546,9 @@ class  cConfigManager {
     cConfigReader   **reader;
     cCommandlineParser *cmdparser;
     std::map <std::string, void *> *externalObjectMap_;
+    std::unordered_map<std::string, int> instIndex;  // instance name -> index in inst
+    std::unordered_map<std::string, int> typeIndex;  // type name -> index in defaults
+    long nInstChanges;  // counts instances added, updated or deleted, see getNInstChanges()
     
   protected:
     //int findInstance(const char *_instname);
@@ -518,7 +562,11 @@ class  cConfigManager {
     int deleteInstance(const char *_instname);   /* deletes instance "_instname" */
 	  int updateInstance(ConfigInstance *_inst);  /* only uses content from inst to update existing object. object is only added if it does not yet exist  (return value 1 indicated an update, while 0 indicates an adding)*/
     int findInstance(const char *_instname) const; // first level only
+    int findInstance(const char *_instname, size_t len) const; // first len characters of _instname only
     int findType(const char *_typename) const;  // first level only
+    /* changes whenever an instance is added, updated or deleted: field handles resolved
+       (or found invalid) before a change must be resolved again */
+    long getNInstChanges() const { return nInstChanges; }
     const ConfigType *getTypeObj(int n) const;
     const ConfigType *getTypeObj(const char *_typename) const;  // hierarchical type resolving...
 
@@ -533,6 +581,15 @@ class  cConfigManager {
     }
 
     const ConfigValue    * getValue(const char *_name) const;  /* return value is read only! */
+    /* resolve the field "_name" (full name: instance.field) once, reads through the handle cost no lookups,
+       the handle is invalid if the instance or the field does not exist */
+    ConfigField getField(const char *_name);
+    /* the _f getXXX functions free the memory allocated for _name before they return normally! */
+    ConfigField getField_f(char *_name) {
+      ConfigField f = getField(_name);
+      if (_name != nullptr) free(_name);
+      return f;
+    }
     /* the _f getXXX functions free the memory allocated for _name before they return normally! */
     const ConfigValue    * getValue_f(char *_name) const {  /* return value is read only! */
       const ConfigValue *v = getValue(_name);
@@ -56,6 +56,8 @@
 #endif
 
 #include <string.h>
+#include <limits.h>
+#include <atomic>
 
 // temporal frame ID
 #define DMEM_IDX_ABS    -1   // no special index
@@ -217,7 +219,10 @@ class  FrameMetaInfo {
     // global metadata for the whole level (use tmeta->metadata for per frame meta data)
     cVectorMeta metaData;
 
-    FrameMetaInfo() : N(0), Ne(0), field(nullptr) 
+    // start of the field found by the last getName() call (element index, field index)
+    long getNameCacheN, getNameCacheF;
+
+    FrameMetaInfo() : N(0), Ne(0), field(nullptr), getNameCacheN(0), getNameCacheF(0) 
     {
       smileMutexCreate(myMtx);
     }
@@ -510,6 +515,7 @@ class  cVector { public:
 // array index x = col*N + row   ( t*N + n )
 class  cMatrix : public cVector { public:
   long nT;
+  long nTAlloc;  // number of columns (frames) data and tmeta were allocated for, nT may be smaller (e.g. truncated reads)
 
   cMatrix(int lN, int lnT, int ltype=DMEM_FLOAT);
   // TODO: overwritten getval/setval functions for Int and Float
@@ -868,6 +874,13 @@ class  cDataMemoryLevel {
    smileMutex RWstatMtx; // mutex to lock nCurRdr and writeReq variables for mut.ex. write/read op. while allowing mutliple parallel reads
    int nCurRdr;
    int writeReqFlag;
+// -------- lock free mode of ring buffer levels (see setLockFree()), these indices are used instead of curW, curR and curRr:
+   int lockFree;
+   std::atomic<long> lfCurW;     // frames < lfCurW are published, i.e. their data and time meta are completely written
+   std::atomic<long> lfCurWres;  // end of the frames the writer currently writes (>= lfCurW)
+   std::atomic<long> lfCurWlo;   // first frame the writer currently writes, LONG_MAX while it does not write
+   std::atomic<long> *lfCurRr;   // read index of each registered reader, lfCurRr[nReaders] is the one of unregistered readers
+   std::atomic<long> *lfPin;     // first frame each reader is currently copying, LONG_MAX if it does not read
 // --------
     
     /* level configuration */
@@ -1049,56 +1062,54 @@ int  noHang;
       }
     }
 
-    // validate read index, 
+    // validate read index against the write index _curW and the read index *_curR (which is updated unless noUpd is set)
     // return value: -1 invalid param, -2 vidx OOR_left, -3 vidx OOR_right, -4 vidx OOR_buffersize(noRb)
-    long validateIdxR(long *vIdx, int special=-1, int rdId=-1, int noUpd=0)
+    long validateIdxR(long *vIdx, int special, long *_curR, long _curW, int noUpd)
     {
+      SMILE_DBG(5,"validateIdxR ('%s')\n         vidx=%i special=%i curW=%i curR=%i nT=%i",getName(),*vIdx,special,_curW,*_curR,lcfg.nT);
 
-      long *_curR;
-      if ((rdId >= 0)&&(rdId<nReaders)) _curR = curRr+rdId;
-      else _curR=&curR;
-      SMILE_DBG(5,"validateIdxR ('%s')\n         vidx=%i special=%i curW=%i curR=%i nT=%i",getName(),*vIdx,special,curW,*_curR,lcfg.nT);
-
-      if ((lcfg.isRb) && (*_curR < curW-lcfg.nT)) { *_curR = curW-lcfg.nT; SMILE_DBG(3,"validateIdxR: rb data possibly lost, curR < curW-nT, curR was automatically increased!"); }
+      if ((lcfg.isRb) && (*_curR < _curW-lcfg.nT)) { *_curR = _curW-lcfg.nT; SMILE_DBG(3,"validateIdxR: rb data possibly lost, curR < curW-nT, curR was automatically increased!"); }
       if (special == DMEM_IDX_CURR) *vIdx = *_curR;
       else if (special != -1) return -1;
       if (*vIdx < 0) return -2;
-      // TODO:: set curR to min curRr
       if (lcfg.isRb) {
-        if ((*vIdx < curW)&&(*vIdx >= curW-lcfg.nT)) { 
-          if (!noUpd) { 
-            if ((*vIdx>=*_curR)&&(!noUpd)) *_curR = *vIdx+1; 
-            if (rdId >= 0) checkCurRr(); 
-          } 
+        if ((*vIdx < _curW)&&(*vIdx >= _curW-lcfg.nT)) { 
+          if ((!noUpd)&&(*vIdx>=*_curR)) *_curR = *vIdx+1; 
           return *vIdx%lcfg.nT; 
-        } else if (*vIdx >= curW) { return -3; } // OOR_right
-        else if (*vIdx < curW-lcfg.nT) { return -2; } // OOR_left
+        } else if (*vIdx >= _curW) { return -3; } // OOR_right
+        else if (*vIdx < _curW-lcfg.nT) { return -2; } // OOR_left
       }
       else { // no ringbuffer
-        if ((*vIdx < curW)&&(*vIdx < lcfg.nT)) { 
-          if (!noUpd) { 
-            if (*vIdx>=*_curR) *_curR = *vIdx+1; 
-            if (rdId >= 0) checkCurRr(); 
-          } 
+        if ((*vIdx < _curW)&&(*vIdx < lcfg.nT)) { 
+          if ((!noUpd)&&(*vIdx>=*_curR)) *_curR = *vIdx+1; 
           return *vIdx; 
-        } else if (*vIdx >= curW) { return -3; } // OOR_right
+        } else if (*vIdx >= _curW) { return -3; } // OOR_right
         else if (*vIdx >= lcfg.nT) { return -4; } // OOR_buffersize
       }
       return -1;
     }
 
-    //validate read index range, vIdxEnd   is the index after the last index to read... (i.e. vIdx + len)
-    // TODO: error codes
-    long validateIdxRangeR(long actualVidx, long *vIdx, long vIdxEnd, int special=-1, int rdId=-1, int noUpd=0, int *padEnd=nullptr)
+    // validate read index of reader rdId (or the global read index), 
+    // return value: -1 invalid param, -2 vidx OOR_left, -3 vidx OOR_right, -4 vidx OOR_buffersize(noRb)
+    long validateIdxR(long *vIdx, int special=-1, int rdId=-1, int noUpd=0)
     {
-      SMILE_DBG(5,"validateIdxRangeR ('%s')\n         vidx=%i vidxend=%i special=%i curW=%i curR=%i nT=%i",getName(),*vIdx,vIdxEnd,special,curW,curR,lcfg.nT);
       long *_curR;
       if ((rdId >= 0)&&(rdId<nReaders)) _curR = curRr+rdId;
       else _curR=&curR;
-      SMILE_DBG(5,"validateIdxRangeR(2) '%s' vidx=%i vidxend=%i special=%i curW=%i _curR=%i nT=%i",this->lcfg.name,*vIdx,vIdxEnd,special,curW,*_curR,lcfg.nT);
+      long rIdx = validateIdxR(vIdx, special, _curR, curW, noUpd);
+      if ((rIdx >= 0)&&(!noUpd)&&(rdId >= 0)) checkCurRr();
+      return rIdx;
+    }
+
+    //validate read index range against the write index _curW and the read index *_curR (which is updated unless noUpd is set),
+    // vIdxEnd   is the index after the last index to read... (i.e. vIdx + len)
+    // TODO: error codes
+    long validateIdxRangeR(long actualVidx, long *vIdx, long vIdxEnd, int special, long *_curR, long _curW, int noUpd, int *padEnd)
+    {
+      SMILE_DBG(5,"validateIdxRangeR(2) '%s' vidx=%i vidxend=%i special=%i curW=%i _curR=%i nT=%i",this->lcfg.name,*vIdx,vIdxEnd,special,_curW,*_curR,lcfg.nT);
 
-      if ((lcfg.isRb) && (*_curR < curW-lcfg.nT)) {
-        *_curR = curW-lcfg.nT;
+      if ((lcfg.isRb) && (*_curR < _curW-lcfg.nT)) {
+        *_curR = _curW-lcfg.nT;
         SMILE_WRN(4, "level: '%s': validateIdxRangeR: rb data possibly lost, curR < curW-nT, curR was automatically increased!", lcfg.name);
       }
       if (vIdxEnd < *vIdx) { SMILE_ERR(2,"validateIdxRangeR: vIdxEnd (%i) cannot be smaller than vIdx (%i)!",vIdxEnd,*vIdx); return -1; }
@@ -1106,34 +1117,65 @@ int  noHang;
       else if ((special != -1)&&(special!=DMEM_PAD_ZERO)&&(special!=DMEM_PAD_FIRST)&&(special!=DMEM_PAD_NONE)) return -1;
       if (*vIdx < 0) return -1;
 
-      if ((vIdxEnd > curW)&&(isEOI())) { // pad
+      if ((vIdxEnd > _curW)&&(isEOI())) { // pad
         if (padEnd != nullptr) {
-          *padEnd = vIdxEnd - curW;
+          *padEnd = vIdxEnd - _curW;
           if (*padEnd >= vIdxEnd-*vIdx) { *padEnd = vIdxEnd-*vIdx;  return -1; }
         }
       	// TODO: pad option for "truncate" at the end of input!
-        vIdxEnd = curW;
+        vIdxEnd = _curW;
       }
-      if ((lcfg.isRb)&&(*vIdx < curW)&&(vIdxEnd <= curW)&&(*vIdx >= curW-lcfg.nT))
+      if ((lcfg.isRb)&&(*vIdx < _curW)&&(vIdxEnd <= _curW)&&(*vIdx >= _curW-lcfg.nT))
       { 
-        if (!noUpd) { 
-          //if (vIdxEnd>=*_curR) *_curR = *vIdx+1; if (rdId >= 0) checkCurRr(); 
-          if (vIdxEnd>=*_curR) *_curR = actualVidx+1; if (rdId >= 0) checkCurRr(); 
-        } 
+        if ((!noUpd)&&(vIdxEnd>=*_curR)) *_curR = actualVidx+1;
         return *vIdx%lcfg.nT; 
       } else                                              // +1 ????? XXX
-        if ((!lcfg.isRb)&&(*vIdx < curW)&&(*vIdx < lcfg.nT)&&(vIdxEnd <= curW)&&(vIdxEnd <= lcfg.nT))
+        if ((!lcfg.isRb)&&(*vIdx < _curW)&&(*vIdx < lcfg.nT)&&(vIdxEnd <= _curW)&&(vIdxEnd <= lcfg.nT))
         { 
-          if (!noUpd) { 
-            if (vIdxEnd>=*_curR) *_curR = actualVidx+1; if (rdId >= 0) checkCurRr(); 
-            //if (vIdxEnd>=*_curR) *_curR = *vIdx+1; if (rdId >= 0) checkCurRr(); 
-          } 
+          if ((!noUpd)&&(vIdxEnd>=*_curR)) *_curR = actualVidx+1;
           return *vIdx; 
         }
       if (padEnd != nullptr) *padEnd = 0;
       return -1;
     }
 
+    //validate read index range of reader rdId (or the global read index), vIdxEnd   is the index after the last index to read... (i.e. vIdx + len)
+    long validateIdxRangeR(long actualVidx, long *vIdx, long vIdxEnd, int special=-1, int rdId=-1, int noUpd=0, int *padEnd=nullptr)
+    {
+      long *_curR;
+      if ((rdId >= 0)&&(rdId<nReaders)) _curR = curRr+rdId;
+      else _curR=&curR;
+      long rIdx = validateIdxRangeR(actualVidx, vIdx, vIdxEnd, special, _curR, curW, noUpd, padEnd);
+      if ((rIdx >= 0)&&(!noUpd)&&(rdId >= 0)) checkCurRr();
+      return rIdx;
+    }
+
+    /* lock free mode (see setLockFree()) */
+    // slot of reader rdId in lfCurRr and lfPin, unregistered readers share the last one
+    int lfSlot(int rdId) const { return ((rdId >= 0)&&(rdId < nReaders)) ? rdId : nReaders; }
+    // minimal read index over all registered readers (the one of unregistered readers, if there are none)
+    long lfMinR() const {
+      if (nReaders <= 0) return lfCurRr[nReaders].load(std::memory_order_acquire);
+      long r = lfCurRr[0].load(std::memory_order_acquire);
+      for (int i=1; i<nReaders; i++) {
+        long ri = lfCurRr[i].load(std::memory_order_acquire);
+        if (ri < r) r = ri;
+      }
+      return r;
+    }
+    // reserve frames *vIdx..*vIdx+n-1 for writing and wait until no reader copies frames from their slots,
+    // returns the rIdx of *vIdx or -1 if the frames cannot be written; publish the frames with lfPublishW(*wEnd)
+    long lfReserveW(long *vIdx, long n, int special, long *wEnd);
+    void lfPublishW(long wEnd) {
+      lfCurW.store(wEnd, std::memory_order_release);
+      lfCurWlo.store(LONG_MAX, std::memory_order_release);
+    }
+    // validate a read (of a range if range=1, else of a single frame) of reader slot and pin its frames, they are not
+    // overwritten until lfEndRead(); *own receives the new read index of the reader; same return values as validateIdx[Range]R
+    long lfBeginRead(int slot, long actualVidx, long *vIdx, long vIdxEnd, int special, int noUpd, int *padEnd, long *own, int range);
+    // store the new read index of reader slot and release the pin, must be called after every lfBeginRead()
+    void lfEndRead(int slot, long own);
+
     // write frame data from *_data to level's data matrix at pos rIdx
     void frameWr(long rIdx, FLOAT_DMEM *_data);
     void frameWr(long rIdx, INT_DMEM *_data);
@@ -1141,6 +1183,8 @@ int  noHang;
     // write frame data from level's data matrix at pos rIdx to *_data
     void frameRd(long rIdx, FLOAT_DMEM *_data);
     void frameRd(long rIdx, INT_DMEM *_data);
+    // copy n consecutive frames (data and time meta) starting at pos rIdx into columns col... of mat (handles the ring buffer wrap)
+    void framesRd(long rIdx, long n, cMatrix *mat, long col);
 
     void setTimeMeta(long rIdx, long vIdx, const TimeMetaInfo *tm);
     void getTimeMeta(long rIdx, TimeMetaInfo *tm);
@@ -1151,6 +1195,8 @@ int  noHang;
     cDataMemoryLevel(int _levelId, sDmLevelConfig &cfg, const char *_name = nullptr) :
       myId(_levelId), _parent(nullptr),
       nCurRdr(0), writeReqFlag(0),
+      lockFree(0), lfCurW(0), lfCurWres(0), lfCurWlo(LONG_MAX),
+      lfCurRr(nullptr), lfPin(nullptr),
       lcfg(_name, cfg), fmetaNalloc(0),
       data(nullptr), curW(0), curR(0), 
       curRr(nullptr), nReaders(0), 
@@ -1166,6 +1212,8 @@ int  noHang;
     cDataMemoryLevel(int _levelId, const char *_name, long _nT, int rb=1, int dyn=0, int _type=DMEM_FLOAT) :
       myId(_levelId), _parent(nullptr),
       nCurRdr(0), writeReqFlag(0),     
+      lockFree(0), lfCurW(0), lfCurWres(0), lfCurWlo(LONG_MAX),
+      lfCurRr(nullptr), lfPin(nullptr),
       lcfg(_name, 0.0, 0.0, _nT, _type, rb), fmetaNalloc(0),
         //sDmLevelConfig(const char *_name, double _T, double _frameSizeSec, long _nT=10, int _type=DMEM_FLOAT, int _isRb=1) :
       data(nullptr),  curW(0), curR(0),
@@ -1200,6 +1248,13 @@ int  noHang;
     // set parent dataMemory object
     void setParent(cDataMemory * __parent) { _parent = __parent; }
 
+    // access the level without mutexes: the single writer of the level (see cDataMemory::registerWriteRequest) reserves
+    // the slots it writes, waits for readers still copying from them, and publishes the frames after data and time meta
+    // are written; readers pin the frames they copy. Only applied to ring buffer levels, other levels may be reallocated
+    // during a write. Must be called before allocReaders().
+    void setLockFree(int lf) { lockFree = ((lf)&&(lcfg.isRb)) ? 1 : 0; }
+    int isLockFree() const { return lockFree; }
+
     // adds a field to this level, _N is the number of elements in an array field, set to 0 or 1 for scalar field
     // arrNameOffset: start index for creating array element names
     int addField(const char *lname, int lN, int arrNameOffset=0);
@@ -1247,7 +1302,9 @@ int  noHang;
     // *result (if not nullptr) will contain a result code indicating success or reason of failure (left or right buffer margin exceeded, etc.)
     // rdId is the id of the current reader (or -1 for an unregistered or global reader)
     cVector * getFrame(long vIdx, int special=-1, int rdId=-1, int *result=nullptr);  
-    cMatrix * getMatrix(long vIdx, long vIdxEnd, int special=-1, int rdId=-1, int *result=nullptr);  
+    // mat (optional): matrix of a previous call to fill in place, if it does not have the right size it is deleted and a new one is returned
+    //  (it is left untouched if the read fails)
+    cMatrix * getMatrix(long vIdx, long vIdxEnd, int special=-1, int rdId=-1, int *result=nullptr, cMatrix *mat=nullptr);  
 
     /* check if a read of length "len" at vIdx or "special" will succeed for reader rdId */
     // *result (if not nullptr) will contain a result code indicating success or reason of failure (left or right buffer margin exceeded, etc.)
@@ -1260,11 +1317,17 @@ int  noHang;
       if ((vIdx < 0)&&(vIdxEnd > 0)) vIdx = 0;
       if (len < 0) return 0;
 
-      smileMutexLock(RWptrMtx);
-      if (len<=1) rIdx = validateIdxR(&vIdx,special,rdId,1);
-      else rIdx = validateIdxRangeR(vIdxold,&vIdx,vIdxEnd,special,rdId,1);
-
-      smileMutexUnlock(RWptrMtx);
+      if (lockFree) {
+        int slot = lfSlot(rdId);
+        long own;
+        rIdx = lfBeginRead(slot,vIdxold,&vIdx,vIdxEnd,special,1,nullptr,&own,(len>1));
+        lfEndRead(slot,own);
+      } else {
+        smileMutexLock(RWptrMtx);
+        if (len<=1) rIdx = validateIdxR(&vIdx,special,rdId,1);
+        else rIdx = validateIdxRangeR(vIdxold,&vIdx,vIdxEnd,special,rdId,1);
+        smileMutexUnlock(RWptrMtx);
+      }
       if (result!=nullptr) {
         if (rIdx == -2) *result=DMRES_OORleft|DMRES_ERR;
         else if (rIdx == -3) *result=DMRES_OORright|DMRES_ERR;
@@ -1295,6 +1358,7 @@ int  noHang;
     /* get current write index (index that will be written to NEXT) */
     long getCurW() 
     {
+      if (lockFree) return lfCurW.load(std::memory_order_acquire);
       smileMutexLock(RWptrMtx);
       long res = curW;
       smileMutexUnlock(RWptrMtx);
@@ -1305,6 +1369,10 @@ int  noHang;
     long getCurR(int rdId=-1) 
     {
       long res;
+      if (lockFree) {
+        if ((rdId < 0)||(rdId >= nReaders)) return lfMinR();
+        return lfCurRr[rdId].load(std::memory_order_acquire);
+      }
       smileMutexLock(RWptrMtx);
       if ((rdId < 0)||(rdId >= nReaders)) { 
         res = curR;
@@ -1328,6 +1396,10 @@ int  noHang;
 	      return 1000000;  // default value, because level will grow
 
       long ret=0;
+      if (lockFree) {
+        long r = ((rdId>=0)&&(rdId<nReaders)) ? lfCurRr[rdId].load(std::memory_order_acquire) : lfMinR();
+        return lcfg.nT - (lfCurW.load(std::memory_order_acquire) - r);
+      }
       smileMutexLock(RWptrMtx);
       if (lcfg.isRb) {
         if ((rdId>=0)&&(rdId<nReaders)) {
@@ -1348,6 +1420,10 @@ int  noHang;
     long getNAvail(int rdId=-1)
     { 
       long ret=0;
+      if (lockFree) {
+        long r = ((rdId>=0)&&(rdId<nReaders)) ? lfCurRr[rdId].load(std::memory_order_acquire) : lfMinR();
+        return lfCurW.load(std::memory_order_acquire) - r;
+      }
       smileMutexLock(RWptrMtx);
       if (lcfg.isRb) {
         if ((rdId>=0)&&(rdId<nReaders)) {
@@ -1445,6 +1521,8 @@ int  noHang;
       if (tmeta != nullptr) delete[] tmeta; // was: free(tmeta) !
       if (data != nullptr) delete data;
       if (curRr != nullptr) free(curRr);
+      if (lfCurRr != nullptr) delete[] lfCurRr;
+      if (lfPin != nullptr) delete[] lfPin;
     }
 
 };
@@ -1538,13 +1616,15 @@ class  cDataMemory : public cSmileComponent {
     cDmLevelRWRequestList rrq;  // read requests
     cDmLevelRWRequestList wrq;  // write requests
 
+    int lockFreeRb;
+
     // used internally...
     void _addLevel();
 
   protected:
     SMILECOMPONENT_STATIC_DECL_PR
 
-    void fetchConfig() {}
+    virtual void fetchConfig();
     virtual int myRegisterInstance(int *runMe=nullptr);
     virtual int myConfigureInstance();
     virtual int myFinaliseInstance();
@@ -1554,15 +1634,21 @@ class  cDataMemory : public cSmileComponent {
     SMILECOMPONENT_STATIC_DECL
 
     cDataMemory() : cSmileComponent("dataMemory"), level(nullptr), 
-      nLevelsAlloc(0), nLevels(-1) {}
+      nLevelsAlloc(0), nLevels(-1), lockFreeRb(0) {}
 
     cDataMemory(const char *_name) : cSmileComponent(_name), level(nullptr),
-      nLevelsAlloc(0), nLevels(-1) {}
+      nLevelsAlloc(0), nLevels(-1), lockFreeRb(0) {}
 
     /* register a read request (during "register" phase) */
     void registerReadRequest(const char *lvl, const char *componentInstName=nullptr);
     void registerWriteRequest(const char *lvl, const char *componentInstName=nullptr);
 
+    /* registered read/write requests (level name and instance name of the reader/writer), n < getN*Requests() */
+    int getNReadRequests() { return (int)rrq.getNEl(); }
+    int getNWriteRequests() { return (int)wrq.getNEl(); }
+    const sDmLevelRWRequest * getReadRequest(int n) { return rrq.getElement(n); }
+    const sDmLevelRWRequest * getWriteRequest(int n) { return wrq.getElement(n); }
+
     /* register a new level, and check for uniqueness of name */
     int registerLevel(cDataMemoryLevel *l);
 
@@ -1649,8 +1735,8 @@ class  cDataMemory : public cSmileComponent {
          // for passing a buffer frame or so...
     cVector * getFrame(int _level, long vIdx, int special=-1, int rdId=-1, int *result=nullptr)
       { if ((_level>=0)&&(_level<=nLevels)) return level[_level]->getFrame(vIdx,special,rdId,result); else return nullptr; }
-    cMatrix * getMatrix(int _level, long vIdx, long vIdxEnd, int special=-1, int rdId=-1, int *result=nullptr)
-      { if ((_level>=0)&&(_level<=nLevels)) return level[_level]->getMatrix(vIdx,vIdxEnd,special,rdId,result); else return nullptr; }
+    cMatrix * getMatrix(int _level, long vIdx, long vIdxEnd, int special=-1, int rdId=-1, int *result=nullptr, cMatrix *mat=nullptr)
+      { if ((_level>=0)&&(_level<=nLevels)) return level[_level]->getMatrix(vIdx,vIdxEnd,special,rdId,result,mat); else return nullptr; }
 
     // set current read index to current write index to prevent hangs, if the readers do not read data sequentially, or if the readers skip data
     void catchupCurR(int _level, int rdId=-1, long _curR=-1 /* if >= 0, value that curR[rdId] will be set to! */ ) 
@@ -83,6 +83,8 @@ class  cDataReader : public cSmileComponent {
     cVector *V;
     // temporary matrix...
     cMatrix *m;
+    // per input level matrices, reused by getMatrix when reading from multiple levels
+    cMatrix **mLevel;
 
     /* reader parameters for sequential matrix reading */
     long stepM, lengthM;  /* parameters in frames */
@@ -50,6 +50,8 @@
 #include <core/smileCommon.hpp>
 #include <core/configManager.hpp>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #define COMPONENT_DESCRIPTION_XXXX  "example description"
 #define COMPONENT_NAME_XXXX         "exampleName"
@@ -379,6 +381,16 @@ class  cSmileComponent {
 
     long lastNrun_;   // the number of Nrun in the last tickloop?
 
+    // handles of the fields read by getInt/getDouble/getStr/getChar, keyed by the name pointer;
+    // the name itself is kept to detect reused pointers (e.g. freed myvprint buffers of the _f functions)
+    std::unordered_map<const char *, std::pair<std::string, ConfigField> > fieldCache_;
+    long fieldCacheChanges_;  // confman_->getNInstChanges() when the handles in fieldCache_ were resolved
+
+    // Value of field *name of our config instance through a cached handle, or nullptr if the handle
+    // cannot serve it (unknown field, no value, array): the callers then do the name lookup, which
+    // reports errors as before.
+    const ConfigValue * getCachedValue(const char *name);
+
   protected:
     SMILECOMPONENT_STATIC_DECL_PR
 
@@ -412,7 +424,7 @@ class  cSmileComponent {
 
     // Functions to get config values from the config manager from our config instance.
     // The _f functions internally free the string *name. Use these in conjunction with myvprint()...
-    // NOTE: Yes, this is ineffective. TODO: smile memory manager, and fixed length text buffer which can be reused (can also grow if needed).
+    // getInt/getDouble/getStr/getChar resolve the field once and then read through a cached ConfigField handle.
     void * getExternalPointer(const char *name) {
       if (confman_ != nullptr) {
         return confman_->getExternalPointer(name);
@@ -427,6 +439,8 @@ class  cSmileComponent {
     }
 
     double getDouble(const char*name) {
+      const ConfigValue *v = getCachedValue(name);
+      if (v != nullptr) return v->getDouble();
       return confman_->getDouble_f(myvprint("%s.%s",cfname_,name));
     }
     double getDouble_f(char*name) {
@@ -436,6 +450,8 @@ class  cSmileComponent {
     }
 
     int getInt(const char*name) {
+      const ConfigValue *v = getCachedValue(name);
+      if (v != nullptr) return v->getInt();
       return confman_->getInt_f(myvprint("%s.%s",cfname_,name));
     }
     int getInt_f(char*name) {
@@ -445,6 +461,8 @@ class  cSmileComponent {
     }
 
     const char *getStr(const char*name){
+      const ConfigValue *v = getCachedValue(name);
+      if (v != nullptr) return v->getStr();
       return confman_->getStr_f(myvprint("%s.%s",cfname_,name));
     }
     const char * getStr_f(char*name) {
@@ -454,6 +472,8 @@ class  cSmileComponent {
     }
 
     char getChar(const char*name) {
+      const ConfigValue *v = getCachedValue(name);
+      if (v != nullptr) return v->getChar();
       return confman_->getChar_f(myvprint("%s.%s",cfname_,name));
     }
     const char getChar_f(char*name) {
@@ -498,6 +518,12 @@ class  cSmileComponent {
       return s;
     }
 
+    // Resolves a field of our config instance once, reads through the returned handle need no name lookup
+    // (for values read repeatedly, e.g. per tick or for every file of a batch).
+    ConfigField getField(const char*name) {
+      return confman_->getField_f(myvprint("%s.%s",cfname_,name));
+    }
+
     // Returns 1 if we are in an abort state (user requested abort).
     int isAbort();
 
@@ -626,6 +652,7 @@ class  cSmileComponent {
     //  Pointer to config manager, component name and description
     virtual void setComponentInfo(cConfigManager *cm, const char *cname, const char *description) {
       confman_ = cm;
+      fieldCache_.clear();
       cname_= cname;
       description_ = description;
       if (cm != nullptr) fetchConfig();
@@ -643,6 +670,7 @@ class  cSmileComponent {
           cfname_ = nullptr;
         }
         cfname_ = strdup(cfname);
+        fieldCache_.clear();
       }
     }
 
@@ -84,6 +84,16 @@ Log Levels for Warnings:
 #define __SMILE_LOGGER_HPP
 
 #include <core/smileCommon.hpp>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <type_traits>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
 #ifdef __ANDROID__
 #include <android/log.h>
 #endif
@@ -95,10 +105,41 @@ Log Levels for Warnings:
 #define LOG_DEBUG   4
 #define LOG_PRINT   5
 
+#define LOG_RECORD_SIZE     480  // bytes for module name, format string and arguments of one deferred message
+#define LOG_RING_SIZE       128  // deferred messages per thread (power of 2)
+#define LOG_DRAIN_PERIOD_MS 50   // the drain thread formats pending messages at least this often
+
+/* a log message as it was passed to the logger: the format string and the raw arguments,
+   formatting is done later by the drain thread */
+struct sSmileLogRecord {
+  int type;
+  int level;
+  int instance;   // module is an instance name (printed as "instance '<module>'")
+  int len;        // bytes used in data
+  time_t time;
+  char data[LOG_RECORD_SIZE];  // module \0 format \0 arguments (type tag + value each)
+};
+
+/* deferred messages of one thread: single producer (the owning thread),
+   single consumer (whoever holds the logger's drain lock) */
+struct sSmileLogRing {
+  sSmileLogRecord rec[LOG_RING_SIZE];
+  std::atomic<unsigned int> head {0};  // next record written by the owner
+  std::atomic<unsigned int> tail {0};  // next record read by the drain
+  std::atomic<int> orphaned {0};       // owning thread has exited, free the ring once it is empty
+};
+
 #undef class
 class  cSmileLogger {
   private:
-    smileMutex logmsgMtx;
+    std::mutex logmsgMtx;    // serialises draining and all output (file and console)
+    std::mutex ringsMtx;     // guards the list of per-thread rings
+    std::condition_variable drainCv;
+    std::thread drainThread;
+    std::thread::id mainThread;  // the R console may only be written from this thread
+    int stopDrain;
+    std::vector<sSmileLogRing *> rings;
+
     char * logfile;
     FILE * logf;
     int stde;    // flag that indicates wheter stderr output is enabled or not
@@ -109,24 +150,77 @@ class  cSmileLogger {
     int ll_err;
     int ll_dbg;
 
-    char *msg;  // current log message
+    std::string msg;  // current log message
+
+    int deferConsole;  // if set, console output is collected in deferredConsole instead of being printed
+    std::string deferredConsole;  // console output not yet printed (always used off the main thread)
 
     void openLogfile(int append=0);
     void closeLogfile();
 
     // formating of log message, save result in msg
-    void fmtLogMsg(const char *type, char *t, int level, const char *m);
+    void fmtLogMsg(const char *type, const char *t, int level, const char *m, int instance);
 
-    // write a log message in *msg to current logfile (if open)
+    // write a log message in msg to current logfile (if open)
     // add a date- and timestamp to message
-    void writeMsgToFile(int pr=0);
+    void writeMsgToFile(time_t t, int pr=0);
 
-    // print message to console , without a timestamp
+    // queue message for the console, without a timestamp
     void printMsgToConsole();
+    // print queued console output, if called from the main thread and output is not deferred
+    void flushConsole();
+
+    // format and output one message (logmsgMtx must be held)
+    void outputMsg(int itype, const char *s, int level, const char *m, int instance, time_t t);
 
-    // main log message dispatcher
+    // main log message dispatcher for already formatted messages
     void logMsg(int itype, char *s, int level, const char *m);
 
+    // format all messages pending in the rings (logmsgMtx must be held)
+    void drainRings();
+    void drainLoop();
+
+    // ring of the calling thread, created on first use (nullptr if none can be used)
+    sSmileLogRing * threadRing();
+
+    int typeLevel(int itype) const {
+      switch (itype) {
+        case LOG_PRINT: case LOG_MESSAGE: return ll_msg;
+        case LOG_WARNING: return ll_wrn;
+        case LOG_ERROR: return ll_err;
+        case LOG_DEBUG: return ll_dbg;
+        default: return -1;
+      }
+    }
+
+    /* serialisation of format arguments into a record, returns 0 if the record is full */
+    enum { LOGARG_INT = 1, LOGARG_DBL, LOGARG_STR, LOGARG_PTR };
+    static int putBytes(sSmileLogRecord &r, const void *p, int n) {
+      if (r.len + n > LOG_RECORD_SIZE) return 0;
+      memcpy(r.data + r.len, p, n);
+      r.len += n;
+      return 1;
+    }
+    static int putStr(sSmileLogRecord &r, const char *s) {
+      if (s == nullptr) s = "(null)";
+      return putBytes(r, s, (int)strlen(s) + 1);
+    }
+    static int putTag(sSmileLogRecord &r, char tag) { return putBytes(r, &tag, 1); }
+    static int putArg(sSmileLogRecord &r, const char *s) { return putTag(r, LOGARG_STR) && putStr(r, s); }
+    static int putArg(sSmileLogRecord &r, char *s) { return putArg(r, (const char *)s); }
+    static int putArg(sSmileLogRecord &r, std::nullptr_t) { const void *p = nullptr; return putTag(r, LOGARG_PTR) && putBytes(r, &p, sizeof(p)); }
+    template <typename T>
+    static int putArg(sSmileLogRecord &r, T *p) { const void *v = p; return putTag(r, LOGARG_PTR) && putBytes(r, &v, sizeof(v)); }
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, int>::type
+    putArg(sSmileLogRecord &r, T v) { long long x = (long long)v; return putTag(r, LOGARG_INT) && putBytes(r, &x, sizeof(x)); }
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value, int>::type
+    putArg(sSmileLogRecord &r, T v) { double x = (double)v; return putTag(r, LOGARG_DBL) && putBytes(r, &x, sizeof(x)); }
+    static int putArgs(sSmileLogRecord &) { return 1; }
+    template <typename T, typename... Rest>
+    static int putArgs(sSmileLogRecord &r, T v, Rest... rest) { return putArg(r, v) && putArgs(r, rest...); }
+
   public:
     cSmileLogger(int _loglevel=0, const char *_logfile=nullptr, int _append=0);  // logfile == nullptr: output to stderr
                                                              // loglevel is the OVERALL loglevel
@@ -136,7 +230,7 @@ class  cSmileLogger {
     void setLogLevel(int level);
     void setLogLevel(int type, int level);
     void setLogFile(char *file, int _append = 0, int _stde=0);
-    void setLogFile(const char *file, int _append = 0, int _stde=0);
+    void setLogFile(const char *file, int _append = 0, int _stde=0);  // file == nullptr: close the current logfile
 
     int getLogLevel_msg() { return ll_msg; }
     int getLogLevel_wrn() { return ll_wrn; }
@@ -146,8 +240,48 @@ class  cSmileLogger {
     void enableLogPrint() { _enableLogPrint = 1; } // enable printing of 'print' messages to log file (they are by default only written to the console)
     void enableConsoleOutput() { stde=1; }    // enable printing of log messages to console, even if a logfile is specified
     void muteLogger() { silence=1; }  // surpress all log messages
+    // collect console output instead of printing it (e.g. while worker threads are logging,
+    // as the R console may only be written from the main thread); disabling prints collected messages
+    void setDeferConsoleOutput(int defer);
     void unmuteLogger() { silence=0; }  // back to normal logging
 
+    // format all pending messages now, and print the console output if called from the main thread
+    void flush();
+
+    /* log a message with printf style arguments: the arguments are copied to the ring of the
+       calling thread and formatted by the drain thread. Errors, and messages that do not fit
+       into a record, are formatted and written at once.
+       Strings are copied, so they need not stay valid; other pointers are kept for %p only. */
+    template <typename... Args>
+    void logFmt(int itype, int level, const char *module, int instance, const char *fmt, Args... args) {
+      if (silence || level > typeLevel(itype)) return;
+      if (itype != LOG_ERROR) {
+        sSmileLogRing *ring = threadRing();
+        if (ring != nullptr) {
+          unsigned int h = ring->head.load(std::memory_order_relaxed);
+          unsigned int used = h - ring->tail.load(std::memory_order_acquire);
+          if (used < LOG_RING_SIZE) {
+            sSmileLogRecord &r = ring->rec[h & (LOG_RING_SIZE-1)];
+            r.type = itype; r.level = level; r.instance = instance; r.len = 0;
+            time(&r.time);
+            if (putStr(r, module) && putStr(r, fmt) && putArgs(r, args...)) {
+              ring->head.store(h+1, std::memory_order_release);
+              if (used >= LOG_RING_SIZE/2) drainCv.notify_one();
+              return;
+            }
+          }
+        }
+      }
+      // synchronous path
+      char *s = myvprint(fmt, args...);
+      if (instance && module != nullptr) {
+        char *m = myvprint("instance '%s'", module);
+        logMsg(itype, s, level, m);
+        free(m);
+      } else {
+        logMsg(itype, s, level, module);
+      }
+    }
 
     /* similar to message, only that no formatting is performed and no extra information is printed
        the messages also do NOT go to the logfile by default (except, the enableLogPrint is set)
@@ -183,38 +317,23 @@ extern  cSmileLogger SMILE_LOG_GLOBAL;
 
 // The "I" logger functions (e.g. SMILE_IMSG) are meant to be used within cSmileComponent descendants. They will print the actual instance name instead of the component name
 #ifdef SMILE_LOG_GLOBAL
-#define SMILE_PRINT(...) SMILE_LOG_GLOBAL.print(FMT(__VA_ARGS__))
+#define SMILE_PRINT(...) SMILE_LOG_GLOBAL.logFmt(LOG_PRINT, 0, nullptr, 0, __VA_ARGS__)
 
-#define SMILE_PRINTL(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_msg()) SMILE_LOG_GLOBAL.print(FMT(__VA_ARGS__), level); }
+#define SMILE_PRINTL(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_msg()) SMILE_LOG_GLOBAL.logFmt(LOG_PRINT, level, nullptr, 0, __VA_ARGS__); }
 
-#define SMILE_MSG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_msg()) SMILE_LOG_GLOBAL.message(FMT(__VA_ARGS__), level, MODULE); }
+#define SMILE_MSG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_msg()) SMILE_LOG_GLOBAL.logFmt(LOG_MESSAGE, level, MODULE, 0, __VA_ARGS__); }
 
-#define SMILE_IMSG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_msg()) { char *__mm = FMT("instance '%s'",getInstName()); SMILE_LOG_GLOBAL.message(FMT(__VA_ARGS__), level, __mm); free(__mm); } }
+#define SMILE_IMSG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_msg()) SMILE_LOG_GLOBAL.logFmt(LOG_MESSAGE, level, getInstName(), 1, __VA_ARGS__); }
 
-#define SMILE_ERR(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_err()) SMILE_LOG_GLOBAL.error_smile(FMT(__VA_ARGS__), level, MODULE); }
-#define SMILE_IERR(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_err()) { char *__mm = FMT("instance '%s'",getInstName()); SMILE_LOG_GLOBAL.error_smile(FMT(__VA_ARGS__), level, __mm); free(__mm); } }
+#define SMILE_ERR(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_err()) SMILE_LOG_GLOBAL.logFmt(LOG_ERROR, level, MODULE, 0, __VA_ARGS__); }
+#define SMILE_IERR(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_err()) SMILE_LOG_GLOBAL.logFmt(LOG_ERROR, level, getInstName(), 1, __VA_ARGS__); }
 
-#define SMILE_WRN(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_wrn()) SMILE_LOG_GLOBAL.warning_smile(FMT(__VA_ARGS__), level, MODULE); }
-#define SMILE_IWRN(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_wrn()) { char *__mm = FMT("instance '%s'",getInstName()); SMILE_LOG_GLOBAL.warning_smile(FMT(__VA_ARGS__), level, __mm); free(__mm); } }
-
-/*
-#define SMILE_PRINTL(level,rest...) SMILE_LOG_GLOBAL.print(FMT(rest), level)
-#define SMILE_MSG(level, rest...) SMILE_LOG_GLOBAL.message(FMT(rest), level, MODULE)
-#define SMILE_IMSG(level, rest...) SMILE_LOG_GLOBAL.message(FMT(rest), level, FMT("instance '%s'",getInstName()))
-#define SMILE_ERR(level, rest...) SMILE_LOG_GLOBAL.error(FMT(rest), level, MODULE)
-#define SMILE_IERR(level, rest...) SMILE_LOG_GLOBAL.error(FMT(rest), level, FMT("instance '%s'",getInstName()))
-#define SMILE_WRN(level, rest...) SMILE_LOG_GLOBAL.warning(FMT(rest), level, MODULE)
-#define SMILE_IWRN(level, rest...) SMILE_LOG_GLOBAL.warning(FMT(rest), level, FMT("instance '%s'",getInstName()))
-*/
+#define SMILE_WRN(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_wrn()) SMILE_LOG_GLOBAL.logFmt(LOG_WARNING, level, MODULE, 0, __VA_ARGS__); }
+#define SMILE_IWRN(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_wrn()) SMILE_LOG_GLOBAL.logFmt(LOG_WARNING, level, getInstName(), 1, __VA_ARGS__); }
 
 #ifdef DEBUG
-#define SMILE_DBG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_dbg()) SMILE_LOG_GLOBAL.debug(FMT(__VA_ARGS__), level, MODULE); }
-#define SMILE_IDBG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_dbg()) { char *__mm = FMT("instance '%s'",getInstName()); SMILE_LOG_GLOBAL.debug(FMT(__VA_ARGS__), level, __mm); free(__mm); } }
-
-/*
-#define SMILE_DBG(level, rest...) SMILE_LOG_GLOBAL.debug(FMT(rest), level, MODULE)
-#define SMILE_IDBG(level, rest...) SMILE_LOG_GLOBAL.debug(FMT(rest), level, FMT("instance '%s'",getInstName()))
-*/
+#define SMILE_DBG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_dbg()) SMILE_LOG_GLOBAL.logFmt(LOG_DEBUG, level, MODULE, 0, __VA_ARGS__); }
+#define SMILE_IDBG(level, ...) { if (level <= SMILE_LOG_GLOBAL.getLogLevel_dbg()) SMILE_LOG_GLOBAL.logFmt(LOG_DEBUG, level, getInstName(), 1, __VA_ARGS__); }
 
 #else
 #define SMILE_DBG(level, ...)
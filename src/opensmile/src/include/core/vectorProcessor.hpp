@@ -63,12 +63,19 @@ vector Processor :  (abstract class only)
 #define COMPONENT_DESCRIPTION_CVECTORPROCESSOR "dataProcessor, where each array field is processed individually as a vector"
 #define COMPONENT_NAME_CVECTORPROCESSOR "cVectorProcessor"
 
+// return value of processVectorFloatBlock if the block is to be processed frame by frame
+#define VECTORPROCESSOR_BLOCK_NOT_HANDLED  -2
+
 #undef class
 class  cVectorProcessor : public cDataProcessor {
   private:
     long Nfi, Nfo, Ni, No;
     long *fNi, *fNo;
     cVector * vecO;
+    long blockFrames;
+    cMatrix * blockIn;
+    cMatrix * blockOut;
+    int * blockRes;  // result of each frame of the block, see processBlock
 
     int includeSingleElementFields;
 	  int processArrayFields;
@@ -79,12 +86,17 @@ class  cVectorProcessor : public cDataProcessor {
     long *confBs;  // blocksize for configurations
 
     int addFconf(long bs, int field); // return value is index of assigned configuration
+    int processBlock();
 
   protected:
     SMILECOMPONENT_STATIC_DECL_PR
 
     int getProcessArrayFields() { return processArrayFields; }
 
+    /* read and process up to n frames per tick (n > 1), the fields of all frames are passed
+       to processVectorFloatBlock at once. Only for components which do not use customVecProcess. */
+    void setBlockFrames(long n) { blockFrames = n; }
+
     /*
       since a vector processor can process individual fields of a vector seperately,
       these fields might require different configuration and thus different internal variables/parameters.
@@ -159,6 +171,11 @@ class  cVectorProcessor : public cDataProcessor {
        to processVectorX and processVectorX is only called once per vector (idxi = 0)*/
     virtual int processVectorInt(const INT_DMEM *src, INT_DMEM *dst, long Nsrc, long Ndst, int idxi);
     virtual int processVectorFloat(const FLOAT_DMEM *src, FLOAT_DMEM *dst, long Nsrc, long Ndst, int idxi);
+    /* block variant of processVectorFloat (see setBlockFrames): field idxi of frame f is at src + f*srcStride
+       and dst + f*dstStride. The return value is that of processVectorFloat for all frames of the block,
+       return VECTORPROCESSOR_BLOCK_NOT_HANDLED to have processVectorFloat called for each frame instead */
+    virtual int processVectorFloatBlock(const FLOAT_DMEM *, long, FLOAT_DMEM *, long,
+                                        long, long, long, int) { return VECTORPROCESSOR_BLOCK_NOT_HANDLED; }
 
     /* these methods are called at the end of processing (end-of-input) to allow the component
        to flush data, save final results to files, etc. 
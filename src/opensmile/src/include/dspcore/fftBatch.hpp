@@ -0,0 +1,111 @@
+/*F***************************************************************************
+ * 
+ * openSMILE - the Munich open source Multimedia Interpretation by 
+ * Large-scale Extraction toolkit
+ * 
+ * This file is part of openSMILE.
+ * 
+ * openSMILE is copyright (c) by audEERING GmbH. All rights reserved.
+ * 
+ * See file "COPYING" for details on usage rights and licensing terms.
+ * By using, copying, editing, compiling, modifying, reading, etc. this
+ * file, you agree to the licensing terms in the file COPYING.
+ * If you do not agree to the licensing terms,
+ * you must immediately destroy all copies of this file.
+ * 
+ * THIS SOFTWARE COMES "AS IS", WITH NO WARRANTIES. THIS MEANS NO EXPRESS,
+ * IMPLIED OR STATUTORY WARRANTY, INCLUDING WITHOUT LIMITATION, WARRANTIES OF
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ANY WARRANTY AGAINST
+ * INTERFERENCE WITH YOUR ENJOYMENT OF THE SOFTWARE OR ANY WARRANTY OF TITLE
+ * OR NON-INFRINGEMENT. THERE IS NO WARRANTY THAT THIS SOFTWARE WILL FULFILL
+ * ANY OF YOUR PARTICULAR PURPOSES OR NEEDS. ALSO, YOU MUST PASS THIS
+ * DISCLAIMER ON WHENEVER YOU DISTRIBUTE THE SOFTWARE OR DERIVATIVE WORKS.
+ * NEITHER TUM NOR ANY CONTRIBUTOR TO THE SOFTWARE WILL BE LIABLE FOR ANY
+ * DAMAGES RELATED TO THE SOFTWARE OR THIS LICENSE AGREEMENT, INCLUDING
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL OR INCIDENTAL DAMAGES, TO THE
+ * MAXIMUM EXTENT THE LAW PERMITS, NO MATTER WHAT LEGAL THEORY IT IS BASED ON.
+ * ALSO, YOU MUST PASS THIS LIMITATION OF LIABILITY ON WHENEVER YOU DISTRIBUTE
+ * THE SOFTWARE OR DERIVATIVE WORKS.
+ * 
+ * Main authors: Florian Eyben, Felix Weninger, 
+ * 	      Martin Woellmer, Bjoern Schuller
+ * 
+ * Copyright (c) 2008-2013, 
+ *   Institute for Human-Machine Communication,
+ *   Technische Universitaet Muenchen, Germany
+ * 
+ * Copyright (c) 2013-2015, 
+ *   audEERING UG (haftungsbeschraenkt),
+ *   Gilching, Germany
+ * 
+ * Copyright (c) 2016,	 
+ *   audEERING GmbH,
+ *   Gilching Germany
+ ***************************************************************************E*/
+
+
+/*  openSMILE batched real FFT
+
+real FFT of a block of frames at once: the frames are transformed side by side,
+one frame per SIMD lane (structure of arrays), with an iterative radix-4 complex FFT
+of half size and a final split step. Twiddle and bit reversal tables are computed
+once per transform size and shared by all users of that size.
+Input and output follow the layout of rdft() in fftsg.c.
+
+*/
+
+
+#ifndef __FFT_BATCH_HPP
+#define __FFT_BATCH_HPP
+
+#include <core/smileCommon.hpp>
+#include <memory>
+#include <vector>
+
+/* tables for a real FFT of size n, see cFftBatchPlan::get() */
+class cFftBatchPlan {
+  public:
+    long n;         // real transform size (power of 2, >= 4)
+    long m;         // complex transform size n/2
+    int log2m;
+    std::vector<long> bitrev;      // bit reversal permutation of 0..m-1
+    std::vector<double> wr, wi;    // complex FFT twiddles e^(-2 pi i j/m), j=0..m-1
+    std::vector<double> rr, ri;    // split twiddles e^(-2 pi i k/n), k=0..m-1
+    std::vector<float> wrf, wif, rrf, rif;  // single precision copies
+
+    explicit cFftBatchPlan(long _n);
+
+    // the plan for size n, created on first use and freed when its last user is gone
+    static std::shared_ptr<const cFftBatchPlan> get(long n);
+};
+
+class cFftBatch {
+  private:
+    std::shared_ptr<const cFftBatchPlan> plan;
+    int singlePrecision;
+    std::vector<double> workD;
+    std::vector<float> workF;
+
+  public:
+    // n must be a power of 2 (>= 4, see isSupportedSize), else a cComponentException is thrown;
+    // singlePrecision = 1 computes in float (twice the lanes), else in double
+    cFftBatch(long n, int _singlePrecision=0);
+
+    // 1 if transforms of size n can be computed (n is a power of 2 >= 4)
+    static int isSupportedSize(long n) { return (n >= 4) && ((n & (n - 1)) == 0); }
+
+    long getSize() const { return plan->n; }
+    int isSinglePrecision() const { return singlePrecision; }
+
+    /* forward transform (as rdft(n, 1, ...)) of nFrames frames: frame f has nSrc values at
+       src + f*srcStride, which are placed at offset padLeft of an otherwise zero frame of size n.
+       The n output values of frame f are written to dst + f*dstStride */
+    void forward(const FLOAT_DMEM *src, long srcStride, long nSrc, long padLeft,
+                 FLOAT_DMEM *dst, long dstStride, long nFrames);
+
+    /* inverse transform (as rdft(n, -1, ...)) of nFrames frames of n values, multiplied by scale */
+    void inverse(const FLOAT_DMEM *src, long srcStride,
+                 FLOAT_DMEM *dst, long dstStride, long nFrames, FLOAT_DMEM scale);
+};
+
+#endif // __FFT_BATCH_HPP
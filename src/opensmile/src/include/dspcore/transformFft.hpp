@@ -58,6 +58,7 @@ output: complex values of fft or real signal values (for iFFT)
 #include <core/smileCommon.hpp>
 #include <core/vectorProcessor.hpp>
 #include <dspcore/fftXg.h>
+#include <dspcore/fftBatch.hpp>
 
 #define COMPONENT_DESCRIPTION_CTRANSFORMFFT "This component performs an FFT on a sequence of real values (one frame), the output is the complex domain result of the transform. Use the cFFTmagphase component to compute magnitudes and phases from the complex output."
 #define COMPONENT_NAME_CTRANSFORMFFT "cTransformFFT"
@@ -72,12 +73,16 @@ class  cTransformFFT : public cVectorProcessor {
     int newFsSet_;
     double frameSizeSecOut_;
     int zeroPadSymmetric_;
+    int batchFrames_;
+    int batchSinglePrecision_;
+    cFftBatch **batch_;
 
     // generate "frequency axis information", i.e. the frequency in Hz for each spectral bin
     // which is to be saved as meta-data in the dataMemory level field (FrameMetaInfo->FieldMetaInfo->info)
     // &infosize is initialized with the number of fft bins x 2 (= number of input samples)
     //   and should contain the number of complex bins at the end of this function
     void * generateSpectralVectorInfo(long &infosize);
+    void freeBatch();
 
   protected:
     SMILECOMPONENT_STATIC_DECL_PR
@@ -88,6 +93,8 @@ class  cTransformFFT : public cVectorProcessor {
     virtual int configureWriter(sDmLevelConfig &c);
     virtual int setupNamesForField(int i, const char*name, long nEl);
     virtual int processVectorFloat(const FLOAT_DMEM *src, FLOAT_DMEM *dst, long Nsrc, long Ndst, int idxi);
+    virtual int processVectorFloatBlock(const FLOAT_DMEM *src, long srcStride, FLOAT_DMEM *dst, long dstStride,
+                                        long nFrames, long Nsrc, long Ndst, int idxi);
 
 
   public:
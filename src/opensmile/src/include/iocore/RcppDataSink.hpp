@@ -63,7 +63,8 @@ Rcpp Data output
 
 #undef class
 
-typedef void (*SetWaveFeaturesCB_Ptr)(void *, const arma::rowvec &, const arma::rowvec & );
+//frame of nFeatures values (the dataF of the input vector, not copied) and its time in seconds
+typedef void (*SetWaveFeaturesCB_Ptr)(void *, const FLOAT_DMEM *, long nFeatures, double time);
 
 class  cRcppDataSink : public cDataSink {
   private:
@@ -0,0 +1,119 @@
+/*F***************************************************************************
+ * 
+ * openSMILE - the Munich open source Multimedia Interpretation by 
+ * Large-scale Extraction toolkit
+ * 
+ * This file is part of openSMILE.
+ * 
+ * openSMILE is copyright (c) by audEERING GmbH. All rights reserved.
+ * 
+ * See file "COPYING" for details on usage rights and licensing terms.
+ * By using, copying, editing, compiling, modifying, reading, etc. this
+ * file, you agree to the licensing terms in the file COPYING.
+ * If you do not agree to the licensing terms,
+ * you must immediately destroy all copies of this file.
+ * 
+ * THIS SOFTWARE COMES "AS IS", WITH NO WARRANTIES. THIS MEANS NO EXPRESS,
+ * IMPLIED OR STATUTORY WARRANTY, INCLUDING WITHOUT LIMITATION, WARRANTIES OF
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ANY WARRANTY AGAINST
+ * INTERFERENCE WITH YOUR ENJOYMENT OF THE SOFTWARE OR ANY WARRANTY OF TITLE
+ * OR NON-INFRINGEMENT. THERE IS NO WARRANTY THAT THIS SOFTWARE WILL FULFILL
+ * ANY OF YOUR PARTICULAR PURPOSES OR NEEDS. ALSO, YOU MUST PASS THIS
+ * DISCLAIMER ON WHENEVER YOU DISTRIBUTE THE SOFTWARE OR DERIVATIVE WORKS.
+ * NEITHER TUM NOR ANY CONTRIBUTOR TO THE SOFTWARE WILL BE LIABLE FOR ANY
+ * DAMAGES RELATED TO THE SOFTWARE OR THIS LICENSE AGREEMENT, INCLUDING
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL OR INCIDENTAL DAMAGES, TO THE
+ * MAXIMUM EXTENT THE LAW PERMITS, NO MATTER WHAT LEGAL THEORY IT IS BASED ON.
+ * ALSO, YOU MUST PASS THIS LIMITATION OF LIABILITY ON WHENEVER YOU DISTRIBUTE
+ * THE SOFTWARE OR DERIVATIVE WORKS.
+ * 
+ * Main authors: Florian Eyben, Felix Weninger, 
+ * 	      Martin Woellmer, Bjoern Schuller
+ * 
+ * Copyright (c) 2008-2013, 
+ *   Institute for Human-Machine Communication,
+ *   Technische Universitaet Muenchen, Germany
+ * 
+ * Copyright (c) 2013-2015, 
+ *   audEERING UG (haftungsbeschraenkt),
+ *   Gilching, Germany
+ * 
+ * Copyright (c) 2016,	 
+ *   audEERING GmbH,
+ *   Gilching Germany
+ ***************************************************************************E*/
+
+
+
+/*  openSMILE component:
+
+mp3Source : decodes MP3 files with the bundled mpglib (hip_decode1_headers) 
+            and streams the samples to the data memory, one mp3 frame at a time
+
+*/
+
+
+#ifndef __MP3_SOURCE_HPP
+#define __MP3_SOURCE_HPP
+
+#include <core/smileCommon.hpp>
+#include <core/dataSource.hpp>
+#include <iocore/waveSource.hpp>
+
+#ifdef HAVE_MPGLIB
+
+#include "lame.h"
+
+#define COMPONENT_DESCRIPTION_CMP3SOURCE "This component decodes an MP3 file incrementally and saves it as a stream to the data memory (no intermediate wave file). For most feature extraction tasks you will now require a cFramer component."
+#define COMPONENT_NAME_CMP3SOURCE "cMp3Source"
+
+#undef class
+
+class  cMp3Source : public cDataSource {
+  private:
+    const char *filename;
+    FILE *filehandle;
+    hip_t hip;
+    sWaveParameters pcmParam;
+
+    int monoMixdown;    // if set to 1, stereo files will be mixed down to 1 channel
+    long curReadPos;    // in samples
+    int eof;
+    const char *outFieldName;
+
+    // compressed input passed to the decoder, the decoder buffers what it has not consumed yet
+    unsigned char *mp3Buf;
+    long mp3BufLen;
+    // samples of the last decoded mp3 frame which have not been written yet
+    short *pcmL, *pcmR;
+    long pcmStart, pcmEnd;
+
+    // decode the next mp3 frame to pcmL/pcmR, return the number of samples, 0 at the end of the file, -1 on error
+    int decodeFrame(mp3data_struct *mp3data);
+    int readMp3Header();
+
+  protected:
+    SetWaveHeaderCB_Ptr setWaveHeaderCB;
+    SetWaveSamplesCB_Ptr setWaveSamplesCB;
+    SMILECOMPONENT_STATIC_DECL_PR
+    
+    virtual void fetchConfig();
+    virtual int myConfigureInstance();
+    virtual int myTick(long long t);
+
+    virtual int configureWriter(sDmLevelConfig &c);
+    virtual int setupNewNames(long nEl);
+
+  public:
+    SMILECOMPONENT_STATIC_DECL
+    
+    cMp3Source(const char *_name);
+    void connectSetWaveHeaderCB(SetWaveHeaderCB_Ptr setWaveHeaderCB_);
+    void connectSetWaveSamplesCB(SetWaveSamplesCB_Ptr setWaveSamplesCB_);
+
+    virtual ~cMp3Source();
+};
+
+#endif // HAVE_MPGLIB
+
+#endif // __MP3_SOURCE_HPP
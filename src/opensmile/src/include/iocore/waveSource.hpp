@@ -85,6 +85,8 @@ typedef struct {
 #undef class
 
 typedef void (*SetWaveHeaderCB_Ptr)(void *, const sWaveParameters &);
+// samples as read from the file (interleaved, nChan per frame, after monoMixdown), in [-1;+1]
+typedef void (*SetWaveSamplesCB_Ptr)(void *, const FLOAT_DMEM *, long nFrames, long nChan);
 
 class  cWaveSource : public cDataSource {
   private:
@@ -92,6 +94,11 @@ class  cWaveSource : public cDataSource {
     //long buffersize;
     FILE *filehandle;
     sWaveParameters pcmParam;
+    sSmilePcmReadBuffer pcmReadBuf;  // raw sample data of the last read, reused by every readData()
+#if FLOAT_DMEM_NUM != FLOAT_DMEM_FLOAT
+    float *convBuf;     // converted samples before they are copied to the matrix
+    long convBufSize;
+#endif
 
     int properTimestamps_;
     int negativestart;
@@ -110,6 +117,7 @@ class  cWaveSource : public cDataSource {
       
   protected:
     SetWaveHeaderCB_Ptr setWaveHeaderCB;    
+    SetWaveSamplesCB_Ptr setWaveSamplesCB;
     SMILECOMPONENT_STATIC_DECL_PR
     
     virtual void fetchConfig();
@@ -125,6 +133,7 @@ class  cWaveSource : public cDataSource {
     
     cWaveSource(const char *_name);
     void connectSetWaveHeaderCB(SetWaveHeaderCB_Ptr setWaveHeaderCB_);
+    void connectSetWaveSamplesCB(SetWaveSamplesCB_Ptr setWaveSamplesCB_);
 
     virtual ~cWaveSource();
 };
@@ -0,0 +1,108 @@
+/*F***************************************************************************
+ * 
+ * openSMILE - the Munich open source Multimedia Interpretation by 
+ * Large-scale Extraction toolkit
+ * 
+ * This file is part of openSMILE.
+ * 
+ * openSMILE is copyright (c) by audEERING GmbH. All rights reserved.
+ * 
+ * See file "COPYING" for details on usage rights and licensing terms.
+ * By using, copying, editing, compiling, modifying, reading, etc. this
+ * file, you agree to the licensing terms in the file COPYING.
+ * If you do not agree to the licensing terms,
+ * you must immediately destroy all copies of this file.
+ * 
+ * THIS SOFTWARE COMES "AS IS", WITH NO WARRANTIES. THIS MEANS NO EXPRESS,
+ * IMPLIED OR STATUTORY WARRANTY, INCLUDING WITHOUT LIMITATION, WARRANTIES OF
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ANY WARRANTY AGAINST
+ * INTERFERENCE WITH YOUR ENJOYMENT OF THE SOFTWARE OR ANY WARRANTY OF TITLE
+ * OR NON-INFRINGEMENT. THERE IS NO WARRANTY THAT THIS SOFTWARE WILL FULFILL
+ * ANY OF YOUR PARTICULAR PURPOSES OR NEEDS. ALSO, YOU MUST PASS THIS
+ * DISCLAIMER ON WHENEVER YOU DISTRIBUTE THE SOFTWARE OR DERIVATIVE WORKS.
+ * NEITHER TUM NOR ANY CONTRIBUTOR TO THE SOFTWARE WILL BE LIABLE FOR ANY
+ * DAMAGES RELATED TO THE SOFTWARE OR THIS LICENSE AGREEMENT, INCLUDING
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL OR INCIDENTAL DAMAGES, TO THE
+ * MAXIMUM EXTENT THE LAW PERMITS, NO MATTER WHAT LEGAL THEORY IT IS BASED ON.
+ * ALSO, YOU MUST PASS THIS LIMITATION OF LIABILITY ON WHENEVER YOU DISTRIBUTE
+ * THE SOFTWARE OR DERIVATIVE WORKS.
+ * 
+ * Main authors: Florian Eyben, Felix Weninger, 
+ * 	      Martin Woellmer, Bjoern Schuller
+ * 
+ * Copyright (c) 2008-2013, 
+ *   Institute for Human-Machine Communication,
+ *   Technische Universitaet Muenchen, Germany
+ * 
+ * Copyright (c) 2013-2015, 
+ *   audEERING UG (haftungsbeschraenkt),
+ *   Gilching, Germany
+ * 
+ * Copyright (c) 2016,	 
+ *   audEERING GmbH,
+ *   Gilching Germany
+ ***************************************************************************E*/
+
+
+/*  smilePcmConvert
+    ===============
+
+conversion of raw PCM samples to float samples in [-1;+1]
+for the interleaved (as stored), deinterleaved (one array per channel)
+and mono mixdown (mean of all channels) layouts.
+
+The kernels use SSE2 where the compiler targets it, and AVX2 if the cpu
+supports it at runtime (gcc/clang on x86), with a scalar fallback.
+All variants produce the same values as the scalar code.
+Mixdown and deinterleaving are vectorised for stereo data only, the SSE2
+kernels do not handle the 8-bit and packed 24-bit formats.
+
+*/
+
+#ifndef __SMILE_PCM_CONVERT_H
+#define __SMILE_PCM_CONVERT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* raw sample formats */
+#define SMILEPCM_UNKNOWN  0
+#define SMILEPCM_S8       1   // 8-bit signed int
+#define SMILEPCM_S16      2   // 16-bit signed int, little endian
+#define SMILEPCM_S24      3   // 24-bit signed int, 3 bytes packed, little endian
+#define SMILEPCM_S24IN32  4   // 24-bit signed int in the upper 3 bytes of a 32-bit word
+#define SMILEPCM_S32      5   // 32-bit signed int
+#define SMILEPCM_F32      6   // 32-bit IEEE float
+
+/* instruction set levels of the conversion kernels */
+#define SMILEPCM_SIMD_NONE  0   // scalar code only
+#define SMILEPCM_SIMD_SSE2  1
+#define SMILEPCM_SIMD_AVX2  2
+
+/* limits the kernels to the given level (e.g. SMILEPCM_SIMD_NONE to compare with the scalar code),
+   returns the previous limit. Not to be called while other threads convert samples. */
+int smilePcm_setSimdLevel(int level);
+
+/* level of the kernels used with the current limit, on this cpu */
+int smilePcm_simdLevel(void);
+
+/* bytes per sample of format fmt (0 for an unknown format) */
+int smilePcm_formatBytes(int fmt);
+
+/* converts n samples from src to dst, the layout is kept (n = frames * channels for interleaved data) */
+void smilePcm_convertInterleaved(const uint8_t *src, int fmt, float *dst, long n);
+
+/* converts nFrames frames of nChan interleaved channels to the nChan arrays dst[0..nChan-1] */
+void smilePcm_convertDeinterleaved(const uint8_t *src, int fmt, int nChan, float **dst, long nFrames);
+
+/* converts nFrames frames of nChan interleaved channels to their mean, one value per frame in dst */
+void smilePcm_convertMixdown(const uint8_t *src, int fmt, int nChan, float *dst, long nFrames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SMILE_PCM_CONVERT_H
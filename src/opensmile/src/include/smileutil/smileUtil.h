@@ -713,6 +713,9 @@ typedef struct {
 /* parse a wave header from a wave file in memory */
  int smilePcm_parseWaveHeader(void *raw, long long N, sWaveParameters *pcmParam);
 
+/* sample format (SMILEPCM_*, see smilePcmConvert.h) of the wave data described by pcmParam */
+ int smilePcm_sampleFormat(const sWaveParameters *pcmParam);
+
 // Convert samples from binary buffer to float array, given the wave parameters
 //  *buf : the raw PCM data buffer
   //  *pcmParam : parameter struct specifying the sample format
@@ -734,6 +737,17 @@ typedef struct {
 */
  int smilePcm_readSamples(FILE **filehandle, sWaveParameters *pcmParam, float *a, int nChan, int nSamples, int monoMixdown);
 
+/* raw data buffer for smilePcm_readSamplesBuffered, kept by the reader between calls
+   (initialise with { NULL, 0 }, release with smilePcm_freeReadBuffer) */
+typedef struct {
+  uint8_t *raw;
+  int size;     // allocated bytes in raw
+} sSmilePcmReadBuffer;
+
+/* as smilePcm_readSamples, but the raw data is read into *rb, which is only grown when needed */
+ int smilePcm_readSamplesBuffered(FILE **filehandle, sWaveParameters *pcmParam, float *a, int nChan, int nSamples, int monoMixdown, sSmilePcmReadBuffer *rb);
+ void smilePcm_freeReadBuffer(sSmilePcmReadBuffer *rb);
+
 
 /*******************************************************************************************
  *******************=====   Vector save/load debug helpers   ===== *************************
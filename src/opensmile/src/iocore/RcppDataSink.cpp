@@ -186,15 +186,8 @@ int cRcppDataSink::myTick(long long t)
   {
     return 0;
   }
-  arma::rowvec row(vec->N);
-  for (int i=0; i<vec->N; i++)
-  {
-    row(i) = static_cast<double>(vec->dataF[i]);
-  }
-  arma::rowvec time_vec(1);
-  time_vec(0) = vec->tmeta->time;
   if(nullptr != setWaveFeaturesCB)
-    setWaveFeaturesCB(getCompMan(), row, time_vec);
+    setWaveFeaturesCB(getCompMan(), vec->dataF, vec->N, vec->tmeta->time);
   //long vi = vec->tmeta->vIdx;
   //double tm = vec->tmeta->time;
 //  if (prname == 1) {
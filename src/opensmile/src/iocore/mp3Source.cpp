@@ -0,0 +1,308 @@
+/*F***************************************************************************
+ * 
+ * openSMILE - the Munich open source Multimedia Interpretation by 
+ * Large-scale Extraction toolkit
+ * 
+ * This file is part of openSMILE.
+ * 
+ * openSMILE is copyright (c) by audEERING GmbH. All rights reserved.
+ * 
+ * See file "COPYING" for details on usage rights and licensing terms.
+ * By using, copying, editing, compiling, modifying, reading, etc. this
+ * file, you agree to the licensing terms in the file COPYING.
+ * If you do not agree to the licensing terms,
+ * you must immediately destroy all copies of this file.
+ * 
+ * THIS SOFTWARE COMES "AS IS", WITH NO WARRANTIES. THIS MEANS NO EXPRESS,
+ * IMPLIED OR STATUTORY WARRANTY, INCLUDING WITHOUT LIMITATION, WARRANTIES OF
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ANY WARRANTY AGAINST
+ * INTERFERENCE WITH YOUR ENJOYMENT OF THE SOFTWARE OR ANY WARRANTY OF TITLE
+ * OR NON-INFRINGEMENT. THERE IS NO WARRANTY THAT THIS SOFTWARE WILL FULFILL
+ * ANY OF YOUR PARTICULAR PURPOSES OR NEEDS. ALSO, YOU MUST PASS THIS
+ * DISCLAIMER ON WHENEVER YOU DISTRIBUTE THE SOFTWARE OR DERIVATIVE WORKS.
+ * NEITHER TUM NOR ANY CONTRIBUTOR TO THE SOFTWARE WILL BE LIABLE FOR ANY
+ * DAMAGES RELATED TO THE SOFTWARE OR THIS LICENSE AGREEMENT, INCLUDING
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL OR INCIDENTAL DAMAGES, TO THE
+ * MAXIMUM EXTENT THE LAW PERMITS, NO MATTER WHAT LEGAL THEORY IT IS BASED ON.
+ * ALSO, YOU MUST PASS THIS LIMITATION OF LIABILITY ON WHENEVER YOU DISTRIBUTE
+ * THE SOFTWARE OR DERIVATIVE WORKS.
+ * 
+ * Main authors: Florian Eyben, Felix Weninger, 
+ * 	      Martin Woellmer, Bjoern Schuller
+ * 
+ * Copyright (c) 2008-2013, 
+ *   Institute for Human-Machine Communication,
+ *   Technische Universitaet Muenchen, Germany
+ * 
+ * Copyright (c) 2013-2015, 
+ *   audEERING UG (haftungsbeschraenkt),
+ *   Gilching, Germany
+ * 
+ * Copyright (c) 2016,	 
+ *   audEERING GmbH,
+ *   Gilching Germany
+ ***************************************************************************E*/
+
+/*  openSMILE component:
+
+mp3Source : decodes MP3 files with the bundled mpglib (hip_decode1_headers) 
+            and streams the samples to the data memory, one mp3 frame at a time
+
+The decoded pcm data is never held completely in memory, only the compressed
+read buffer and the samples of the current mp3 frame are kept.
+*/
+
+
+#include <iocore/mp3Source.hpp>
+
+#ifdef HAVE_MPGLIB
+
+#include "id3.h"
+#include "io_win32.h"
+#include "utils_global.h"
+#define MODULE "cMp3Source"
+
+// size of the compressed read buffer and of the decoded sample buffers (one mp3 frame has at most 1152 samples)
+#define MP3SOURCE_BUFSIZE 4096
+
+SMILECOMPONENT_STATICS(cMp3Source)
+
+SMILECOMPONENT_REGCOMP(cMp3Source)
+{
+  SMILECOMPONENT_REGCOMP_INIT
+  scname = COMPONENT_NAME_CMP3SOURCE;
+  sdescription = COMPONENT_DESCRIPTION_CMP3SOURCE;
+
+  // we inherit cDataSource configType and extend it:
+  SMILECOMPONENT_INHERIT_CONFIGTYPE("cDataSource")
+  
+  SMILECOMPONENT_IFNOTREGAGAIN(
+    ct->makeMandatory(ct->setField("filename","The filename of the MP3 file to load (MPEG 1/2/2.5 layer III).","input.mp3"));
+    ct->setField("monoMixdown","Mix down all channels to 1 mono channel (1=on, 0=off)",1);
+    ct->setField("outFieldName", "Set the name of the output field, containing the pcm data", "pcm");
+    // overwrite cDataSource's default:
+    ct->setField("blocksize_sec", nullptr , 1.0);
+  )
+
+  SMILECOMPONENT_MAKEINFO(cMp3Source);
+}
+
+SMILECOMPONENT_CREATE(cMp3Source)
+
+//-----
+
+cMp3Source::cMp3Source(const char *_name) :
+  cDataSource(_name),
+  filename(nullptr),
+  filehandle(nullptr),
+  hip(nullptr),
+  monoMixdown(0),
+  curReadPos(0),
+  eof(0),
+  outFieldName(nullptr),
+  mp3Buf(nullptr),
+  mp3BufLen(0),
+  pcmL(nullptr), pcmR(nullptr),
+  pcmStart(0), pcmEnd(0),
+  setWaveHeaderCB(nullptr),
+  setWaveSamplesCB(nullptr)
+{
+  memset(&pcmParam, 0, sizeof(pcmParam));
+}
+
+void cMp3Source::connectSetWaveHeaderCB(SetWaveHeaderCB_Ptr setWaveHeaderCB_)
+{
+  setWaveHeaderCB = setWaveHeaderCB_;
+}
+
+void cMp3Source::connectSetWaveSamplesCB(SetWaveSamplesCB_Ptr setWaveSamplesCB_)
+{
+  setWaveSamplesCB = setWaveSamplesCB_;
+}
+
+void cMp3Source::fetchConfig()
+{
+  cDataSource::fetchConfig();
+  
+  filename = getStr("filename");
+  SMILE_IDBG(2,"filename = '%s'",filename);
+  if (filename == nullptr) COMP_ERR("fetchConfig: getStr(filename) returned nullptr! missing option in config file?");
+
+  monoMixdown = getInt("monoMixdown");
+  if (monoMixdown) { SMILE_IDBG(2,"monoMixdown enabled!"); }
+
+  outFieldName = getStr("outFieldName");
+  if (outFieldName == nullptr) COMP_ERR("fetchConfig: getStr(outFieldName) returned nullptr! missing option in config file?");
+}
+
+int cMp3Source::decodeFrame(mp3data_struct *mp3data)
+{
+  while (1) {
+    // the decoder keeps the input it has not consumed yet, so new data is passed only once
+    int n = hip_decode1_headers(hip, mp3Buf, mp3BufLen, pcmL, pcmR, mp3data);
+    mp3BufLen = 0;
+    if (n != 0) return n;
+    if (feof(filehandle)) return 0;
+    mp3BufLen = (long)fread(mp3Buf, sizeof(unsigned char), MP3SOURCE_BUFSIZE, filehandle);
+    if (ferror(filehandle)) {
+      SMILE_IERR(1,"error reading from mp3 file '%s'",filename);
+      return -1;
+    }
+    if (mp3BufLen == 0) return 0;
+  }
+}
+
+int cMp3Source::readMp3Header()
+{
+  // skip an ID3v2 tag in front of the first mp3 frame
+  long id3Size = 0;
+  {
+    ID3 tag(filename);
+    id3Size = tag.size();
+  }
+  if (id3Size > 0 && fseek(filehandle, id3Size, SEEK_SET) != 0) return 0;
+
+  mp3data_struct mp3data;
+  memset(&mp3data, 0, sizeof(mp3data));
+  // samples are only returned once the first header was parsed,
+  // the samples of this frame stay in the buffer for the first tick
+  int n = decodeFrame(&mp3data);
+  if (n <= 0 || !mp3data.header_parsed) return 0;
+  pcmStart = 0;
+  pcmEnd = n;
+
+  pcmParam.sampleRate = mp3data.samplerate;
+  pcmParam.nChan = mp3data.stereo;
+  pcmParam.nBits = 16;
+  pcmParam.nBPS = 2;
+  pcmParam.blockSize = pcmParam.nChan * pcmParam.nBPS;
+  pcmParam.audioFormat = 1;
+  pcmParam.byteOrder = BYTEORDER_LE;
+  pcmParam.memOrga = MEMORGA_INTERLV;
+  // the length is only known in advance for files with a Xing/Info header,
+  // otherwise it is left at 0 and no length estimate is derived from it
+  pcmParam.nBlocks = (mp3data.nsamp > 0) ? (long)mp3data.nsamp : 0;
+  return 1;
+}
+
+int cMp3Source::configureWriter(sDmLevelConfig &c)
+{
+  if (!readMp3Header()) COMP_ERR("failed decoding the first frame of file '%s'! Maybe this is not an MP3 file?",filename);
+  if (pcmParam.nChan < 1 || pcmParam.nChan > 2) COMP_ERR("unsupported number of channels (%i) in mp3 file '%s'",pcmParam.nChan,filename);
+
+  if (nullptr != setWaveHeaderCB)
+    setWaveHeaderCB(getCompMan(), pcmParam);
+
+  c.T = 1.0 / (double)(pcmParam.sampleRate);
+  return 1;
+}
+
+int cMp3Source::myConfigureInstance()
+{
+  if (filehandle == nullptr) 
+  {
+    filehandle = fopen_speech(filename, "rb");
+    if (filehandle == nullptr) COMP_ERR("failed to open input file '%s'",filename);
+  }
+  if (hip == nullptr) {
+    hip = hip_decode_init();
+    if (hip == nullptr) COMP_ERR("failed to initialise the mp3 decoder");
+  }
+  if (mp3Buf == nullptr) {
+    mp3Buf = (unsigned char *)malloc(sizeof(unsigned char) * MP3SOURCE_BUFSIZE);
+    pcmL = (short *)malloc(sizeof(short) * MP3SOURCE_BUFSIZE);
+    pcmR = (short *)malloc(sizeof(short) * MP3SOURCE_BUFSIZE);
+  }
+
+  int ret = cDataSource::myConfigureInstance();
+  
+  if (!ret) {
+    fclose(filehandle); filehandle = nullptr;
+  }
+  return ret;
+}
+
+int cMp3Source::setupNewNames(long nEl) 
+{
+  if (monoMixdown) {
+    writer_->addField(outFieldName,1);
+  } else {
+    writer_->addField(outFieldName,pcmParam.nChan);
+  }
+
+  namesAreSet_ = 1;
+  return 1;
+}
+
+int cMp3Source::myTick(long long t)
+{
+  if (isEOI()) {
+    if (!eof) {
+      SMILE_IERR(1, "Processing aborted before all data was read from the input mp3 file! There must be something wrong with your config, e.g. a dataReader blocking a dataMemory level. Look for level full error messages in the debug mode output!");
+    }
+    return 0;
+  }
+  if (eof) return 0;
+
+  long nChan = monoMixdown ? 1 : pcmParam.nChan;
+  if (mat_ == nullptr) allocMat(nChan, blocksizeW_);
+  if (!writer_->checkWrite(blocksizeW_)) return 0;
+
+  // fill one block from the decoded mp3 frames
+  mat_->nT = blocksizeW_;
+  FLOAT_DMEM *d = mat_->dataF;
+  long nRead = 0;
+  while (nRead < blocksizeW_) {
+    if (pcmStart >= pcmEnd) {
+      mp3data_struct mp3data;
+      int n = decodeFrame(&mp3data);
+      if (n < 0) {
+        SMILE_IERR(1,"decoding error in mp3 file '%s' at sample %ld, ignoring the rest of the file",filename,curReadPos + nRead);
+      }
+      if (n <= 0) { eof = 1; break; }
+      pcmStart = 0;
+      pcmEnd = n;
+    }
+    long n = pcmEnd - pcmStart;
+    if (n > blocksizeW_ - nRead) n = blocksizeW_ - nRead;
+    const short *l = pcmL + pcmStart;
+    const short *r = pcmR + pcmStart;
+    if (pcmParam.nChan == 1) {
+      for (long i = 0; i < n; i++) d[i] = (FLOAT_DMEM)l[i] / (FLOAT_DMEM)32767.0;
+      d += n;
+    } else if (monoMixdown) {
+      for (long i = 0; i < n; i++) d[i] = ((FLOAT_DMEM)l[i] + (FLOAT_DMEM)r[i]) / (FLOAT_DMEM)(2.0 * 32767.0);
+      d += n;
+    } else {
+      for (long i = 0; i < n; i++) {
+        d[2*i] = (FLOAT_DMEM)l[i] / (FLOAT_DMEM)32767.0;
+        d[2*i+1] = (FLOAT_DMEM)r[i] / (FLOAT_DMEM)32767.0;
+      }
+      d += 2*n;
+    }
+    pcmStart += n;
+    nRead += n;
+  }
+  if (nRead == 0) return 0;
+
+  mat_->nT = nRead;
+  curReadPos += nRead;
+  if (nullptr != setWaveSamplesCB)
+    setWaveSamplesCB(getCompMan(), mat_->dataF, nRead, nChan);
+  if (!writer_->setNextMatrix(mat_)) {
+    SMILE_IERR(1, "can't write, level full... (strange, level space was checked using checkWrite(bs=%i))", blocksizeW_);
+    return 0;
+  }
+  return 1;
+}
+
+cMp3Source::~cMp3Source()
+{
+  if (hip != nullptr) hip_decode_exit(hip);
+  if (filehandle != nullptr) fclose(filehandle);
+  if (mp3Buf != nullptr) free(mp3Buf);
+  if (pcmL != nullptr) free(pcmL);
+  if (pcmR != nullptr) free(pcmR);
+}
+
+#endif // HAVE_MPGLIB
@@ -113,9 +113,15 @@ cWaveSource::cWaveSource(const char *_name) :
   curReadPos(0),  
   //buffersize(2000),
   eof(0),
-  setWaveHeaderCB(nullptr)
+#if FLOAT_DMEM_NUM != FLOAT_DMEM_FLOAT
+  convBuf(nullptr),
+  convBufSize(0),
+#endif
+  setWaveHeaderCB(nullptr),
+  setWaveSamplesCB(nullptr)
 {
-  // ...
+  pcmReadBuf.raw = nullptr;
+  pcmReadBuf.size = 0;
 }
 
 void cWaveSource::connectSetWaveHeaderCB(SetWaveHeaderCB_Ptr setWaveHeaderCB_)
@@ -123,6 +129,11 @@ void cWaveSource::connectSetWaveHeaderCB(SetWaveHeaderCB_Ptr setWaveHeaderCB_)
   setWaveHeaderCB = setWaveHeaderCB_;
 }
 
+void cWaveSource::connectSetWaveSamplesCB(SetWaveSamplesCB_Ptr setWaveSamplesCB_)
+{
+  setWaveSamplesCB = setWaveSamplesCB_;
+}
+
 void cWaveSource::fetchConfig()
 {
   cDataSource::fetchConfig();
@@ -346,6 +357,10 @@ int cWaveSource::myTick(long long t)
 cWaveSource::~cWaveSource()
 {
   if (filehandle != nullptr) fclose(filehandle);
+  smilePcm_freeReadBuffer(&pcmReadBuf);
+#if FLOAT_DMEM_NUM != FLOAT_DMEM_FLOAT
+  if (convBuf != nullptr) free(convBuf);
+#endif
 }
 
 //--------------------------------------------------  wave specific
@@ -388,16 +403,17 @@ int cWaveSource::readData(cMatrix *m)
   // if they match, convert with smilePcm_readSamples();
   long nRead = 0;
 #if FLOAT_DMEM_NUM == FLOAT_DMEM_FLOAT
-  nRead = smilePcm_readSamples(&filehandle, &pcmParam, m->dataF, nChan, samplesToRead, monoMixdown);
+  nRead = smilePcm_readSamplesBuffered(&filehandle, &pcmParam, m->dataF, nChan, samplesToRead, monoMixdown, &pcmReadBuf);
 #else
-  // TODO: allocate only once, put variable in class object
-  float * a = (float *)malloc(sizeof(float) * m->nT);
-  nRead = smilePcm_readSamples(&filehandle, &pcmParam, a, nChan, samplesToRead, monoMixdown);
+  if (convBufSize < nChan * m->nT) {
+    convBufSize = nChan * m->nT;
+    convBuf = (float *)realloc(convBuf, sizeof(float) * convBufSize);
+  }
+  nRead = smilePcm_readSamplesBuffered(&filehandle, &pcmParam, convBuf, nChan, samplesToRead, monoMixdown, &pcmReadBuf);
   // convert to matrix
-  for (long i = 0; i < nRead && i < m->nT; i++) {
-    m->dataF[i] = (FLOAT_DMEM)a[i];
+  for (long i = 0; i < nRead * nChan && i < m->nT * m->N; i++) {
+    m->dataF[i] = (FLOAT_DMEM)convBuf[i];
   }
-  free(a);
 #endif
   if (nRead != blocksizeW_ || nRead < 0) {
     SMILE_IWRN(5,"nRead (%i) < size to read (%i) ==> assuming EOF!", nRead, blocksizeW_);
@@ -410,6 +426,8 @@ int cWaveSource::readData(cMatrix *m)
   }
   if (nRead > 0) {
     curReadPos += nRead;
+    if (nullptr != setWaveSamplesCB)
+      setWaveSamplesCB(getCompMan(), m->dataF, nRead, nChan);
   }
   return (nRead > 0);
 }
@@ -0,0 +1,484 @@
+/*F***************************************************************************
+ * 
+ * openSMILE - the Munich open source Multimedia Interpretation by 
+ * Large-scale Extraction toolkit
+ * 
+ * This file is part of openSMILE.
+ * 
+ * openSMILE is copyright (c) by audEERING GmbH. All rights reserved.
+ * 
+ * See file "COPYING" for details on usage rights and licensing terms.
+ * By using, copying, editing, compiling, modifying, reading, etc. this
+ * file, you agree to the licensing terms in the file COPYING.
+ * If you do not agree to the licensing terms,
+ * you must immediately destroy all copies of this file.
+ * 
+ * THIS SOFTWARE COMES "AS IS", WITH NO WARRANTIES. THIS MEANS NO EXPRESS,
+ * IMPLIED OR STATUTORY WARRANTY, INCLUDING WITHOUT LIMITATION, WARRANTIES OF
+ * MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE, ANY WARRANTY AGAINST
+ * INTERFERENCE WITH YOUR ENJOYMENT OF THE SOFTWARE OR ANY WARRANTY OF TITLE
+ * OR NON-INFRINGEMENT. THERE IS NO WARRANTY THAT THIS SOFTWARE WILL FULFILL
+ * ANY OF YOUR PARTICULAR PURPOSES OR NEEDS. ALSO, YOU MUST PASS THIS
+ * DISCLAIMER ON WHENEVER YOU DISTRIBUTE THE SOFTWARE OR DERIVATIVE WORKS.
+ * NEITHER TUM NOR ANY CONTRIBUTOR TO THE SOFTWARE WILL BE LIABLE FOR ANY
+ * DAMAGES RELATED TO THE SOFTWARE OR THIS LICENSE AGREEMENT, INCLUDING
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL OR INCIDENTAL DAMAGES, TO THE
+ * MAXIMUM EXTENT THE LAW PERMITS, NO MATTER WHAT LEGAL THEORY IT IS BASED ON.
+ * ALSO, YOU MUST PASS THIS LIMITATION OF LIABILITY ON WHENEVER YOU DISTRIBUTE
+ * THE SOFTWARE OR DERIVATIVE WORKS.
+ * 
+ * Main authors: Florian Eyben, Felix Weninger, 
+ * 	      Martin Woellmer, Bjoern Schuller
+ * 
+ * Copyright (c) 2008-2013, 
+ *   Institute for Human-Machine Communication,
+ *   Technische Universitaet Muenchen, Germany
+ * 
+ * Copyright (c) 2013-2015, 
+ *   audEERING UG (haftungsbeschraenkt),
+ *   Gilching, Germany
+ * 
+ * Copyright (c) 2016,	 
+ *   audEERING GmbH,
+ *   Gilching Germany
+ ***************************************************************************E*/
+
+
+/*  smilePcmConvert
+    ===============
+
+conversion of raw PCM samples to float samples, see smilePcmConvert.h
+
+*/
+
+#include <string.h>
+#include <smileutil/smilePcmConvert.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SMILEPCM_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled for the avx2 target only and selected at runtime
+#if defined(SMILEPCM_HAVE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)) || defined(__clang__))
+#define SMILEPCM_HAVE_AVX2
+#include <immintrin.h>
+#define SMILEPCM_AVX2_FN __attribute__((target("avx2")))
+#endif
+
+// divisors of the integer formats (as they were always used by smilePcm_convertSamples)
+#define SMILEPCM_SCALE_S8   ((float)127.0)
+#define SMILEPCM_SCALE_S16  ((float)32767.0)
+#define SMILEPCM_SCALE_S24  ((float)(32767.0*256.0))
+#define SMILEPCM_SCALE_S32  ((float)(32767.0*32767.0*2.0))
+
+int smilePcm_formatBytes(int fmt)
+{
+  switch (fmt) {
+    case SMILEPCM_S8:      return 1;
+    case SMILEPCM_S16:     return 2;
+    case SMILEPCM_S24:     return 3;
+    case SMILEPCM_S24IN32: return 4;
+    case SMILEPCM_S32:     return 4;
+    case SMILEPCM_F32:     return 4;
+  }
+  return 0;
+}
+
+static float pcmScale(int fmt)
+{
+  switch (fmt) {
+    case SMILEPCM_S8:      return SMILEPCM_SCALE_S8;
+    case SMILEPCM_S16:     return SMILEPCM_SCALE_S16;
+    case SMILEPCM_S24:     return SMILEPCM_SCALE_S24;
+    case SMILEPCM_S24IN32: return SMILEPCM_SCALE_S24;
+    case SMILEPCM_S32:     return SMILEPCM_SCALE_S32;
+  }
+  return 1.0f;
+}
+
+// value of sample i in src, not scaled
+static inline float pcmValue(const uint8_t *src, int fmt, long i)
+{
+  switch (fmt) {
+    case SMILEPCM_S8:
+      return (float)((const int8_t *)src)[i];
+    case SMILEPCM_S16: {
+      int16_t v;
+      memcpy(&v, src + 2*i, sizeof(v));
+      return (float)v;
+    }
+    case SMILEPCM_S24: {
+      const uint8_t *p = src + 3*i;
+      uint32_t u = ((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24);
+      return (float)((int32_t)u >> 8);
+    }
+    case SMILEPCM_S24IN32: {
+      int32_t v;
+      memcpy(&v, src + 4*i, sizeof(v));
+      return (float)(v >> 8);
+    }
+    case SMILEPCM_S32: {
+      int32_t v;
+      memcpy(&v, src + 4*i, sizeof(v));
+      return (float)v;
+    }
+    case SMILEPCM_F32: {
+      float v;
+      memcpy(&v, src + 4*i, sizeof(v));
+      return v;
+    }
+  }
+  return 0.0f;
+}
+
+#ifdef SMILEPCM_HAVE_SSE2
+
+// 8 int16 values in w to float
+static inline void pcmStore8Sse2(float *dst, __m128i w, __m128 s)
+{
+  __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16);
+  __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16);
+  _mm_storeu_ps(dst, _mm_div_ps(_mm_cvtepi32_ps(lo), s));
+  _mm_storeu_ps(dst + 4, _mm_div_ps(_mm_cvtepi32_ps(hi), s));
+}
+
+// even (left) and odd (right) 32-bit values of 2 stereo frames in a and b each
+static inline __m128 pcmEvenSse2(__m128 a, __m128 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)); }
+static inline __m128 pcmOddSse2(__m128 a, __m128 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)); }
+
+// returns the number of samples converted, the rest is left to the scalar code
+static long pcmInterleavedSse2(const uint8_t *src, int fmt, float *dst, long n, float scale)
+{
+  const __m128 s = _mm_set1_ps(scale);
+  long i = 0;
+  switch (fmt) {
+    case SMILEPCM_S8:
+      for ( ; i + 16 <= n; i += 16) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        pcmStore8Sse2(dst + i, _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8), s);
+        pcmStore8Sse2(dst + i + 8, _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8), s);
+      }
+      break;
+    case SMILEPCM_S16:
+      for ( ; i + 8 <= n; i += 8) {
+        pcmStore8Sse2(dst + i, _mm_loadu_si128((const __m128i *)(src + 2*i)), s);
+      }
+      break;
+    case SMILEPCM_S24IN32:
+      for ( ; i + 4 <= n; i += 4) {
+        __m128i v = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(src + 4*i)), 8);
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(v), s));
+      }
+      break;
+    case SMILEPCM_S32:
+      for ( ; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 4*i));
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(v), s));
+      }
+      break;
+  }
+  return i;
+}
+
+// loads 4 stereo frames of 32-bit samples as float (not scaled) into the left and right channel
+static inline void pcmLoadStereo32Sse2(const uint8_t *p, int fmt, __m128 *l, __m128 *r)
+{
+  __m128i a = _mm_loadu_si128((const __m128i *)p);
+  __m128i b = _mm_loadu_si128((const __m128i *)(p + 16));
+  if (fmt == SMILEPCM_F32) {
+    *l = pcmEvenSse2(_mm_castsi128_ps(a), _mm_castsi128_ps(b));
+    *r = pcmOddSse2(_mm_castsi128_ps(a), _mm_castsi128_ps(b));
+    return;
+  }
+  if (fmt == SMILEPCM_S24IN32) {
+    a = _mm_srai_epi32(a, 8);
+    b = _mm_srai_epi32(b, 8);
+  }
+  *l = _mm_cvtepi32_ps(_mm_castps_si128(pcmEvenSse2(_mm_castsi128_ps(a), _mm_castsi128_ps(b))));
+  *r = _mm_cvtepi32_ps(_mm_castps_si128(pcmOddSse2(_mm_castsi128_ps(a), _mm_castsi128_ps(b))));
+}
+
+static long pcmMixdownStereoSse2(const uint8_t *src, int fmt, float *dst, long nFrames, float scale)
+{
+  const __m128 s = _mm_set1_ps(scale);
+  const __m128 two = _mm_set1_ps(2.0f);
+  long i = 0;
+  switch (fmt) {
+    case SMILEPCM_S16: {
+      // the integer sum of two 16-bit samples is exact as float, as is the sum of their float values
+      const __m128i ones = _mm_set1_epi16(1);
+      for ( ; i + 4 <= nFrames; i += 4) {
+        __m128i w = _mm_loadu_si128((const __m128i *)(src + 4*i));
+        __m128 sum = _mm_cvtepi32_ps(_mm_madd_epi16(w, ones));
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_div_ps(sum, two), s));
+      }
+      break;
+    }
+    case SMILEPCM_S24IN32:
+    case SMILEPCM_S32:
+    case SMILEPCM_F32:
+      for ( ; i + 4 <= nFrames; i += 4) {
+        __m128 l, r;
+        pcmLoadStereo32Sse2(src + 8*i, fmt, &l, &r);
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_div_ps(_mm_add_ps(l, r), two), s));
+      }
+      break;
+  }
+  return i;
+}
+
+static long pcmDeinterleaveStereoSse2(const uint8_t *src, int fmt, float *dl, float *dr, long nFrames, float scale)
+{
+  const __m128 s = _mm_set1_ps(scale);
+  long i = 0;
+  switch (fmt) {
+    case SMILEPCM_S16:
+      for ( ; i + 4 <= nFrames; i += 4) {
+        __m128i w = _mm_loadu_si128((const __m128i *)(src + 4*i));
+        __m128i l = _mm_srai_epi32(_mm_slli_epi32(w, 16), 16);
+        __m128i r = _mm_srai_epi32(w, 16);
+        _mm_storeu_ps(dl + i, _mm_div_ps(_mm_cvtepi32_ps(l), s));
+        _mm_storeu_ps(dr + i, _mm_div_ps(_mm_cvtepi32_ps(r), s));
+      }
+      break;
+    case SMILEPCM_S24IN32:
+    case SMILEPCM_S32:
+    case SMILEPCM_F32:
+      for ( ; i + 4 <= nFrames; i += 4) {
+        __m128 l, r;
+        pcmLoadStereo32Sse2(src + 8*i, fmt, &l, &r);
+        _mm_storeu_ps(dl + i, _mm_div_ps(l, s));
+        _mm_storeu_ps(dr + i, _mm_div_ps(r, s));
+      }
+      break;
+  }
+  return i;
+}
+
+#endif  // SMILEPCM_HAVE_SSE2
+
+#ifdef SMILEPCM_HAVE_AVX2
+
+// set once when the library is loaded, before any thread can convert samples
+static int pcmHaveAvx2 = 0;
+
+__attribute__((constructor))
+static void pcmInitCpu(void)
+{
+  __builtin_cpu_init();
+  pcmHaveAvx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+}
+
+// bytes read by pcmLoad8Avx2 (the packed 24-bit load reads 4 bytes beyond the 8 samples)
+static inline int pcmLoad8BytesAvx2(int fmt)
+{
+  return (fmt == SMILEPCM_S24) ? 28 : 8 * smilePcm_formatBytes(fmt);
+}
+
+// 8 consecutive samples at p as 32-bit integers (F32: the raw bits), not scaled
+SMILEPCM_AVX2_FN
+static inline __m256i pcmLoad8Avx2(const uint8_t *p, int fmt)
+{
+  switch (fmt) {
+    case SMILEPCM_S8:
+      return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)p));
+    case SMILEPCM_S16:
+      return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p));
+    case SMILEPCM_S24: {
+      // 4 samples (12 bytes) per 16 byte lane, moved to the upper 3 bytes of each 32-bit word
+      const __m256i shuf = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+      __m128i lo = _mm_loadu_si128((const __m128i *)p);
+      __m128i hi = _mm_loadu_si128((const __m128i *)(p + 12));
+      __m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+      return _mm256_srai_epi32(_mm256_shuffle_epi8(b, shuf), 8);
+    }
+    case SMILEPCM_S24IN32:
+      return _mm256_srai_epi32(_mm256_loadu_si256((const __m256i *)p), 8);
+  }
+  return _mm256_loadu_si256((const __m256i *)p);  // S32, F32
+}
+
+// 8 samples at p as float, not scaled
+SMILEPCM_AVX2_FN
+static inline __m256 pcmLoad8PsAvx2(const uint8_t *p, int fmt)
+{
+  __m256i v = pcmLoad8Avx2(p, fmt);
+  if (fmt == SMILEPCM_F32) return _mm256_castsi256_ps(v);
+  return _mm256_cvtepi32_ps(v);
+}
+
+// even (left) and odd (right) values of the 8 stereo frames in a and b, in frame order
+SMILEPCM_AVX2_FN
+static inline __m256 pcmEvenAvx2(__m256 a, __m256 b)
+{
+  __m256 e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+  return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e), _MM_SHUFFLE(3,1,2,0)));
+}
+SMILEPCM_AVX2_FN
+static inline __m256 pcmOddAvx2(__m256 a, __m256 b)
+{
+  __m256 o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+  return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o), _MM_SHUFFLE(3,1,2,0)));
+}
+
+SMILEPCM_AVX2_FN
+static long pcmInterleavedAvx2(const uint8_t *src, int fmt, float *dst, long n, float scale)
+{
+  const __m256 s = _mm256_set1_ps(scale);
+  const long bytes = smilePcm_formatBytes(fmt);
+  const long rd = pcmLoad8BytesAvx2(fmt);
+  long i = 0;
+  for ( ; i * bytes + rd <= n * bytes; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_div_ps(pcmLoad8PsAvx2(src + i*bytes, fmt), s));
+  }
+  return i;
+}
+
+// loads 8 stereo frames at p as float (not scaled) into the left and right channel
+SMILEPCM_AVX2_FN
+static inline void pcmLoadStereoAvx2(const uint8_t *p, int fmt, long bytes, __m256 *l, __m256 *r)
+{
+  __m256 a = pcmLoad8PsAvx2(p, fmt);
+  __m256 b = pcmLoad8PsAvx2(p + 8*bytes, fmt);
+  *l = pcmEvenAvx2(a, b);
+  *r = pcmOddAvx2(a, b);
+}
+
+SMILEPCM_AVX2_FN
+static long pcmMixdownStereoAvx2(const uint8_t *src, int fmt, float *dst, long nFrames, float scale)
+{
+  const __m256 s = _mm256_set1_ps(scale);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const long bytes = smilePcm_formatBytes(fmt);
+  const long rd = pcmLoad8BytesAvx2(fmt);
+  long i = 0;
+  for ( ; (2*i + 8) * bytes + rd <= 2 * nFrames * bytes; i += 8) {
+    __m256 l, r;
+    pcmLoadStereoAvx2(src + 2*i*bytes, fmt, bytes, &l, &r);
+    _mm256_storeu_ps(dst + i, _mm256_div_ps(_mm256_div_ps(_mm256_add_ps(l, r), two), s));
+  }
+  return i;
+}
+
+SMILEPCM_AVX2_FN
+static long pcmDeinterleaveStereoAvx2(const uint8_t *src, int fmt, float *dl, float *dr, long nFrames, float scale)
+{
+  const __m256 s = _mm256_set1_ps(scale);
+  const long bytes = smilePcm_formatBytes(fmt);
+  const long rd = pcmLoad8BytesAvx2(fmt);
+  long i = 0;
+  for ( ; (2*i + 8) * bytes + rd <= 2 * nFrames * bytes; i += 8) {
+    __m256 l, r;
+    pcmLoadStereoAvx2(src + 2*i*bytes, fmt, bytes, &l, &r);
+    _mm256_storeu_ps(dl + i, _mm256_div_ps(l, s));
+    _mm256_storeu_ps(dr + i, _mm256_div_ps(r, s));
+  }
+  return i;
+}
+
+#endif  // SMILEPCM_HAVE_AVX2
+
+// highest instruction set the kernels may use, see smilePcm_setSimdLevel
+static int pcmSimdLimit = SMILEPCM_SIMD_AVX2;
+
+int smilePcm_setSimdLevel(int level)
+{
+  int old = pcmSimdLimit;
+  pcmSimdLimit = level;
+  return old;
+}
+
+int smilePcm_simdLevel(void)
+{
+#ifdef SMILEPCM_HAVE_AVX2
+  if (pcmSimdLimit >= SMILEPCM_SIMD_AVX2 && pcmHaveAvx2) return SMILEPCM_SIMD_AVX2;
+#endif
+#ifdef SMILEPCM_HAVE_SSE2
+  if (pcmSimdLimit >= SMILEPCM_SIMD_SSE2) return SMILEPCM_SIMD_SSE2;
+#endif
+  return SMILEPCM_SIMD_NONE;
+}
+
+void smilePcm_convertInterleaved(const uint8_t *src, int fmt, float *dst, long n)
+{
+  long i = 0;
+  int level;
+  float scale;
+  if (fmt == SMILEPCM_F32) {
+    memcpy(dst, src, n * sizeof(float));
+    return;
+  }
+  scale = pcmScale(fmt);
+  level = smilePcm_simdLevel();
+#ifdef SMILEPCM_HAVE_AVX2
+  if (level == SMILEPCM_SIMD_AVX2)
+    i = pcmInterleavedAvx2(src, fmt, dst, n, scale);
+#endif
+#ifdef SMILEPCM_HAVE_SSE2
+  if (level == SMILEPCM_SIMD_SSE2)
+    i = pcmInterleavedSse2(src, fmt, dst, n, scale);
+#endif
+  for ( ; i < n; i++) {
+    dst[i] = pcmValue(src, fmt, i) / scale;
+  }
+}
+
+void smilePcm_convertDeinterleaved(const uint8_t *src, int fmt, int nChan, float **dst, long nFrames)
+{
+  long i = 0;
+  int c, level;
+  float scale;
+  if (nChan == 1) {
+    smilePcm_convertInterleaved(src, fmt, dst[0], nFrames);
+    return;
+  }
+  scale = pcmScale(fmt);
+  level = (nChan == 2) ? smilePcm_simdLevel() : SMILEPCM_SIMD_NONE;
+#ifdef SMILEPCM_HAVE_AVX2
+  if (level == SMILEPCM_SIMD_AVX2)
+    i = pcmDeinterleaveStereoAvx2(src, fmt, dst[0], dst[1], nFrames, scale);
+#endif
+#ifdef SMILEPCM_HAVE_SSE2
+  if (level == SMILEPCM_SIMD_SSE2)
+    i = pcmDeinterleaveStereoSse2(src, fmt, dst[0], dst[1], nFrames, scale);
+#endif
+  for ( ; i < nFrames; i++) {
+    for (c = 0; c < nChan; c++) {
+      dst[c][i] = pcmValue(src, fmt, i*nChan + c) / scale;
+    }
+  }
+}
+
+void smilePcm_convertMixdown(const uint8_t *src, int fmt, int nChan, float *dst, long nFrames)
+{
+  long i = 0;
+  int c, level;
+  float scale, fn;
+  if (nChan == 1) {
+    smilePcm_convertInterleaved(src, fmt, dst, nFrames);
+    return;
+  }
+  scale = pcmScale(fmt);
+  fn = (float)nChan;
+  level = (nChan == 2) ? smilePcm_simdLevel() : SMILEPCM_SIMD_NONE;
+#ifdef SMILEPCM_HAVE_AVX2
+  if (level == SMILEPCM_SIMD_AVX2)
+    i = pcmMixdownStereoAvx2(src, fmt, dst, nFrames, scale);
+#endif
+#ifdef SMILEPCM_HAVE_SSE2
+  if (level == SMILEPCM_SIMD_SSE2)
+    i = pcmMixdownStereoSse2(src, fmt, dst, nFrames, scale);
+#endif
+  // channels are summed in order, then divided by the number of channels and the scale
+  for ( ; i < nFrames; i++) {
+    float tmp = 0.0f;
+    for (c = 0; c < nChan; c++) {
+      tmp += pcmValue(src, fmt, i*nChan + c);
+    }
+    dst[i] = (tmp / fn) / scale;
+  }
+}
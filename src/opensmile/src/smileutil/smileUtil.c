@@ -61,6 +61,7 @@ Smile Util:
 //--------------------
 
 #include <smileutil/smileUtil.h>
+#include <smileutil/smilePcmConvert.h>
 #include <string.h>
 
 #include "core/smileTypes.hpp"
@@ -2380,139 +2381,68 @@ int smilePcm_parseWaveHeader(void *raw, long long N, sWaveParameters *pcmParam)
 }
 
 
-// Converts integer PCM sample values to float sample values in [-1,+1].
+// sample format of the conversion kernels (smilePcmConvert.h) for the given wave parameters
+int smilePcm_sampleFormat(const sWaveParameters *pcmParam)
+{
+  switch(pcmParam->nBPS) {
+    case 1: return SMILEPCM_S8;
+    case 2: return SMILEPCM_S16;
+    case 3: return SMILEPCM_S24;
+    case 4: // 32-bit float, 32-bit int or 24-bit int in 4 bytes
+      if (pcmParam->audioFormat == 3) return SMILEPCM_F32;
+      if (pcmParam->nBits == 24) return SMILEPCM_S24IN32;
+      if (pcmParam->nBits == 32) return SMILEPCM_S32;
+      break;
+  }
+  return SMILEPCM_UNKNOWN;
+}
+
+// Converts PCM sample values to float sample values in [-1,+1].
 // nChan is the number of channels allocated in *a.
-// Requires nBits, nBPS, and nChan in pcmParam
+// Requires nBits, nBPS, audioFormat and nChan in pcmParam
 int smilePcm_convertSamples(uint8_t *buf, sWaveParameters *pcmParam, float *a, int nChan, int nSamples, int monoMixdown)
 {
-  int i,c;
-  #define smilePcm_setFMatrix(xx_a,xx_nChan,xx_c,xx_s,xx_val) xx_a[xx_nChan * xx_s + xx_c] = xx_val;
-
-  int8_t *b8=(int8_t*)buf;
-  uint8_t *bu8=(uint8_t*)buf;
-  int16_t *b16 = (int16_t*)buf;
-  int32_t *b32 = (int32_t*)buf;
+  int fmt;
 
   if (a==NULL) return 0;
   if (pcmParam==NULL) return 0;
   if (buf==NULL) return 0;
 
+  fmt = smilePcm_sampleFormat(pcmParam);
+  if (fmt == SMILEPCM_UNKNOWN) {
+    Rprintf("smilePcm: readData: cannot convert unknown sample format to float! (nBPS=%i, nBits=%i)",pcmParam->nBPS,pcmParam->nBits);
+    return 0;
+  }
+
   // TODO: add selectChannel option to select a single channel from multi-channel instead of monoMixdown
   if (monoMixdown) {
-    switch(pcmParam->nBPS) {
-      case 1: // 8-bit int
-        for (i=0; i<nSamples; i++) {
-          float tmp = 0.0;
-          for (c=0; c<pcmParam->nChan; c++) {
-            tmp += (float)b8[i*pcmParam->nChan+c];
-          }
-          smilePcm_setFMatrix(a,nChan,0,i,(tmp/(float)pcmParam->nChan)/(float)127.0);
-        }
-        break;
-      case 2: // 16-bit int
-        for (i=0; i<nSamples; i++) {
-          float tmp = 0.0;
-          for (c=0; c<pcmParam->nChan; c++) {
-            tmp += (float)b16[i*pcmParam->nChan+c];
-          }
-          smilePcm_setFMatrix(a,nChan,0,i,(tmp/(float)pcmParam->nChan)/(float)32767.0);
-        }
-        break;
-      case 3: // 24-bit int
-        for (i=0; i<nSamples; i++) {
-          float tmp = 0.0;
-          for (c=0; c<pcmParam->nChan; c++) {
-            // the only known file with 3bytes was exported by matlab
-            // a byte order conversion was necessary here.. is that always the case?? FIXME!
-            uint32_t is=0;
-            int32_t * iis;
-            is |= (uint32_t)(bu8[(i*pcmParam->nChan+c)*3])<<8;
-            is |= (uint32_t)(bu8[(i*pcmParam->nChan+c)*3+1])<<16;
-            is |= (uint32_t)(bu8[(i*pcmParam->nChan+c)*3+2])<<24;
-            iis = (int32_t*)&is;
-            tmp += (float)(*iis >> 8);
-          }
-          smilePcm_setFMatrix(a,nChan,0,i,(tmp/(float)pcmParam->nChan)/(float)(32767.0*256.0));
-        }
-        break;
-      case 4: // 32-bit int or 24-bit packed int
-        if (pcmParam->nBits == 24) {
-          for (i=0; i<nSamples; i++) {
-            float tmp = 0.0;
-            for (c=0; c<pcmParam->nChan; c++) {
-              tmp += (float)(b32[i*pcmParam->nChan+c]&0xFFFFFF);
-            }
-            smilePcm_setFMatrix(a,nChan,0,i,(tmp/(float)pcmParam->nChan)/(float)(32767.0*256.0));
-          }
-        } else if (pcmParam->nBits == 32) {
-          for (i=0; i<nSamples; i++) {
-            float tmp = 0.0;
-            for (c=0; c<pcmParam->nChan; c++) {
-              tmp += (float)(b32[i*pcmParam->nChan+c]);
-            }
-            smilePcm_setFMatrix(a,nChan,0,i,(tmp/(float)pcmParam->nChan)/(float)(32767.0*32767.0*2.0));
-          }
-        }
-        break;
-      default:
-        Rprintf("smilePcm: readData: cannot convert unknown sample format to float! (nBPS=%i, nBits=%i)",pcmParam->nBPS,pcmParam->nBits);
-        
-        break;
+    smilePcm_convertMixdown(buf, fmt, pcmParam->nChan, a, nSamples);
+    if (nChan > 1) {
+      // the mixdown goes to the first channel of each sample
+      int i;
+      for (i=nSamples-1; i>0; i--) a[i*nChan] = a[i];
     }
-
   } else { // no mixdown, multi-channel matrix output
     if (nChan != pcmParam->nChan) {
       Rprintf( "ERROR: smilePcm: if not using monomixdown option, the number of channels in the wave file (pcmData.nChan) must match the number of channels in the data matrix (nChan)!\n");
       return 0;
     }
-    switch(pcmParam->nBPS) {
-      case 1: // 8-bit int
-        for (i=0; i<nSamples; i++) for (c=0; c<pcmParam->nChan && c < nChan; c++) {
-          smilePcm_setFMatrix(a,nChan,c,i,((float)b8[i*pcmParam->nChan+c])/(float)127.0);
-        } break;
-      case 2: // 16-bit int
-        for (i=0; i<nSamples; i++) for (c=0; c<pcmParam->nChan && c < nChan; c++) {
-          smilePcm_setFMatrix(a,nChan,c,i,((float)b16[i*pcmParam->nChan+c])/(float)32767.0);
-        } break;
-      case 3: // 24-bit int
-        for (i=0; i<nSamples; i++) {
-            float tmp = 0.0;
-            for (c=0; c<pcmParam->nChan && c < nChan; c++) {
-              // the only known file with 3bytes was exported by matlab
-              // a byte order conversion was necessary here.. is that always the case?? FIXME!
-              uint32_t is=0;
-              int32_t * iis;
-              is |= (uint32_t)(bu8[(i*pcmParam->nChan+c)*3])<<8;
-              is |= (uint32_t)(bu8[(i*pcmParam->nChan+c)*3+1])<<16;
-              is |= (uint32_t)(bu8[(i*pcmParam->nChan+c)*3+2])<<24;
-              iis = (int32_t*)&is;
-              tmp = (float)(*iis >> 8);
-              smilePcm_setFMatrix(a,nChan,c,i,(tmp)/(float)(32767.0*256.0));
-            }
-          }
-        break;
-      case 4: // 32-bit int or 24-bit packed int
-        if (pcmParam->nBits == 24) {
-          for (i=0; i<nSamples; i++) for (c=0; c<pcmParam->nChan && c < nChan; c++) {
-            smilePcm_setFMatrix(a,nChan,c,i,((float)(b32[i*pcmParam->nChan+c]&0xFFFFFF))/(float)(32767.0*32767.0*2.0));
-          } break;
-        } else if (pcmParam->nBits == 32) {
-          for (i=0; i<nSamples; i++) for (c=0; c<pcmParam->nChan && c < nChan; c++) {
-            smilePcm_setFMatrix(a,nChan,c,i,((float)b32[i*pcmParam->nChan+c])/(float)(32767.0*32767.0*2.0));
-          } break;
-        }
-
-      default:
-        Rprintf("smilePcm: readData: cannot convert unknown sample format to float! (nBPS=%i, nBits=%i)",pcmParam->nBPS,pcmParam->nBits);
-        
-    }
+    smilePcm_convertInterleaved(buf, fmt, a, (long)nSamples * nChan);
   }
   return nSamples;
 }
 
+void smilePcm_freeReadBuffer(sSmilePcmReadBuffer *rb)
+{
+  if (rb == NULL) return;
+  if (rb->raw != NULL) free(rb->raw);
+  rb->raw = NULL;
+  rb->size = 0;
+}
+
 // Reads pcm data from a filehandle and converts it to float array with value range -1 to +1.
 // Return value: -1 eof, 0 error, > 0 , num samples read
-int smilePcm_readSamples(FILE **filehandle, sWaveParameters *pcmParam, float *a, int nChan, int nSamples, int monoMixdown)
+int smilePcm_readSamplesBuffered(FILE **filehandle, sWaveParameters *pcmParam, float *a, int nChan, int nSamples, int monoMixdown, sSmilePcmReadBuffer *rb)
 {
   // reads data into matix m, size is determined by m, also performs format conversion to float samples and matrix format
   int bs, nRead;
@@ -2522,13 +2452,19 @@ int smilePcm_readSamples(FILE **filehandle, sWaveParameters *pcmParam, float *a,
   if (*filehandle==NULL) return 0;
   if (a==NULL) return 0;
   if (pcmParam==NULL) return 0;
+  if (rb==NULL) return 0;
   if (feof(*filehandle)) {
     return -1;
   }
 
   bs = pcmParam->blockSize * nSamples;
-  buf = (uint8_t *)malloc(bs);
-  if (buf==NULL) return 0;
+  if (rb->size < bs) {
+    buf = (uint8_t *)realloc(rb->raw, bs);
+    if (buf==NULL) return 0;
+    rb->raw = buf;
+    rb->size = bs;
+  }
+  buf = rb->raw;
 
   nRead = (int)fread(buf, 1, bs, *filehandle);
   if (nRead != bs) {
@@ -2539,10 +2475,17 @@ int smilePcm_readSamples(FILE **filehandle, sWaveParameters *pcmParam, float *a,
   if (nRead > 0) {
     nSamples = smilePcm_convertSamples(buf, pcmParam, a, nChan, nSamples, monoMixdown);
   }
-  free(buf);
   return nSamples;
 }
 
+int smilePcm_readSamples(FILE **filehandle, sWaveParameters *pcmParam, float *a, int nChan, int nSamples, int monoMixdown)
+{
+  sSmilePcmReadBuffer rb = { NULL, 0 };
+  int ret = smilePcm_readSamplesBuffered(filehandle, pcmParam, a, nChan, nSamples, monoMixdown, &rb);
+  smilePcm_freeReadBuffer(&rb);
+  return ret;
+}
+
 #if 0 // old version
 //return : -1 eof, 0 error, > 0 , num samples read
 int smilePcm_readSamples(FILE **filehandle, sWaveParameters *pcmParam, float *a, int nChan, int nSamples, int monoMixdown)
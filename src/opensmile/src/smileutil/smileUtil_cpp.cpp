@@ -98,8 +98,10 @@ int smilePcm_readWaveHeader(FILE *filehandle, sWaveParameters *pcmParam, const c
         {
           wave.audioFormat = swap_endian<uint16_t>(wave.audioFormat);
         }
+        // 3 = IEEE float (32-bit samples only, see smilePcm_sampleFormat)
         if (0 != wave.audioFormat && 
-            1 != wave.audioFormat) 
+            1 != wave.audioFormat &&
+            3 != wave.audioFormat) 
         {
           Rprintf("smilePcm: Error reading wave header, not supported audio format = %d. Filename - '%s'!",wave.audioFormat, filename);
           return 0;
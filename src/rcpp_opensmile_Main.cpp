@@ -6,6 +6,11 @@
 #include <core/configManager.hpp>
 #include <core/commandlineParser.hpp>
 #include <core/componentManager.hpp>
+#include <core/dataMemory.hpp>
+#include <core/smileLogger.hpp>
+#include <smileutil/smilePcmConvert.h>
+#include <dspcore/fftBatch.hpp>
+#include <dspcore/fftXg.h>
 
 #include "crcppdatabase.h"
 #include "crcppwav.h"
@@ -14,6 +19,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <algorithm>
+#include <cmath>
+#include <thread>
+#include <random>
 
 #include "lame.h"
 #include "id3.h"
@@ -89,12 +97,10 @@ void wavToMp3(std::string wav_file_in, std::string mp3_file_out)
     {
       CRcppWave::Errors error = CRcppWave::parseWavFile_sh_int(wav_file_in, header, rawData);  
     
-      if(CRcppWave::StereoError == error)
-        throw std::string("Error parsing file. Unsupported file format: stereo channels");
-      else if(CRcppWave::HeaderParseError == error)
+      if(CRcppWave::HeaderParseError == error)
         throw std::string("Error parsing file header");  
       else if(CRcppWave::PcmError == error)
-        throw std::string("Error parsing file. Unsupported file format: float data");  
+        throw std::string("Error parsing file. Unsupported sample format");  
       else if(CRcppWave::FileNotOpenError == error)
         throw std::string("Error parsing file. Can not open file - " + wav_file_in);      
       else if(CRcppWave::NoError != error)
@@ -367,12 +373,10 @@ SEXP rcpp_parseWavFile(std::string strWavfile)
   CRcppWave::Errors error = CRcppWave::parseWavFile(strWavfile, header, rawData);  
   if(CRcppWave::NoError == error)
     return Rcpp::List::create(header, rawData);  
-  else if(CRcppWave::StereoError == error)
-    Rcpp::stop("Error parsing file. Unsupported file format: stereo channels");
   else if(CRcppWave::HeaderParseError == error)
     Rcpp::stop("Error parsing file header");  
   else if(CRcppWave::PcmError == error)
-    Rcpp::stop("Error parsing file. Unsupported file format: float data");  
+    Rcpp::stop("Error parsing file. Unsupported sample format");  
   else if(CRcppWave::FileNotOpenError == error)
     Rcpp::stop("Error parsing file. Can not open file - " + strWavfile);      
   else
@@ -399,10 +403,8 @@ SEXP test_rcpp_playWavFile(std::string strWavfile)
   std::vector<int32_t> rawData;
   sWaveParameters header;
   CRcppWave::Errors error = CRcppWave::parseWavFile(strWavfile, header, rawData);  
-  if(CRcppWave::StereoError == error)
-    Rcpp::stop("Error parsing file. Unsupported file format: stereo channels");
-  else if(CRcppWave::PcmError == error)
-    Rcpp::stop("Error parsing file. Unsupported file format: float data");  
+  if(CRcppWave::PcmError == error)
+    Rcpp::stop("Error parsing file. Unsupported sample format");  
   else if(CRcppWave::FileNotOpenError == error)
     Rcpp::stop("Error parsing file. Can not open file - " + strWavfile);      
   else if(CRcppWave::HeaderParseError == error)
@@ -436,15 +438,12 @@ void test_rcpp_writeWavFile(std::string  filePathIn, std::string  filePathOut)
   std::vector<int32_t> rawData;
   sWaveParameters header;
   CRcppWave::Errors error = CRcppWave::parseWavFile(filePathIn, header, rawData);
-  header.nChan = 1;
   header.nBPS = 4;
   header.nBits = 32;
   header.sampleRate = 44100;
   header.blockSize = header.nChan * header.nBPS;
-  if(CRcppWave::StereoError == error)
-    Rcpp::stop("Error parsing file. Unsupported file format: stereo channels");
-  else if(CRcppWave::PcmError == error)
-    Rcpp::stop("Error parsing file. Unsupported file format: float data");  
+  if(CRcppWave::PcmError == error)
+    Rcpp::stop("Error parsing file. Unsupported sample format");  
   else if(CRcppWave::FileNotOpenError == error)
     Rcpp::stop("Error parsing file. Can not open file - " + filePathIn);      
   else if(CRcppWave::HeaderParseError == error)
@@ -453,9 +452,140 @@ void test_rcpp_writeWavFile(std::string  filePathIn, std::string  filePathOut)
   return   CRcppWave::saveToWaveFile(filePathOut, rawData, header);
 }
 
+// collect per-file features, timestamps and headers of a finished run
+static void addFeaturesToList(std::vector <arma::mat> & rcpp_audio_features,
+                              const std::vector <arma::rowvec> & rcpp_audio_timestamps,
+                              const std::vector <sWaveParameters> & rcpp_wave_header,
+                              Rcpp::List & result)
+{
+  for(int i=0; i<rcpp_audio_features.size(); i++)
+  {
+    {
+      std::string name = "audio_features_" + std::to_string(i);
+      result[name.c_str()] =  rcpp_audio_features[i];
+      //the R copy is the only one kept, free the native matrix right away
+      rcpp_audio_features[i].reset();
+    }
+    {
+      std::string name = "audio_timestamps_" + std::to_string(i);
+      result[name.c_str()] =  rcpp_audio_timestamps[i];
+    }
+    {
+      std::string name = "wave_header_" + std::to_string(i);
+      result[name.c_str()] =  rcpp_wave_header[i];
+    }         
+  }
+}
+
+static void addFeaturesToList(CRcppWave & rcppWave, Rcpp::List & result)
+{
+  std::vector <arma::mat> rcpp_audio_features;
+  std::vector <arma::rowvec> rcpp_audio_timestamps;
+  std::vector <sWaveParameters> rcpp_wave_header;     
+  rcppWave.getOutputData( rcpp_audio_features,
+                          rcpp_audio_timestamps, 
+                          rcpp_wave_header);
+  addFeaturesToList(rcpp_audio_features, rcpp_audio_timestamps, rcpp_wave_header, result);
+}
+
+// offsets (0-based) and lengths of the samples of every feature frame in the first channel of the raw data,
+// the frames are cut at multiples of the frame step, as the R code did before with split()
+static void frameSampleOffsets(const arma::rowvec & timestamps, long sampleRate, long nSamples,
+                               Rcpp::IntegerVector & offsets, Rcpp::IntegerVector & lengths)
+{
+  long nFrames = timestamps.n_elem;
+  offsets = Rcpp::IntegerVector(nFrames);
+  lengths = Rcpp::IntegerVector(nFrames);
+  double step = nFrames > 1 ? (timestamps[1] - timestamps[0]) * sampleRate : (double)nSamples;
+  long start = 0;
+  for(long i=0; i<nFrames; i++)
+  {
+    long end = std::min(nSamples, (long)std::floor((i+1)*step + 1e-6));
+    if(end < start)
+      end = start;
+    offsets[i] = start;
+    lengths[i] = end - start;
+    start = end;
+  }
+}
+
+// collect per-file turn borders (from cTurnDetector) of a finished run
+static void addBorderFramesToList(CRcppWave & rcppWave, Rcpp::List & result)
+{
+  std::vector <arma::rowvec> rcpp_border_frame_starts;
+  std::vector <arma::rowvec> rcpp_border_frame_ends;     
+  rcppWave.getBorderFrames( rcpp_border_frame_starts,
+                            rcpp_border_frame_ends);
+  for(int i=0; i<rcpp_border_frame_starts.size(); i++)
+  {
+    {
+      std::string name = "border_frames_starts_" + std::to_string(i);
+      result[name.c_str()] =  rcpp_border_frame_starts[i];
+    }
+    {
+      std::string name = "border_frames_ends_" + std::to_string(i);
+      result[name.c_str()] =  rcpp_border_frame_ends[i];
+    }
+  }
+}
+
+static bool readConfigString(const std::string & config_file_in, std::string & config_string_out)
+{
+  std::ifstream stream;
+  stream.open(config_file_in, std::ifstream::binary);
+  if(!stream.is_open())
+    return false;
+  stream.seekg (0, stream.end);
+  config_string_out.reserve(stream.tellg());
+  stream.seekg (0, stream.beg);
+  
+  config_string_out.assign((std::istreambuf_iterator<char>(stream)),
+                           std::istreambuf_iterator<char>());
+  stream.close();
+  return true;
+}
+
+// nChunks > 1 splits long wave files into that many time ranges (padded by the context of the frames),
+// with nWorkers > 1 the ranges of a single file are processed concurrently
 // [[Rcpp::export]]
 SEXP rcpp_openSmileGetFeatures(std::vector<std::string> audio_files_in, 
-                          std::string config_string_in)
+                          std::string config_string_in,
+                          int nWorkers = 1,
+                          int nChunks = 1)
+{
+  setlocale(LC_ALL, " ");
+  
+  //tilda handling  
+  for(int i=0; i<audio_files_in.size(); i++)
+  {
+    audio_files_in[i] = tildaString(audio_files_in[i]);  
+  }
+  
+  Rcpp::List result;
+  try { 
+    CRcppWave rcppWave;      
+    rcppWave.setNumWorkers(nWorkers);
+    rcppWave.setNumChunks(nChunks);
+    if(rcppWave.setInputData(audio_files_in, config_string_in))
+    {
+      rcppWave.work();
+      addFeaturesToList(rcppWave, result);
+    }
+  }
+  catch (const std::bad_alloc& e) 
+  {
+    Rcpp::stop("Allocation failed: " + std::string(e.what()));
+  }
+  return result;
+}
+
+// features and the samples of every feature frame from a single decode of each file:
+// raw_data_<i> holds the samples read by cWaveSource (int32 full scale, channel after channel), frame j of file i
+// are the samples raw_offsets_<i>[j] + 1 ... raw_offsets_<i>[j] + raw_lengths_<i>[j] of raw_data_<i>
+// [[Rcpp::export]]
+SEXP rcpp_openSmileGetFeatures_RawData(std::vector<std::string> audio_files_in, 
+                                       std::string config_string_in,
+                                       int nWorkers = 1)
 {
   setlocale(LC_ALL, " ");
   
@@ -468,29 +598,37 @@ SEXP rcpp_openSmileGetFeatures(std::vector<std::string> audio_files_in,
   Rcpp::List result;
   try { 
     CRcppWave rcppWave;      
-    if(rcppWave.setInputData(audio_files_in, config_string_in));
+    rcppWave.setNumWorkers(nWorkers);
+    rcppWave.setKeepSamples(true);
+    if(rcppWave.setInputData(audio_files_in, config_string_in))
     {
       rcppWave.work();
       std::vector <arma::mat> rcpp_audio_features;
       std::vector <arma::rowvec> rcpp_audio_timestamps;
       std::vector <sWaveParameters> rcpp_wave_header;     
-      rcppWave.getOutputData( rcpp_audio_features,
-                              rcpp_audio_timestamps, 
-                              rcpp_wave_header);
-      for(int i=0; i<rcpp_audio_features.size(); i++)
+      std::vector <std::vector<int32_t>> rcpp_raw_samples;
+      std::vector <long> rcpp_raw_nChan;
+      rcppWave.getOutputData(rcpp_audio_features, rcpp_audio_timestamps, rcpp_wave_header);
+      rcppWave.getRawSamples(rcpp_raw_samples, rcpp_raw_nChan);
+      addFeaturesToList(rcpp_audio_features, rcpp_audio_timestamps, rcpp_wave_header, result);
+      for(int i=0; i<rcpp_raw_samples.size(); i++)
       {
+        Rcpp::IntegerVector offsets, lengths;
+        long nSamples = (long)rcpp_raw_samples[i].size() / std::max(1L, rcpp_raw_nChan[i]);
+        frameSampleOffsets(rcpp_audio_timestamps[i], rcpp_wave_header[i].sampleRate, nSamples, offsets, lengths);
         {
-          std::string name = "audio_features_" + std::to_string(i);
-          result[name.c_str()] =  rcpp_audio_features[i];
+          std::string name = "raw_data_" + std::to_string(i);
+          result[name.c_str()] = Rcpp::IntegerVector(rcpp_raw_samples[i].begin(), rcpp_raw_samples[i].end());
+          std::vector<int32_t>().swap(rcpp_raw_samples[i]);
         }
         {
-          std::string name = "audio_timestamps_" + std::to_string(i);
-          result[name.c_str()] =  rcpp_audio_timestamps[i];
+          std::string name = "raw_offsets_" + std::to_string(i);
+          result[name.c_str()] = offsets;
         }
         {
-          std::string name = "wave_header_" + std::to_string(i);
-          result[name.c_str()] =  rcpp_wave_header[i];
-        }         
+          std::string name = "raw_lengths_" + std::to_string(i);
+          result[name.c_str()] = lengths;
+        }
       }
     }
   }
@@ -517,20 +655,8 @@ SEXP test_rcpp_openSmileGetFeatures(std::vector<std::string> audio_files_in,
   
   Rcpp::List result;  
   std::string config_string_in;
-  
-  std::ifstream stream;
-  stream.open(config_file_in, std::ifstream::binary);
-  if(stream.is_open())
-  {
-    stream.seekg (0, stream.end);
-    config_string_in.reserve(stream.tellg());
-    stream.seekg (0, stream.beg);
-    
-    config_string_in.assign((std::istreambuf_iterator<char>(stream)),
-                  std::istreambuf_iterator<char>());
-    stream.close();  
+  if(readConfigString(config_file_in, config_string_in))
     result = rcpp_openSmileGetFeatures(audio_files_in, config_string_in);    
-  }
   
   return result;
 }
@@ -538,7 +664,8 @@ SEXP test_rcpp_openSmileGetFeatures(std::vector<std::string> audio_files_in,
 
 // [[Rcpp::export]]
 SEXP  rcpp_openSmileGetBorderFrames(std::vector<std::string> audio_files_in, 
-                              std::string config_string_in)
+                              std::string config_string_in,
+                              int nWorkers = 1)
 {
   setlocale(LC_ALL, " ");
   
@@ -551,24 +678,11 @@ SEXP  rcpp_openSmileGetBorderFrames(std::vector<std::string> audio_files_in,
   Rcpp::List result;
   try { 
     CRcppWave rcppWave;      
-    if(rcppWave.setInputData(audio_files_in, config_string_in));
+    rcppWave.setNumWorkers(nWorkers);
+    if(rcppWave.setInputData(audio_files_in, config_string_in))
     {
       rcppWave.work();
-      std::vector <arma::rowvec> rcpp_border_frame_starts;
-      std::vector <arma::rowvec> rcpp_border_frame_ends;     
-      rcppWave.getBorderFrames( rcpp_border_frame_starts,
-                                rcpp_border_frame_ends);
-      for(int i=0; i<rcpp_border_frame_starts.size(); i++)
-      {
-        {
-          std::string name = "border_frames_starts_" + std::to_string(i);
-          result[name.c_str()] =  rcpp_border_frame_starts[i];
-        }
-        {
-          std::string name = "border_frames_ends_" + std::to_string(i);
-          result[name.c_str()] =  rcpp_border_frame_ends[i];
-        }
-      }
+      addBorderFramesToList(rcppWave, result);
     }
   }
   catch (const std::bad_alloc& e) 
@@ -593,21 +707,8 @@ SEXP test_rcpp_openSmileGetBorderFrames(std::vector<std::string> audio_files_in,
   
   Rcpp::List result;  
   std::string config_string_in;
-    
-  std::ifstream stream;
-  stream.open(config_file_in, std::ifstream::binary);
-  if(stream.is_open())
-  {
-    stream.seekg (0, stream.end);
-    config_string_in.reserve(stream.tellg());
-    stream.seekg (0, stream.beg);
-    
-    config_string_in.assign((std::istreambuf_iterator<char>(stream)),
-                            std::istreambuf_iterator<char>());
-    stream.close();  
+  if(readConfigString(config_file_in, config_string_in))
     result =  rcpp_openSmileGetBorderFrames(audio_files_in, config_string_in);    
-  }
-  
  
   return result;
 }
@@ -623,7 +724,8 @@ SEXP  rcpp_openSmileMain(std::vector<std::string> arguments)
 
 // [[Rcpp::export]]
 SEXP rcpp_openSmileGetFeatures_Turns(std::vector<std::string> audio_files_in, 
-                                     std::string config_string_in)
+                                     std::string config_string_in,
+                                     int nWorkers = 1)
 {
   setlocale(LC_ALL, " ");
   
@@ -633,8 +735,23 @@ SEXP rcpp_openSmileGetFeatures_Turns(std::vector<std::string> audio_files_in,
     audio_files_in[i] = tildaString(audio_files_in[i]);  
   }  
   
-  Rcpp::List features = rcpp_openSmileGetFeatures(audio_files_in, config_string_in);
-  Rcpp::List turns = rcpp_openSmileGetBorderFrames(audio_files_in, config_string_in);
+  //features and turn borders are collected during the same run (see CRcppWave::getData1file)
+  Rcpp::List features;
+  Rcpp::List turns;
+  try { 
+    CRcppWave rcppWave;      
+    rcppWave.setNumWorkers(nWorkers);
+    if(rcppWave.setInputData(audio_files_in, config_string_in))
+    {
+      rcppWave.work();
+      addFeaturesToList(rcppWave, features);
+      addBorderFramesToList(rcppWave, turns);
+    }
+  }
+  catch (const std::bad_alloc& e) 
+  {
+    Rcpp::stop("Allocation failed: " + std::string(e.what()));
+  }
   return Rcpp::List::create(features, turns);
 }
 
@@ -651,7 +768,318 @@ SEXP test_rcpp_openSmileGetFeatures_Turns(std::vector<std::string> audio_files_i
     audio_files_in[i] = tildaString(audio_files_in[i]);  
   }  
   
-  Rcpp::List features = test_rcpp_openSmileGetFeatures(audio_files_in, config_file_in);
-  Rcpp::List turns = test_rcpp_openSmileGetBorderFrames(audio_files_in, config_file_in);
-  return Rcpp::List::create(features, turns);  
-}
\ No newline at end of file
+  std::string config_string_in;
+  if(!readConfigString(config_file_in, config_string_in))
+    return Rcpp::List::create(Rcpp::List(), Rcpp::List());
+  return rcpp_openSmileGetFeatures_Turns(audio_files_in, config_string_in);  
+}
+
+// [[Rcpp::export]]
+SEXP test_rcpp_configManagerIndex()
+{
+  // instances refer to the type, so it has to outlive the config manager
+  ConfigType type("testType");
+  type.setField("x", "test field", 0);
+
+  Rcpp::List result;
+  {
+    cConfigManager confman;
+    const char *names[] = { "a", "b", "c", "b" };
+    for (int i = 0; i < 4; i++) {
+      ConfigInstance *inst = new ConfigInstance(names[i], &type, 0);
+      inst->setInt("x", i + 1);
+      confman.addInstance(inst);
+    }
+    // the first of two instances with the same name is found
+    result["dup_b"] = confman.getInt("b.x");
+
+    // field handles: unknown instances and fields give invalid handles, no errors
+    ConfigField cx = confman.getField("c.x");
+    result["handles"] = Rcpp::IntegerVector::create(
+      Rcpp::Named("c.x") = cx.isValid() ? cx.getInt() : -1,
+      Rcpp::Named("c.y") = confman.getField("c.y").isValid(),
+      Rcpp::Named("e.x") = confman.getField("e.x").isValid(),
+      Rcpp::Named("c") = confman.getField("c").isValid());
+    long nChanges = confman.getNInstChanges();
+
+    confman.deleteInstance("b");
+    // instance "c" moved down, the handle still points to it
+    result["handle_after_delete"] = cx.getInt();
+    result["changes_after_delete"] = confman.getNInstChanges() - nChanges;
+    result["after_delete"] = Rcpp::IntegerVector::create(
+      Rcpp::Named("a") = confman.findInstance("a"),
+      Rcpp::Named("b") = confman.findInstance("b"),
+      Rcpp::Named("c") = confman.findInstance("c"));
+    result["values"] = Rcpp::IntegerVector::create(
+      Rcpp::Named("a") = confman.getInt("a.x"),
+      Rcpp::Named("b") = confman.getInt("b.x"),
+      Rcpp::Named("c") = confman.getInt("c.x"));
+
+    confman.deleteInstance("b");
+    ConfigInstance *d = new ConfigInstance("d", &type, 0);
+    d->setInt("x", 5);
+    result["added"] = confman.addInstance(d);
+    result["after_add"] = Rcpp::IntegerVector::create(
+      Rcpp::Named("a") = confman.findInstance("a"),
+      Rcpp::Named("b") = confman.findInstance("b"),
+      Rcpp::Named("c") = confman.findInstance("c"),
+      Rcpp::Named("d") = confman.findInstance("d"));
+    result["d"] = confman.getInt("d.x");
+  }
+  return result;
+}
+
+// [[Rcpp::export]]
+void test_rcpp_loggerThreads(std::string logfile, int nThreads, int nMessages)
+{
+  logfile = tildaString(logfile);
+  // messages of the worker threads go through their rings, or are written at once when a ring is full
+  cSmileLogger logger(1, logfile.c_str(), 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nThreads; t++) {
+    threads.emplace_back([&logger, t, nMessages]() {
+      for (int i = 0; i < nMessages; i++)
+        logger.logFmt(LOG_MESSAGE, 0, "loggerTest", 0, "thread %i message %i of %s", t, i, "worker");
+    });
+  }
+  for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+  // the logger writes the remaining messages and closes the file when it goes out of scope
+}
+
+// converts with the kernels limited to level, layout 0: interleaved, 1: deinterleaved, 2: mixdown;
+// the output is followed by a few guard values that must stay unchanged
+static std::vector<float> pcmConvertLayout(const std::vector<uint8_t> &src, int fmt, int nChan,
+                                           long nFrames, int layout, int level)
+{
+  const int guard = 8;
+  long n = (layout == 2) ? nFrames : nFrames * nChan;
+  std::vector<float> out(n + guard, 7.0f);
+  smilePcm_setSimdLevel(level);
+  if (layout == 0) {
+    smilePcm_convertInterleaved(src.data(), fmt, out.data(), n);
+  } else if (layout == 1) {
+    std::vector<float *> dst(nChan);
+    for (int c = 0; c < nChan; c++) dst[c] = out.data() + c * nFrames;
+    smilePcm_convertDeinterleaved(src.data(), fmt, nChan, dst.data(), nFrames);
+  } else {
+    smilePcm_convertMixdown(src.data(), fmt, nChan, out.data(), nFrames);
+  }
+  return out;
+}
+
+// [[Rcpp::export]]
+Rcpp::List test_rcpp_pcmConvertSimd()
+{
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> unif(-1.0f, 1.0f);
+  int old = smilePcm_setSimdLevel(SMILEPCM_SIMD_AVX2);
+  int best = smilePcm_simdLevel();
+  int cases = 0, mismatches = 0;
+  for (int fmt = SMILEPCM_S8; fmt <= SMILEPCM_F32; fmt++) {
+    int bytes = smilePcm_formatBytes(fmt);
+    for (int nChan = 1; nChan <= 3; nChan++) {
+      // lengths up to a few vectors, so that every kernel leaves a tail of each length to the scalar code
+      for (long nFrames = 0; nFrames <= 40; nFrames++) {
+        std::vector<uint8_t> src(nFrames * nChan * bytes);
+        if (fmt == SMILEPCM_F32) {
+          for (size_t i = 0; i < src.size() / 4; i++) {
+            float v = unif(rng);
+            memcpy(&src[4 * i], &v, sizeof(v));
+          }
+        } else {
+          for (size_t i = 0; i < src.size(); i++) src[i] = (uint8_t)(rng() & 0xff);
+        }
+        for (int layout = 0; layout < 3; layout++) {
+          std::vector<float> ref = pcmConvertLayout(src, fmt, nChan, nFrames, layout, SMILEPCM_SIMD_NONE);
+          for (int level = SMILEPCM_SIMD_SSE2; level <= best; level++) {
+            cases++;
+            if (pcmConvertLayout(src, fmt, nChan, nFrames, layout, level) != ref) mismatches++;
+          }
+        }
+      }
+    }
+  }
+  smilePcm_setSimdLevel(old);
+  return Rcpp::List::create(Rcpp::Named("simdLevel") = best,
+                            Rcpp::Named("cases") = cases,
+                            Rcpp::Named("mismatches") = mismatches);
+}
+
+// [[Rcpp::export]]
+Rcpp::List test_rcpp_fftBatch()
+{
+  // largest difference between cFftBatch and rdft, relative to the largest rdft output value
+  double fwdErr[2] = { 0.0, 0.0 }, invErr[2] = { 0.0, 0.0 };
+  int cases = 0;
+  std::mt19937 rng(1);
+  std::normal_distribution<float> norm(0.0f, 1.0f);
+  for (long n = 4; n <= 1024; n *= 2) {
+    // rdft computes its tables on the first call (ip[0] == 0)
+    std::vector<int> ip(3 + (size_t)ceil(sqrt((double)n)), 0);
+    std::vector<FLOAT_TYPE_FFT> w(n/2 + 1), x(n);
+    // the frames are shorter than n and zero padded on both sides, strides are not the frame size
+    const long nSrc = n - n/4, padLeft = (n - nSrc) / 2;
+    const long srcStride = nSrc + 1, dstStride = n + 2;
+    for (int single = 0; single <= 1; single++) {
+      cFftBatch batch(n, single);
+      // up to 9 frames, i.e. full and partial groups of SIMD lanes
+      for (long nFrames = 1; nFrames <= 9; nFrames++) {
+        std::vector<FLOAT_DMEM> src(nFrames * srcStride), spec(nFrames * dstStride), inv(nFrames * dstStride);
+        for (size_t i = 0; i < src.size(); i++) src[i] = norm(rng);
+        batch.forward(src.data(), srcStride, nSrc, padLeft, spec.data(), dstStride, nFrames);
+        batch.inverse(spec.data(), dstStride, inv.data(), dstStride, nFrames, (FLOAT_DMEM)2.0 / (FLOAT_DMEM)n);
+        for (long f = 0; f < nFrames; f++) {
+          double maxAbs = 0.0, maxDiff = 0.0;
+          for (long i = 0; i < n; i++) {
+            long t = i - padLeft;
+            x[i] = (t >= 0 && t < nSrc) ? (FLOAT_TYPE_FFT)src[f*srcStride + t] : 0;
+          }
+          rdft((int)n, 1, x.data(), ip.data(), w.data());
+          for (long i = 0; i < n; i++) {
+            maxAbs = std::max(maxAbs, (double)fabs(x[i]));
+            maxDiff = std::max(maxDiff, (double)fabs(x[i] - spec[f*dstStride + i]));
+          }
+          fwdErr[single] = std::max(fwdErr[single], maxDiff / maxAbs);
+
+          // inverse of the batch spectrum, as cTransformFFT computes it
+          for (long i = 0; i < n; i++) x[i] = (FLOAT_TYPE_FFT)spec[f*dstStride + i];
+          rdft((int)n, -1, x.data(), ip.data(), w.data());
+          maxAbs = 0.0; maxDiff = 0.0;
+          for (long i = 0; i < n; i++) {
+            double y = (double)x[i] * 2.0 / (double)n;
+            maxAbs = std::max(maxAbs, fabs(y));
+            maxDiff = std::max(maxDiff, fabs(y - inv[f*dstStride + i]));
+          }
+          invErr[single] = std::max(invErr[single], maxDiff / maxAbs);
+          cases++;
+        }
+      }
+    }
+  }
+  int unsupportedThrows = 0;
+  try {
+    cFftBatch batch(6);
+  } catch (cComponentException &) {
+    unsupportedThrows = 1;
+  }
+  return Rcpp::List::create(Rcpp::Named("cases") = cases,
+                            Rcpp::Named("forwardErrDouble") = fwdErr[0],
+                            Rcpp::Named("forwardErrSingle") = fwdErr[1],
+                            Rcpp::Named("inverseErrDouble") = invErr[0],
+                            Rcpp::Named("inverseErrSingle") = invErr[1],
+                            Rcpp::Named("unsupportedThrows") = unsupportedThrows);
+}
+
+// one writer thread and nReaders reader threads on a ring buffer level, the readers check the data and time meta of
+// every frame they read; with lockFree the level is accessed without its reader/writer locks, with noHang=2 the writer
+// does not wait for the readers and they skip frames which were overwritten
+// [[Rcpp::export]]
+Rcpp::List test_rcpp_dataMemoryThreads(int lockFree, int noHang, int nReaders, int nFrames)
+{
+  const long N = 3, L = 5;  // frame size, window length of the matrix readers
+  sDmLevelConfig cfg("test", 0.0, 0.0, 16L);
+  cfg.noHang = noHang;
+  cDataMemoryLevel level(0, cfg, "test");
+  level.addField("x", (int)N);
+  level.fixateLevel();
+  level.setBlocksizeWriter(4);
+  level.queryReadConfig(L);
+  std::vector<int> rdId(nReaders);
+  for (int r = 0; r < nReaders; r++) rdId[r] = level.registerReader();
+  level.finaliseLevel();
+  level.setLockFree(lockFree);
+  level.allocReaders();
+
+  std::atomic<long> mismatches(0), reads(0);
+  // frame v holds 10*v + j in element j, its time is v+1
+  auto frameOk = [N](const FLOAT_DMEM *x, const TimeMetaInfo *tm, long v) {
+    for (long j = 0; j < N; j++) if (x[j] != (FLOAT_DMEM)(10*v + j)) return false;
+    return (tm->vIdx == v)&&(tm->time == (double)(v + 1));
+  };
+
+  std::vector<std::thread> threads;
+  threads.emplace_back([&level, nFrames, N]() {
+    long v = 0, blk = 0;
+    while (v < nFrames) {
+      long k = std::min(1 + blk % 4, nFrames - v);
+      int ok;
+      if (k == 1) {
+        cVector vec(N);
+        for (long j = 0; j < N; j++) vec.dataF[j] = (FLOAT_DMEM)(10*v + j);
+        vec.tmeta->time = (double)(v + 1);
+        ok = level.setFrame(v, &vec);
+      } else {
+        cMatrix mat(N, k);
+        for (long i = 0; i < k; i++) {
+          for (long j = 0; j < N; j++) mat.dataF[i*N + j] = (FLOAT_DMEM)(10*(v + i) + j);
+          mat.tmeta[i].time = (double)(v + i + 1);
+        }
+        ok = level.setMatrix(v, &mat);
+      }
+      if (!ok) { smileYield(); continue; }  // the level is full
+      v += k;
+      blk++;
+      if (blk % 8 == 0) smileYield();  // let the readers keep up
+      if (blk % 7 == 0) {  // rewrite the last published frame with the same data
+        cVector vec(N);
+        for (long j = 0; j < N; j++) vec.dataF[j] = (FLOAT_DMEM)(10*(v - 1) + j);
+        vec.tmeta->time = (double)v;
+        level.setFrame(v - 1, &vec);
+      }
+    }
+  });
+  for (int r = 0; r < nReaders; r++) {
+    threads.emplace_back([&, r]() {
+      int id = rdId[r];
+      if (r == 0) {
+        // reads the frame at the current read index until the last one
+        for (long last = -1; last < nFrames - 1; ) {
+          cVector *vec = level.getFrame(0, DMEM_IDX_CURR, id);
+          if (vec == nullptr) { smileYield(); continue; }
+          long v = vec->tmeta->vIdx;
+          if ((v <= last)||((noHang != 2)&&(v != last + 1))||(!frameOk(vec->dataF, vec->tmeta, v))) mismatches++;
+          delete vec;
+          reads++;
+          last = v;
+        }
+      } else {
+        // overlapping windows with step r, filled in place
+        cMatrix *mat = nullptr;
+        for (long v = 0; v + L <= nFrames; ) {
+          cMatrix *m = nullptr;
+          if (level.checkRead(v, -1, id, L)) m = level.getMatrix(v, v + L, -1, id, nullptr, mat);
+          if (m == nullptr) {
+            if (v < level.getMinR()) v = level.getMinR();  // overwritten
+            else smileYield();
+            continue;
+          }
+          mat = m;
+          for (long i = 0; i < L; i++)
+            if (!frameOk(mat->dataF + i*N, mat->tmeta + i, v + i)) mismatches++;
+          reads++;
+          if ((r % 2 == 0)&&(v >= 2)) {
+            // look back at frames before the read index, which the writer may overwrite meanwhile (then the read fails)
+            m = level.getMatrix(v - 2, v - 2 + L, -1, id, nullptr, mat);
+            if (m != nullptr) {
+              mat = m;
+              for (long i = 0; i < L; i++)
+                if (!frameOk(mat->dataF + i*N, mat->tmeta + i, v - 2 + i)) mismatches++;
+              reads++;
+            }
+          }
+          v += r;
+        }
+        if (mat != nullptr) delete mat;
+      }
+      // don't keep the writer waiting for frames this reader no longer needs
+      while (level.getCurW() < nFrames) {
+        level.catchupCurR(id);
+        smileYield();
+      }
+    });
+  }
+  for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+  return Rcpp::List::create(Rcpp::Named("written") = (double)level.getCurW(),
+                            Rcpp::Named("reads") = (double)reads,
+                            Rcpp::Named("mismatches") = (double)mismatches);
+}
@@ -0,0 +1,131 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include "io_win32.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool CMappedFile::open(const std::string & filePath)
+{
+  close();
+  std::wstring wPath;
+  if(!io::win32::strings::utf8_to_wcs(filePath.c_str(), &wPath))
+    return false;
+  HANDLE file = CreateFileW(wPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(INVALID_HANDLE_VALUE == file)
+    return false;
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(file, &fileSize))
+  {
+    CloseHandle(file);
+    return false;
+  }
+  hFile = file;
+  length = (size_t)fileSize.QuadPart;
+  opened = true;
+  //a zero length file can not be mapped
+  if(0 == length)
+    return true;
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if(nullptr == mapping)
+  {
+    close();
+    return false;
+  }
+  hMapping = mapping;
+  base = reinterpret_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if(nullptr == base)
+  {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void CMappedFile::close()
+{
+  if(nullptr != base)
+    UnmapViewOfFile(base);
+  if(nullptr != hMapping)
+    CloseHandle(reinterpret_cast<HANDLE>(hMapping));
+  if(nullptr != hFile)
+    CloseHandle(reinterpret_cast<HANDLE>(hFile));
+  base = nullptr;
+  hMapping = nullptr;
+  hFile = nullptr;
+  length = 0;
+  opened = false;
+}
+
+void CMappedFile::release(size_t offset, size_t len)
+{
+  //the view of a read-only mapping is trimmed by the system on demand
+}
+
+#else
+
+bool CMappedFile::open(const std::string & filePath)
+{
+  close();
+  int fd = ::open(filePath.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+  struct stat st;
+  if(0 != fstat(fd, &st))
+  {
+    ::close(fd);
+    return false;
+  }
+  length = (size_t)st.st_size;
+  opened = true;
+  if(0 == length)
+  {
+    ::close(fd);
+    return true;
+  }
+  void * p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  //the mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if(MAP_FAILED == p)
+  {
+    length = 0;
+    opened = false;
+    return false;
+  }
+  base = reinterpret_cast<const uint8_t *>(p);
+  madvise(p, length, MADV_SEQUENTIAL);
+  return true;
+}
+
+void CMappedFile::close()
+{
+  if(nullptr != base)
+    munmap(const_cast<uint8_t *>(base), length);
+  base = nullptr;
+  length = 0;
+  opened = false;
+}
+
+void CMappedFile::release(size_t offset, size_t len)
+{
+  if((nullptr == base) || (offset >= length))
+    return;
+  //madvise needs a page aligned start, keep the partial page in front
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = (offset + pageSize - 1) / pageSize * pageSize;
+  size_t end = std::min(offset + len, length);
+  if(end > start)
+    madvise(const_cast<uint8_t *>(base) + start, end - start, MADV_DONTNEED);
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MappedFile_H
+#define MappedFile_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+//read-only memory mapping of a whole file
+//the pages are loaded on access, consumed ranges can be handed back with release()
+//so that streaming over a large file keeps a bounded resident size
+class CMappedFile
+{
+public:
+  CMappedFile() = default;
+  ~CMappedFile() { close(); }
+  CMappedFile(const CMappedFile &) = delete;
+  CMappedFile & operator=(const CMappedFile &) = delete;
+
+  //returns false if the file can not be opened or mapped (an empty file is mapped with size() == 0)
+  bool open(const std::string & filePath);
+  void close();
+
+  bool isOpen() const { return opened; }
+  const uint8_t * data() const { return base; }
+  size_t size() const { return length; }
+
+  //hint that [offset, offset+len) will not be needed again, the pages may be dropped
+  void release(size_t offset, size_t len);
+
+private:
+  const uint8_t * base {nullptr};
+  size_t length {0};
+  bool opened {false};
+#if defined(_WIN32)
+  void * hFile {nullptr};
+  void * hMapping {nullptr};
+#endif
+};
+
+#endif // MappedFile_H